@@ -0,0 +1,315 @@
+#ifndef FRAME_BROADCASTER_H
+#define FRAME_BROADCASTER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <lwip/sockets.h>
+#include "frame_pool.h"
+#include "mjpeg_stream.h"
+
+#define STREAM_PORT 81
+#ifndef STREAM_MAX_CLIENTS
+#define STREAM_MAX_CLIENTS 6            // Keep below CONFIG_LWIP_MAX_SOCKETS minus the web server's
+#endif
+#define STREAM_STALL_TIMEOUT 10000      // ms a viewer may go without accepting a byte
+#define STREAM_POLL_MS 10
+
+// Every viewer may be part-way through a different old frame while the
+// "/" snapshot holds another; with "latest" and the buffer being
+// captured into that is viewers + 3, and with that many buffers capture
+// never waits on a slow viewer.
+#define STREAM_FRAME_BUFFERS(viewers) ((viewers) + 3)
+
+static_assert(FRAME_POOL_SIZE >= STREAM_FRAME_BUFFERS(STREAM_MAX_CLIENTS),
+              "FRAME_POOL_SIZE too small for STREAM_MAX_CLIENTS: slow viewers could stall capture");
+
+// =================================================================
+// --- MJPEG fan-out to many viewers ---
+// =================================================================
+// One task serves every viewer over non-blocking sockets. Each viewer
+// works through its current frame at whatever pace its connection
+// takes; when it finishes, it picks up the newest frame in the pool,
+// skipping any it was too slow for. A slow viewer therefore costs
+// itself frames and never holds up the others or the capture task.
+//
+// Frames are sent straight out of the pool (see frame_pool.h), so
+// each one is shared by every viewer on it rather than copied.
+class FrameBroadcaster {
+public:
+    explicit FrameBroadcaster(FramePool& pool) : pool(pool), listenFd(-1), limit(STREAM_MAX_CLIENTS), task(nullptr),
+                                                 streaming(0) {
+        for (uint8_t i = 0; i < STREAM_MAX_CLIENTS; i++) {
+            clients[i].fd = -1;
+            clients[i].state = Free;
+            clients[i].frame = nullptr;
+        }
+    }
+
+    // After pool.begin(). Serves at most maxViewers (up to
+    // STREAM_MAX_CLIENTS); the pool needs STREAM_FRAME_BUFFERS(maxViewers).
+    bool begin(uint16_t port = STREAM_PORT, uint8_t maxViewers = STREAM_MAX_CLIENTS, uint8_t core = 0,
+               UBaseType_t priority = 4) {
+        if (maxViewers == 0 || maxViewers > STREAM_MAX_CLIENTS) {
+            return false;
+        }
+        limit = maxViewers;
+        listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (listenFd < 0) {
+            return false;
+        }
+        int one = 1;
+        setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, limit) < 0) {
+            close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        fcntl(listenFd, F_SETFL, O_NONBLOCK);
+        if (xTaskCreatePinnedToCore(run, "stream", 4096, this, priority, &task, core) != pdPASS) {
+            return false;
+        }
+        pool.notify(task);
+        return true;
+    }
+
+    uint8_t viewers() const { return streaming; }
+
+private:
+    enum State : uint8_t {
+        Free,
+        Request,                        // Reading the HTTP request
+        Streaming
+    };
+
+    // One viewer. What it is sending is head + frame + trailer, with
+    // offset counting through all three.
+    struct Client {
+        int fd;
+        State state;
+        uint8_t matched;                // Bytes of the request's closing "\r\n\r\n" seen
+        IPAddress ip;
+        Frame* frame;                   // nullptr for the response header, and between frames
+        uint32_t lastSeq;
+        char head[256];                 // Response header, then each part header
+        uint16_t headLen;
+        uint32_t offset;
+        uint32_t total;
+        uint32_t lastProgress;
+        MjpegStats stats;
+    };
+
+    static void run(void* arg) {
+        static_cast<FrameBroadcaster*>(arg)->serve();
+    }
+
+    void serve() {
+        for (;;) {
+            fd_set readable, writable;
+            FD_ZERO(&readable);
+            FD_ZERO(&writable);
+            FD_SET(listenFd, &readable);
+            int maxFd = listenFd;
+            bool sending = false;
+            for (Client& c : clients) {
+                if (c.state == Free) {
+                    continue;
+                }
+                FD_SET(c.fd, &readable); // The request, or EOF from a viewer that left
+                if (c.state == Streaming && c.offset < c.total) {
+                    FD_SET(c.fd, &writable);
+                    sending = true;
+                }
+                maxFd = max(maxFd, c.fd);
+            }
+
+            timeval timeout = {0, sending ? STREAM_POLL_MS * 1000 : 0};
+            if (select(maxFd + 1, &readable, &writable, nullptr, &timeout) < 0) {
+                vTaskDelay(pdMS_TO_TICKS(STREAM_POLL_MS));
+                continue;
+            }
+            if (FD_ISSET(listenFd, &readable)) {
+                acceptClients();
+            }
+
+            uint32_t now = millis();
+            sending = false;
+            for (Client& c : clients) {
+                if (c.state == Free) {
+                    continue;
+                }
+                if (FD_ISSET(c.fd, &readable) && !receive(c, now)) {
+                    drop(c);
+                    continue;
+                }
+                bool alive = c.state == Streaming ? pump(c, now) : now - c.lastProgress < STREAM_STALL_TIMEOUT;
+                if (!alive) {
+                    drop(c);
+                    continue;
+                }
+                sending |= c.state == Streaming && c.offset < c.total;
+                if (c.state == Streaming && c.stats.roll(now)) {
+                    Serial.printf("Stream %s: %.1f fps, %.1f kB/s, %lu skipped\n", c.ip.toString().c_str(),
+                                  c.stats.fps, c.stats.bytesPerSec / 1024, (unsigned long)c.stats.skipped);
+                }
+            }
+
+            // Everyone is waiting for the next frame: sleep until it's captured
+            if (!sending) {
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STREAM_POLL_MS));
+            }
+        }
+    }
+
+    void acceptClients() {
+        for (;;) {
+            sockaddr_in addr;
+            socklen_t length = sizeof(addr);
+            int fd = accept(listenFd, (sockaddr*)&addr, &length);
+            if (fd < 0) {
+                return;
+            }
+            Client* c = nullptr;
+            for (uint8_t i = 0; i < limit && !c; i++) {
+                if (clients[i].state == Free) {
+                    c = &clients[i];
+                }
+            }
+            if (!c) {
+                static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+                send(fd, busy, sizeof(busy) - 1, MSG_DONTWAIT);
+                close(fd);
+                continue;
+            }
+            int one = 1;
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            c->fd = fd;
+            c->state = Request;
+            c->matched = 0;
+            c->ip = IPAddress(addr.sin_addr.s_addr);
+            c->lastProgress = millis();
+        }
+    }
+
+    // Consumes the request; afterwards only notices the viewer leaving
+    bool receive(Client& c, uint32_t now) {
+        char buffer[128];
+        int n = recv(c.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (n == 0) {
+            return false;
+        }
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        for (int i = 0; i < n && c.state == Request; i++) {
+            bool expected = buffer[i] == ((c.matched % 2) == 0 ? '\r' : '\n');
+            c.matched = expected ? c.matched + 1 : (buffer[i] == '\r' ? 1 : 0);
+            if (c.matched == 4) {
+                startStream(c, now);
+            }
+        }
+        return true;
+    }
+
+    void startStream(Client& c, uint32_t now) {
+        c.state = Streaming;
+        c.frame = nullptr;
+        c.lastSeq = 0;
+        c.headLen = sizeof(MJPEG_RESPONSE_HEADER) - 1;
+        memcpy(c.head, MJPEG_RESPONSE_HEADER, c.headLen);
+        c.offset = 0;
+        c.total = c.headLen;
+        c.lastProgress = now;
+        c.stats.start(now);
+        streaming++;
+        pool.addViewer();
+        Serial.printf("Stream started: %s (%u viewers)\n", c.ip.toString().c_str(), viewers());
+    }
+
+    // Sends until the socket is full. False when the viewer has gone
+    // or stalled.
+    bool pump(Client& c, uint32_t now) {
+        for (;;) {
+            if (c.offset == c.total && !nextFrame(c)) {
+                c.lastProgress = now; // Waiting on the camera isn't a stall
+                return true;
+            }
+            uint32_t bodyLen = c.frame ? c.frame->fb->len : 0;
+            const uint8_t* data;
+            uint32_t length;
+            if (c.offset < c.headLen) {
+                data = (const uint8_t*)c.head + c.offset;
+                length = c.headLen - c.offset;
+            } else if (c.offset < c.headLen + bodyLen) {
+                data = c.frame->fb->buf + (c.offset - c.headLen);
+                length = c.headLen + bodyLen - c.offset;
+            } else {
+                data = (const uint8_t*)MJPEG_PART_TRAILER + (c.offset - c.headLen - bodyLen);
+                length = c.total - c.offset;
+            }
+
+            int sent = send(c.fd, data, min(length, (uint32_t)MJPEG_CHUNK), MSG_DONTWAIT);
+            if (sent < 0) {
+                return (errno == EAGAIN || errno == EWOULDBLOCK) && now - c.lastProgress < STREAM_STALL_TIMEOUT;
+            }
+            c.offset += sent;
+            c.lastProgress = now;
+            if (c.offset == c.total && c.frame) {
+                c.stats.count(c.total);
+                c.lastSeq = c.frame->seq;
+                pool.release(c.frame);
+                c.frame = nullptr;
+            }
+        }
+    }
+
+    // Moves the viewer on to the newest frame, if it hasn't sent it yet
+    bool nextFrame(Client& c) {
+        Frame* frame = pool.acquireLatest();
+        if (!frame) {
+            return false;
+        }
+        if (frame->seq == c.lastSeq) {
+            pool.release(frame);
+            return false;
+        }
+        if (c.lastSeq != 0) {
+            c.stats.skipped += frame->seq - c.lastSeq - 1;
+        }
+        c.frame = frame;
+        c.headLen = mjpegPartHeader(c.head, sizeof(c.head), frame->fb->len);
+        c.offset = 0;
+        c.total = c.headLen + frame->fb->len + sizeof(MJPEG_PART_TRAILER) - 1;
+        return true;
+    }
+
+    void drop(Client& c) {
+        if (c.frame) {
+            pool.release(c.frame);
+            c.frame = nullptr;
+        }
+        close(c.fd);
+        if (c.state == Streaming) {
+            streaming--;
+            pool.removeViewer();
+            Serial.printf("Stream ended: %s, %lu frames (%lu skipped), %llu bytes in %lu s\n",
+                          c.ip.toString().c_str(), (unsigned long)c.stats.frames, (unsigned long)c.stats.skipped,
+                          (unsigned long long)c.stats.bytes, (unsigned long)((millis() - c.stats.startMs) / 1000));
+        }
+        c.fd = -1;
+        c.state = Free;
+    }
+
+    FramePool& pool;
+    int listenFd;
+    uint8_t limit;                      // Viewers served, set by begin()
+    TaskHandle_t task;
+    std::atomic<uint8_t> streaming;
+    Client clients[STREAM_MAX_CLIENTS];
+};
+
+#endif // FRAME_BROADCASTER_H
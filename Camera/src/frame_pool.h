@@ -0,0 +1,184 @@
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_camera.h>
+
+#ifndef FRAME_POOL_SIZE
+#define FRAME_POOL_SIZE 9               // Most camera frame buffers; begin() takes how many there are
+#endif
+
+// =================================================================
+// --- Shared, reference-counted camera frames ---
+// =================================================================
+// One capture task owns the sensor. Each JPEG it grabs stays in the
+// driver's frame buffer and is shared by reference: every client
+// sending it holds a reference, and the buffer goes back to the driver
+// when the last one lets go. Viewers never trigger captures of their
+// own, and a frame is never copied per client.
+//
+// The pool holds "latest" plus whatever older frames slow clients are
+// still sending. Capture would wait only if every buffer were in use;
+// users of the pool size it so that can't happen (one buffer per
+// client that can hold a frame, plus "latest", plus the one being
+// captured - see frame_broadcaster.h). The pool tracks as many buffers
+// as the driver was given (config.fb_count), up to FRAME_POOL_SIZE.
+
+struct Frame {
+    camera_fb_t* fb;                    // nullptr while the slot is free
+    uint32_t seq;
+    uint32_t capturedMs;
+    std::atomic<uint8_t> refs;
+};
+
+class FramePool {
+public:
+    FramePool() : buffers(FRAME_POOL_SIZE), latest(nullptr), seq(0), viewers(0), captured(0), failures(0), freeSlots(nullptr),
+                  task(nullptr), listener(nullptr), lock(portMUX_INITIALIZER_UNLOCKED) {
+        for (uint8_t i = 0; i < FRAME_POOL_SIZE; i++) {
+            slots[i].fb = nullptr;
+            slots[i].refs = 0;
+        }
+    }
+
+    // After esp_camera_init(), with the config.fb_count it was given
+    bool begin(uint8_t fbCount = FRAME_POOL_SIZE, uint8_t core = 1, UBaseType_t priority = 5) {
+        if (fbCount == 0 || fbCount > FRAME_POOL_SIZE) {
+            return false;
+        }
+        buffers = fbCount;
+        freeSlots = xSemaphoreCreateCounting(buffers, buffers);
+        if (freeSlots == nullptr) {
+            return false;
+        }
+        return xTaskCreatePinnedToCore(run, "capture", 4096, this, priority, &task, core) == pdPASS;
+    }
+
+    // Newest frame with a reference taken for the caller, or nullptr.
+    // Every non-null result must be given back with release().
+    Frame* acquireLatest() {
+        portENTER_CRITICAL(&lock);
+        Frame* frame = latest;
+        if (frame) {
+            frame->refs++;
+        }
+        portEXIT_CRITICAL(&lock);
+        return frame;
+    }
+
+    void release(Frame* frame) {
+        if (frame->refs.fetch_sub(1) == 1) {
+            esp_camera_fb_return(frame->fb);
+            frame->fb = nullptr;
+            xSemaphoreGive(freeSlots);
+        }
+    }
+
+    uint32_t latestSeq() {
+        portENTER_CRITICAL(&lock);
+        uint32_t s = latest ? latest->seq : 0;
+        portEXIT_CRITICAL(&lock);
+        return s;
+    }
+
+    // Capture runs continuously while anyone is watching...
+    void addViewer() {
+        if (viewers++ == 0) {
+            xTaskNotifyGive(task);
+        }
+    }
+    void removeViewer() { viewers--; }
+
+    // ... otherwise one frame at a time, on request
+    void request() { xTaskNotifyGive(task); }
+
+    // Newest frame no older than maxAgeMs, capturing one if needed
+    Frame* acquireFresh(uint32_t maxAgeMs, uint32_t timeoutMs = 1000) {
+        Frame* frame = acquireLatest();
+        if (frame && millis() - frame->capturedMs <= maxAgeMs) {
+            return frame;
+        }
+        uint32_t seen = frame ? frame->seq : 0;
+        if (frame) {
+            release(frame);
+        }
+        request();
+        uint32_t start = millis();
+        while (millis() - start < timeoutMs) {
+            vTaskDelay(pdMS_TO_TICKS(5));
+            if (latestSeq() != seen) {
+                return acquireLatest();
+            }
+        }
+        return nullptr;
+    }
+
+    // Task notified after every new frame (the broadcaster)
+    void notify(TaskHandle_t handle) { listener = handle; }
+
+    uint8_t size() const { return buffers; }
+    uint32_t framesCaptured() const { return captured; }
+    uint32_t captureFailures() const { return failures; }
+
+private:
+    static void run(void* arg) {
+        FramePool* self = static_cast<FramePool*>(arg);
+        for (;;) {
+            if (self->viewers == 0) {
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            }
+            xSemaphoreTake(self->freeSlots, portMAX_DELAY);
+            camera_fb_t* fb = esp_camera_fb_get();
+            if (!fb || fb->format != PIXFORMAT_JPEG) {
+                if (fb) {
+                    esp_camera_fb_return(fb);
+                }
+                self->failures++;
+                xSemaphoreGive(self->freeSlots);
+                vTaskDelay(pdMS_TO_TICKS(100));
+                continue;
+            }
+            self->publish(fb);
+        }
+    }
+
+    void publish(camera_fb_t* fb) {
+        Frame* frame = nullptr;
+        for (uint8_t i = 0; i < buffers && !frame; i++) {
+            if (slots[i].fb == nullptr) {
+                frame = &slots[i];
+            }
+        }
+        frame->fb = fb;
+        frame->seq = ++seq;
+        frame->capturedMs = millis();
+        frame->refs = 1; // Held as "latest"
+
+        portENTER_CRITICAL(&lock);
+        Frame* previous = latest;
+        latest = frame;
+        portEXIT_CRITICAL(&lock);
+        if (previous) {
+            release(previous);
+        }
+        captured++;
+        if (listener) {
+            xTaskNotifyGive(listener);
+        }
+    }
+
+    Frame slots[FRAME_POOL_SIZE];
+    uint8_t buffers;
+    Frame* latest;
+    uint32_t seq;
+    std::atomic<int> viewers;
+    uint32_t captured;
+    uint32_t failures;
+    SemaphoreHandle_t freeSlots;
+    TaskHandle_t task;
+    TaskHandle_t listener;
+    portMUX_TYPE lock;
+};
+
+#endif // FRAME_POOL_H
@@ -1,6 +1,10 @@
 #include <WiFi.h>
 #include <esp_camera.h>
 #include <WebServer.h>
+#include <wifi_link.h>
+#include "mjpeg_stream.h"
+#include "frame_pool.h"
+#include "frame_broadcaster.h"
 
 // Replace with your network credentials
 const char *ssid = "JioFiber_401_2.4Gz";
@@ -11,14 +15,22 @@ camera_config_t config;
 
 WebServer server(80);  // Declare the server object globally so it's accessible in both setup() and loop()
 
+// Without PSRAM every frame buffer comes out of internal DRAM (a QVGA
+// JPEG buffer is ~15 KB), so serve a single viewer there
+#define STREAM_CLIENTS_NO_PSRAM 1
+
+// One capture task feeds every viewer: the stream (port 81) and
+// snapshots share its frames instead of each grabbing their own
+FramePool frames;
+FrameBroadcaster broadcaster(frames);
+
 void setup() {
     Serial.begin(9600);
     delay(1000);  // Wait for Serial Monitor to initialize
 
     // Connect to WiFi
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(1000);
+    WiFiLink::getInstance().begin(ssid, password);
+    while (!WiFiLink::getInstance().waitConnected(1000)) {
         Serial.println("Connecting to WiFi...");
     }
     Serial.println("WiFi connected");
@@ -43,40 +55,59 @@ void setup() {
     config.pin_reset = -1;   // No reset pin
     config.pixel_format = PIXFORMAT_JPEG;  // Set JPEG format
     config.frame_size = FRAMESIZE_QVGA;   // Set frame size (QVGA)
-    config.fb_count = 2;  // Double buffering (2 frames)
+    config.grab_mode = CAMERA_GRAB_LATEST;  // Never hand out a stale buffered frame
+
+    // Frame buffers are shared by reference between viewers, one per
+    // viewer that may hold a frame plus a few (see frame_broadcaster.h)
+    bool psram = psramFound();
+    uint8_t viewers = psram ? STREAM_MAX_CLIENTS : STREAM_CLIENTS_NO_PSRAM;
+    config.fb_location = psram ? CAMERA_FB_IN_PSRAM : CAMERA_FB_IN_DRAM;
+    config.fb_count = STREAM_FRAME_BUFFERS(viewers);
 
     // Initialize the camera
     if (esp_camera_init(&config) != ESP_OK) {
         Serial.println("Camera initialization failed");
         while (1);
     }
+    Serial.printf("Camera: %u frame buffers in %s for %u viewers, %u bytes heap free\n", (unsigned)config.fb_count,
+                  psram ? "PSRAM" : "DRAM", (unsigned)viewers, (unsigned)ESP.getFreeHeap());
 
-    // Start the web server for live video streaming
+    if (!frames.begin(config.fb_count) || !broadcaster.begin(STREAM_PORT, viewers)) {
+        Serial.println("Stream setup failed");
+        while (1);
+    }
+
+    // Single snapshot: the newest frame, captured for us only if nobody
+    // is streaming; the JPEG goes out straight from the frame buffer
     server.on("/", HTTP_GET, [&]() {  // Capture 'server' in the lambda
-        camera_fb_t *fb = esp_camera_fb_get();
-        if (!fb) {
+        Frame *frame = frames.acquireFresh(200);
+        if (!frame) {
             server.send(500, "text/plain", "Camera capture failed");
             return;
         }
 
-        // Send the captured image as JPEG
-        if (fb->format == PIXFORMAT_JPEG) {
-            // Convert the buffer to String and send it as content
-            String content = String((char*)fb->buf, fb->len);
-            server.send(200, "image/jpeg", content);  // Send JPEG image content
-        } else {
-            server.send(500, "text/plain", "Unsupported pixel format");
-        }
+        // Headers with the length, then the frame itself - no String copy
+        server.setContentLength(frame->fb->len);
+        server.send(200, "image/jpeg", "");
+        WiFiClient client = server.client();
+        mjpegWriteAll(client, frame->fb->buf, frame->fb->len);
+
+        // Give the frame back to the pool
+        frames.release(frame);
+    });
 
-        // Return the framebuffer to free memory
-        esp_camera_fb_return(fb);
+    // Live video is served by the broadcaster on its own port
+    server.on("/stream", HTTP_GET, [&]() {
+        server.sendHeader("Location", "http://" + WiFi.localIP().toString() + ":" + String(STREAM_PORT) + "/");
+        server.send(302, "text/plain", "");
     });
 
     server.begin();
     Serial.println("Web server started");
+    Serial.printf("Stream: http://%s:%u/\n", WiFi.localIP().toString().c_str(), STREAM_PORT);
 }
 
 void loop() {
-    // Handle incoming HTTP requests (like video streaming)
+    // Snapshots only; streams never hold up this loop
     server.handleClient();
 }
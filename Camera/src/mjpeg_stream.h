@@ -0,0 +1,90 @@
+#ifndef MJPEG_STREAM_H
+#define MJPEG_STREAM_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define MJPEG_BOUNDARY "frame"
+#define MJPEG_CHUNK 4096                // Bytes per socket write
+#define MJPEG_STATS_WINDOW 5000         // ms between fps / throughput updates
+
+// =================================================================
+// --- MJPEG over HTTP (multipart/x-mixed-replace) ---
+// =================================================================
+// Each JPEG goes out as one part straight from the camera's frame
+// buffer - nothing is copied, so peak RAM is the frame buffers the
+// driver already owns. Browsers show the parts as a live video in an
+// <img> tag or on their own.
+
+#define MJPEG_RESPONSE_HEADER                                                   \
+    "HTTP/1.1 200 OK\r\n"                                                       \
+    "Content-Type: multipart/x-mixed-replace;boundary=" MJPEG_BOUNDARY "\r\n"   \
+    "Cache-Control: no-cache, no-store\r\n"                                     \
+    "Pragma: no-cache\r\n"                                                      \
+    "Access-Control-Allow-Origin: *\r\n"                                        \
+    "Connection: close\r\n"                                                     \
+    "\r\n"
+
+#define MJPEG_PART_TRAILER "\r\n"
+
+// Header in front of each JPEG; returns its length
+inline int mjpegPartHeader(char* out, size_t size, size_t jpegLength) {
+    return snprintf(out, size, "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n",
+                    (unsigned)jpegLength);
+}
+
+// Every client gets its own counters
+struct MjpegStats {
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t skipped;                   // Newer frames it was too slow for
+    uint32_t startMs;
+    float fps;                          // Over the last full window
+    float bytesPerSec;
+    uint32_t windowStart;
+    uint32_t windowFrames;
+    uint32_t windowBytes;
+
+    void start(uint32_t nowMs) {
+        *this = MjpegStats();
+        startMs = windowStart = nowMs;
+    }
+
+    void count(size_t partBytes) {
+        frames++;
+        bytes += partBytes;
+        windowFrames++;
+        windowBytes += partBytes;
+    }
+
+    // True when a new window has closed, i.e. fps / bytesPerSec changed
+    bool roll(uint32_t nowMs) {
+        uint32_t elapsed = nowMs - windowStart;
+        if (elapsed < MJPEG_STATS_WINDOW) {
+            return false;
+        }
+        fps = windowFrames * 1000.0f / elapsed;
+        bytesPerSec = windowBytes * 1000.0f / elapsed;
+        windowFrames = 0;
+        windowBytes = 0;
+        windowStart += elapsed;
+        return true;
+    }
+};
+
+// Writes all of data to the client in MJPEG_CHUNK pieces. False once
+// the client has gone (or stopped reading past WiFiClient's timeout).
+inline bool mjpegWriteAll(WiFiClient& client, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        size_t n = length < MJPEG_CHUNK ? length : MJPEG_CHUNK;
+        size_t written = client.write(data, n);
+        if (written == 0) {
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+#endif // MJPEG_STREAM_H
@@ -0,0 +1,173 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// =================================================================
+// --- Just enough of the Arduino core and FreeRTOS for the stream ---
+// =================================================================
+// Tasks are threads and time is the host's real clock, so the capture
+// and stream tasks run concurrently with the test's viewers exactly as
+// they would with the camera and WiFi. Serial output is dropped unless
+// Serial.echo is set.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using std::max;
+using std::min;
+
+inline unsigned long millis() {
+    using namespace std::chrono;
+    static const steady_clock::time_point start = steady_clock::now();
+    return (unsigned long)duration_cast<milliseconds>(steady_clock::now() - start).count();
+}
+inline void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+// -----------------------------------------------------------------
+// FreeRTOS: tasks, notifications, counting semaphores, spinlocks
+// -----------------------------------------------------------------
+typedef unsigned int UBaseType_t;
+typedef int BaseType_t;
+
+#define pdPASS 1
+#define pdTRUE 1
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(ms) (ms)      // 1 ms ticks
+
+inline void vTaskDelay(uint32_t ticks) { delay(ticks); }
+
+struct HostTask {
+    std::mutex m;
+    std::condition_variable cv;
+    uint32_t notifications = 0;
+};
+typedef HostTask* TaskHandle_t;
+
+inline HostTask*& hostCurrentTask() {
+    static thread_local HostTask* current = nullptr;
+    return current;
+}
+
+// Tasks run until the process exits, as they do on the device
+inline BaseType_t xTaskCreatePinnedToCore(void (*code)(void*), const char*, uint32_t, void* arg, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+    HostTask* task = new HostTask;
+    *handle = task;
+    std::thread([code, arg, task] {
+        hostCurrentTask() = task;
+        code(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline void xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> guard(task->m);
+        task->notifications++;
+    }
+    task->cv.notify_one();
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clear, uint32_t ticks) {
+    HostTask* task = hostCurrentTask();
+    std::unique_lock<std::mutex> guard(task->m);
+    auto pending = [task] { return task->notifications > 0; };
+    if (ticks == portMAX_DELAY) {
+        task->cv.wait(guard, pending);
+    } else {
+        task->cv.wait_for(guard, std::chrono::milliseconds(ticks), pending);
+    }
+    uint32_t count = task->notifications;
+    task->notifications = clear ? 0 : (count ? count - 1 : 0);
+    return count;
+}
+
+struct HostSemaphore {
+    std::mutex m;
+    std::condition_variable cv;
+    UBaseType_t count;
+};
+typedef HostSemaphore* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t, UBaseType_t initial) {
+    HostSemaphore* semaphore = new HostSemaphore;
+    semaphore->count = initial;
+    return semaphore;
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, uint32_t ticks) {
+    std::unique_lock<std::mutex> guard(semaphore->m);
+    auto available = [semaphore] { return semaphore->count > 0; };
+    if (ticks == portMAX_DELAY) {
+        semaphore->cv.wait(guard, available);
+    } else if (!semaphore->cv.wait_for(guard, std::chrono::milliseconds(ticks), available)) {
+        return 0;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    {
+        std::lock_guard<std::mutex> guard(semaphore->m);
+        semaphore->count++;
+    }
+    semaphore->cv.notify_one();
+    return pdTRUE;
+}
+
+struct portMUX_TYPE {
+    std::mutex m;
+    portMUX_TYPE(int) {}
+};
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL(mux) (mux)->m.unlock()
+
+// -----------------------------------------------------------------
+// IPAddress / Serial
+// -----------------------------------------------------------------
+class IPAddress {
+public:
+    IPAddress(uint32_t address = 0) : address(address) {}
+    std::string toString() const {
+        in_addr in;
+        in.s_addr = address;
+        return inet_ntoa(in);
+    }
+
+private:
+    uint32_t address;
+};
+
+class HostSerial {
+public:
+    bool echo = false;
+
+    void begin(unsigned long) {}
+    template <typename... Args>
+    void printf(const char* format, Args... args) {
+        if (echo) {
+            ::printf(format, args...);
+            fflush(stdout);
+        }
+    }
+    void println(const char* s) {
+        if (echo) {
+            puts(s);
+        }
+    }
+};
+
+inline HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
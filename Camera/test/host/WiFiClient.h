@@ -0,0 +1,13 @@
+#ifndef HOST_WIFI_CLIENT_H
+#define HOST_WIFI_CLIENT_H
+
+#include <Arduino.h>
+
+// Host build: only mjpegWriteAll() names it, and the broadcaster
+// doesn't use that
+class WiFiClient {
+public:
+    size_t write(const uint8_t*, size_t length) { return length; }
+};
+
+#endif // HOST_WIFI_CLIENT_H
@@ -0,0 +1,60 @@
+#ifndef HOST_ESP_CAMERA_H
+#define HOST_ESP_CAMERA_H
+
+#include <Arduino.h>
+#include <stdlib.h>
+
+// =================================================================
+// --- A camera that produces a frame every frameMs ---
+// =================================================================
+// Frame n is filled with the byte n & 0xFF, so a viewer can tell a
+// frame that arrived whole from one spliced out of two buffers. Lengths
+// cycle through a few sizes, as JPEGs of a changing scene do.
+
+typedef enum {
+    PIXFORMAT_RGB565,
+    PIXFORMAT_JPEG,
+} pixformat_t;
+
+typedef struct {
+    uint8_t* buf;
+    size_t len;
+    size_t width;
+    size_t height;
+    pixformat_t format;
+} camera_fb_t;
+
+struct HostCamera {
+    std::atomic<uint32_t> frameMs{40};  // 25 fps, OV2640 at VGA
+    std::atomic<uint32_t> length{20000};
+    std::atomic<uint32_t> captured{0};
+    std::atomic<int> outstanding{0};    // Buffers not yet given back
+};
+
+inline HostCamera& hostCamera() {
+    static HostCamera camera;
+    return camera;
+}
+
+inline camera_fb_t* esp_camera_fb_get() {
+    HostCamera& camera = hostCamera();
+    delay(camera.frameMs);
+    uint32_t n = camera.captured++;
+    camera_fb_t* fb = new camera_fb_t;
+    fb->len = camera.length + (n % 5) * 1000;
+    fb->buf = (uint8_t*)malloc(fb->len);
+    memset(fb->buf, n & 0xFF, fb->len);
+    fb->width = 640;
+    fb->height = 480;
+    fb->format = PIXFORMAT_JPEG;
+    camera.outstanding++;
+    return fb;
+}
+
+inline void esp_camera_fb_return(camera_fb_t* fb) {
+    free(fb->buf);
+    delete fb;
+    hostCamera().outstanding--;
+}
+
+#endif // HOST_ESP_CAMERA_H
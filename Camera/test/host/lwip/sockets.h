@@ -0,0 +1,28 @@
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+// The host's BSD sockets stand in for lwIP's
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// lwIP's send buffer is a few TCP segments. The host's is megabytes,
+// which would hide a slow viewer behind the kernel; shrink each
+// accepted socket's to match, so backpressure reaches the broadcaster
+// as it does on the device.
+#define HOST_SEND_BUFFER 8192
+
+inline int hostAccept(int fd, sockaddr* address, socklen_t* length) {
+    int client = ::accept(fd, address, length);
+    if (client >= 0) {
+        int size = HOST_SEND_BUFFER;
+        setsockopt(client, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    }
+    return client;
+}
+#define accept hostAccept
+
+#endif // HOST_LWIP_SOCKETS_H
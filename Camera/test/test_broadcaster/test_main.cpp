@@ -0,0 +1,359 @@
+// Host-side tests for the frame pool and MJPEG broadcaster
+// (src/frame_pool.h, src/frame_broadcaster.h): real viewers on
+// loopback sockets against a fake camera (test/host).
+// Run with: pio test -e native
+#include <unity.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "frame_pool.h"
+#include "frame_broadcaster.h"
+
+#define TEST_PORT 18081
+
+static FramePool pool;
+static FrameBroadcaster broadcaster(pool);
+
+static int connectViewer(int receiveBuffer = 0) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (receiveBuffer) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    }
+    timeval timeout = {0, 100000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(TEST_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    static const char request[] = "GET / HTTP/1.1\r\nHost: camera\r\n\r\n";
+    send(fd, request, sizeof(request) - 1, 0);
+    return fd;
+}
+
+// A viewer on its own thread that reads the stream and checks every
+// part: boundary, Content-Length, a body that is one whole frame (see
+// host/esp_camera.h) and the trailer. A slow viewer has a small
+// receive buffer and stops for msPerFrame after each frame.
+class Viewer {
+public:
+    std::atomic<uint32_t> frames{0};
+    std::atomic<uint64_t> bytes{0};
+    uint32_t spliced = 0;
+    uint32_t malformed = 0;
+
+    explicit Viewer(uint32_t msPerFrame = 0) : msPerFrame(msPerFrame) {}
+    ~Viewer() { stop(); }
+
+    bool start() {
+        fd = connectViewer(msPerFrame ? 4096 : 0);
+        if (fd < 0) {
+            return false;
+        }
+        thread = std::thread(&Viewer::read, this);
+        return true;
+    }
+
+    // Hangs up, wherever it is in a frame
+    void stop() {
+        running = false;
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+private:
+    void read() {
+        std::string buffer;
+        bool headerSeen = false;
+        char chunk[8192];
+        while (running) {
+            int n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n == 0) {
+                return;
+            }
+            if (n < 0) {
+                continue; // Timed out: check running
+            }
+            buffer.append(chunk, n);
+            if (!headerSeen) {
+                size_t end = buffer.find("\r\n\r\n");
+                if (end == std::string::npos) {
+                    continue;
+                }
+                if (buffer.compare(0, 15, "HTTP/1.1 200 OK") != 0 ||
+                    buffer.find("multipart/x-mixed-replace;boundary=frame") > end) {
+                    malformed++;
+                    return;
+                }
+                buffer.erase(0, end + 4);
+                headerSeen = true;
+            }
+            while (running && part(buffer)) {
+                if (msPerFrame) {
+                    delay(msPerFrame);
+                }
+            }
+        }
+    }
+
+    // Consumes one complete part from the front of buffer, if there is one
+    bool part(std::string& buffer) {
+        size_t end = buffer.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            return false;
+        }
+        size_t lengthAt = buffer.find("Content-Length: ");
+        if (buffer.compare(0, 9, "--frame\r\n") != 0 || lengthAt > end) {
+            malformed++;
+            buffer.clear();
+            return false;
+        }
+        size_t length = strtoul(buffer.c_str() + lengthAt + 16, nullptr, 10);
+        size_t body = end + 4;
+        if (buffer.size() < body + length + 2) {
+            return false;
+        }
+        if (buffer.find_first_not_of(buffer[body], body) < body + length) {
+            spliced++;
+        }
+        if (buffer.compare(body + length, 2, "\r\n") != 0) {
+            malformed++;
+        }
+        buffer.erase(0, body + length + 2);
+        frames++;
+        bytes += length;
+        return true;
+    }
+
+    uint32_t msPerFrame;
+    int fd = -1;
+    std::atomic<bool> running{true};
+    std::thread thread;
+};
+
+static bool waitFor(uint8_t viewers, uint32_t timeoutMs = 1000) {
+    uint32_t start = millis();
+    while (broadcaster.viewers() != viewers) {
+        if (millis() - start > timeoutMs) {
+            return false;
+        }
+        delay(5);
+    }
+    return true;
+}
+
+void setUp(void) {
+    hostCamera().frameMs = 40;
+    hostCamera().length = 20000;
+    TEST_ASSERT_TRUE_MESSAGE(waitFor(0), "viewers left over from the last test");
+}
+
+void tearDown(void) {
+}
+
+// -----------------------------------------------------------------
+// Fan-out
+// -----------------------------------------------------------------
+void test_every_viewer_gets_every_frame(void) {
+    std::vector<Viewer*> viewers;
+    for (uint8_t i = 0; i < 4; i++) {
+        viewers.push_back(new Viewer());
+        TEST_ASSERT_TRUE(viewers.back()->start());
+    }
+    TEST_ASSERT_TRUE(waitFor(4));
+    uint32_t before = hostCamera().captured;
+    delay(2000);
+    uint32_t captured = hostCamera().captured - before;
+
+    // One capture per frame, not one per viewer
+    TEST_ASSERT_UINT32_WITHIN(5, 2000 / 40, captured);
+    for (Viewer* v : viewers) {
+        v->stop();
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(captured - 3, v->frames.load());
+        TEST_ASSERT_EQUAL_UINT32(0, v->spliced);
+        TEST_ASSERT_EQUAL_UINT32(0, v->malformed);
+        delete v;
+    }
+}
+
+void test_slow_viewer_skips_frames_without_holding_up_others(void) {
+    std::vector<Viewer*> fast;
+    for (uint8_t i = 0; i < 4; i++) {
+        fast.push_back(new Viewer());
+        TEST_ASSERT_TRUE(fast.back()->start());
+    }
+    Viewer slow(400);
+    TEST_ASSERT_TRUE(slow.start());
+    TEST_ASSERT_TRUE(waitFor(5));
+    uint32_t before = hostCamera().captured;
+    uint32_t fastBefore[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        fastBefore[i] = fast[i]->frames;
+    }
+    delay(3000);
+    uint32_t captured = hostCamera().captured - before;
+
+    TEST_ASSERT_UINT32_WITHIN(5, 3000 / 40, captured);
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_GREATER_OR_EQUAL_UINT32(captured - 3, fast[i]->frames - fastBefore[i]);
+        TEST_ASSERT_EQUAL_UINT32(0, fast[i]->spliced);
+    }
+    // The slow viewer gets what it can take, each frame whole
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(3, slow.frames.load());
+    TEST_ASSERT_LESS_THAN_UINT32(captured / 4, slow.frames.load());
+    TEST_ASSERT_EQUAL_UINT32(0, slow.spliced);
+    TEST_ASSERT_EQUAL_UINT32(0, slow.malformed);
+
+    slow.stop();
+    for (Viewer* v : fast) {
+        v->stop();
+        delete v;
+    }
+}
+
+void test_extra_viewer_is_turned_away(void) {
+    std::vector<Viewer*> viewers;
+    for (uint8_t i = 0; i < STREAM_MAX_CLIENTS; i++) {
+        viewers.push_back(new Viewer());
+        TEST_ASSERT_TRUE(viewers.back()->start());
+    }
+    TEST_ASSERT_TRUE(waitFor(STREAM_MAX_CLIENTS));
+
+    int fd = connectViewer();
+    char response[64] = {};
+    uint32_t start = millis();
+    int n = 0;
+    while (n <= 0 && millis() - start < 1000) {
+        n = recv(fd, response, sizeof(response) - 1, 0);
+    }
+    close(fd);
+    TEST_ASSERT_EQUAL_STRING_LEN("HTTP/1.1 503", response, 12);
+    TEST_ASSERT_EQUAL_UINT8(STREAM_MAX_CLIENTS, broadcaster.viewers());
+
+    for (Viewer* v : viewers) {
+        v->stop();
+        delete v;
+    }
+}
+
+// -----------------------------------------------------------------
+// Buffers and idle capture
+// -----------------------------------------------------------------
+void test_viewer_hanging_up_mid_frame_returns_its_buffer(void) {
+    Viewer slow(1000);
+    TEST_ASSERT_TRUE(slow.start());
+    TEST_ASSERT_TRUE(waitFor(1));
+    delay(300); // Well into a frame the socket can't take yet
+    slow.stop();
+    TEST_ASSERT_TRUE(waitFor(0));
+
+    // Only "latest" is still held once capture has stopped
+    delay(2 * hostCamera().frameMs);
+    TEST_ASSERT_EQUAL_INT(1, hostCamera().outstanding.load());
+}
+
+void test_capture_stops_with_the_last_viewer(void) {
+    uint32_t before = hostCamera().captured;
+    delay(500);
+    TEST_ASSERT_EQUAL_UINT32(before, hostCamera().captured.load());
+    TEST_ASSERT_EQUAL_UINT32(hostCamera().captured, pool.framesCaptured());
+}
+
+void test_snapshot_captures_on_request_while_idle(void) {
+    uint32_t before = hostCamera().captured;
+    Frame* frame = pool.acquireFresh(0);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, hostCamera().captured.load());
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)before, frame->fb->buf[0]);
+
+    // A fresh enough frame is shared rather than captured again
+    Frame* again = pool.acquireFresh(1000);
+    TEST_ASSERT_EQUAL_PTR(frame, again);
+    pool.release(again);
+    pool.release(frame);
+    TEST_ASSERT_EQUAL_INT(1, hostCamera().outstanding.load());
+}
+
+// -----------------------------------------------------------------
+// Benchmark: throughput with more viewers
+// -----------------------------------------------------------------
+// Each viewer should keep up with the camera however many there are;
+// the 100 fps rows show the headroom over a real sensor's rate.
+static void bench(uint32_t frameMs, uint8_t count) {
+    hostCamera().frameMs = frameMs;
+    std::vector<Viewer*> viewers;
+    for (uint8_t i = 0; i < count; i++) {
+        viewers.push_back(new Viewer());
+        viewers.back()->start();
+    }
+    TEST_ASSERT_TRUE(waitFor(count));
+    delay(200);
+
+    const uint32_t ms = 2000;
+    uint32_t capturedBefore = hostCamera().captured;
+    std::vector<uint32_t> framesBefore;
+    uint64_t bytesBefore = 0;
+    for (Viewer* v : viewers) {
+        framesBefore.push_back(v->frames);
+        bytesBefore += v->bytes;
+    }
+    delay(ms);
+    float captureFps = (hostCamera().captured - capturedBefore) * 1000.0f / ms;
+    float slowestFps = 1e9f;
+    uint64_t bytes = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        slowestFps = min(slowestFps, (viewers[i]->frames - framesBefore[i]) * 1000.0f / ms);
+        bytes += viewers[i]->bytes;
+    }
+    bytes -= bytesBefore;
+    for (Viewer* v : viewers) {
+        v->stop();
+        TEST_ASSERT_EQUAL_UINT32(0, v->spliced);
+        delete v;
+    }
+    TEST_ASSERT_TRUE(waitFor(0));
+    TEST_ASSERT_TRUE(slowestFps >= captureFps * 0.9f);
+
+    char line[96];
+    snprintf(line, sizeof(line), "camera %3u fps, %u viewers: slowest %.1f fps, %.2f MB/s total",
+             (unsigned)(1000 / frameMs), count, slowestFps, bytes / 1048576.0 / (ms / 1000.0));
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark_viewers(void) {
+    const uint8_t counts[] = {1, 2, 4, STREAM_MAX_CLIENTS};
+    for (uint32_t frameMs : {40u, 10u}) {
+        for (uint8_t count : counts) {
+            bench(frameMs, count);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    signal(SIGPIPE, SIG_IGN); // lwIP reports a closed socket through errno only
+    pool.begin();
+    if (!broadcaster.begin(TEST_PORT)) {
+        printf("Can't listen on port %u\n", TEST_PORT);
+        return 1;
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_viewer_gets_every_frame);
+    RUN_TEST(test_slow_viewer_skips_frames_without_holding_up_others);
+    RUN_TEST(test_extra_viewer_is_turned_away);
+    RUN_TEST(test_viewer_hanging_up_mid_frame_returns_its_buffer);
+    RUN_TEST(test_capture_stops_with_the_last_viewer);
+    RUN_TEST(test_snapshot_captures_on_request_while_idle);
+    RUN_TEST(test_benchmark_viewers);
+    return UNITY_END();
+}
@@ -5,13 +5,15 @@
 #include <Wire.h>
 #include <Adafruit_Sensor.h>
 #include <Adafruit_SSD1306.h>
+#include <dirty_ssd1306.h>
+#include <wifi_link.h>
 
 // OLED Display Configuration
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
 #define OLED_ADDRESS 0x3C
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+DirtySSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET); // Sends only changed bytes
 
 // =================================================================
 // --- CONFIGURATION: PLEASE UPDATE THESE VALUES ---
@@ -460,10 +462,9 @@ void connectToWiFi()
     display.println("Connecting to WiFi...");
     display.display();
     
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED)
+    WiFiLink::getInstance().begin(ssid, password);
+    while (!WiFiLink::getInstance().waitConnected(500))
     {
-        delay(500);
         display.print(".");
         display.display();
     }
@@ -0,0 +1,67 @@
+#ifndef CHANGE_DETECTOR_H
+#define CHANGE_DETECTOR_H
+
+#include <stdint.h>
+
+// =================================================================
+// --- Two-sided CUSUM level-shift detector ---
+// =================================================================
+// Accumulates deviations from a slowly tracked baseline. Noise below
+// DRIFT (mm) is ignored; once the accumulated shift in either
+// direction exceeds THRESHOLD (mm) a change is reported and the
+// baseline jumps to the new level.
+//
+// A 200 mm step with THRESHOLD = 300 trips after two samples, while a
+// static scene with +/-10 mm of noise never accumulates anything.
+template <uint16_t DRIFT, uint16_t THRESHOLD>
+class ChangeDetector {
+public:
+    // Returns true when a level change is detected on this sample
+    bool update(uint16_t x) {
+        int32_t sample = (int32_t)x << 4;
+        if (!primed) {
+            baseline = sample;
+            primed = true;
+            return false;
+        }
+
+        int32_t dev = (int32_t)x - (baseline >> 4);
+        gPos += dev - DRIFT;
+        gNeg += -dev - DRIFT;
+        if (gPos < 0) gPos = 0;
+        if (gNeg < 0) gNeg = 0;
+
+        if (gPos > THRESHOLD || gNeg > THRESHOLD) {
+            fromLevel = (uint16_t)(baseline >> 4);
+            toLevel = x;
+            baseline = sample;
+            gPos = 0;
+            gNeg = 0;
+            return true;
+        }
+
+        // Follow slow drift (alpha = 1/64) so only sudden shifts trip
+        baseline += (sample - baseline) >> 6;
+        return false;
+    }
+
+    void reset() {
+        primed = false;
+        gPos = 0;
+        gNeg = 0;
+    }
+
+    // Levels of the most recent detected change, in mm
+    uint16_t from() const { return fromLevel; }
+    uint16_t to() const { return toLevel; }
+
+private:
+    int32_t baseline = 0;  // Q4 mm
+    int32_t gPos = 0;
+    int32_t gNeg = 0;
+    uint16_t fromLevel = 0;
+    uint16_t toLevel = 0;
+    bool primed = false;
+};
+
+#endif // CHANGE_DETECTOR_H
@@ -0,0 +1,157 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <stdint.h>
+
+// =================================================================
+// --- Fixed-point DSP stages for the distance sample stream ---
+// =================================================================
+// Every stage takes and returns a distance in millimeters and keeps
+// its state in integers, so a full chain costs a few hundred cycles
+// per sample on the ESP32 (no FPU / soft-float calls).
+//
+// Stages are composed at compile time:
+//   FilterChain<MedianFilter<5>, EmaFilter<2>, KalmanFilter<4, 100>> f;
+//   uint16_t clean = f.process(raw);
+
+// -----------------------------------------------------------------
+// Median-of-N spike rejection
+// -----------------------------------------------------------------
+// A single spurious reading never reaches the output as long as it
+// is outnumbered by good ones in the window. N should be odd.
+template <uint8_t N>
+class MedianFilter {
+    static_assert(N >= 3 && (N & 1), "MedianFilter window must be odd and >= 3");
+
+public:
+    uint16_t process(uint16_t x) {
+        window[head] = x;
+        head = (head + 1) % N;
+        if (count < N) count++;
+
+        // Insertion sort of a copy - N is tiny so this beats anything fancier
+        uint16_t sorted[N];
+        for (uint8_t i = 0; i < count; i++) {
+            uint16_t v = window[i];
+            int8_t j = i - 1;
+            while (j >= 0 && sorted[j] > v) {
+                sorted[j + 1] = sorted[j];
+                j--;
+            }
+            sorted[j + 1] = v;
+        }
+        return sorted[count / 2];
+    }
+
+    void reset() {
+        head = 0;
+        count = 0;
+    }
+
+private:
+    uint16_t window[N] = {0};
+    uint8_t head = 0;
+    uint8_t count = 0;
+};
+
+// -----------------------------------------------------------------
+// Exponential moving average, alpha = 1 / 2^SHIFT
+// -----------------------------------------------------------------
+// State is kept in Q8 (1/256 mm) so small steps are not lost to
+// integer truncation.
+template <uint8_t SHIFT>
+class EmaFilter {
+    static_assert(SHIFT >= 1 && SHIFT <= 8, "EmaFilter SHIFT out of range");
+
+public:
+    uint16_t process(uint16_t x) {
+        int32_t sample = (int32_t)x << 8;
+        if (!primed) {
+            acc = sample;
+            primed = true;
+        } else {
+            acc += (sample - acc) >> SHIFT;
+        }
+        return (uint16_t)((acc + 128) >> 8);
+    }
+
+    void reset() {
+        primed = false;
+    }
+
+private:
+    int32_t acc = 0;
+    bool primed = false;
+};
+
+// -----------------------------------------------------------------
+// 1D Kalman filter (constant-position model)
+// -----------------------------------------------------------------
+// Q = process noise variance (mm^2 per sample)
+// R = measurement noise variance (mm^2), ~100 for the VL53L0X in
+//     long range mode
+// The estimate is held in Q8, the gain in Q16.
+template <uint32_t Q, uint32_t R>
+class KalmanFilter {
+public:
+    uint16_t process(uint16_t z) {
+        int32_t meas = (int32_t)z << 8;
+        if (!primed) {
+            x = meas;
+            p = R << 8;
+            primed = true;
+            return z;
+        }
+
+        // Predict
+        p += Q << 8;
+
+        // Update: k = p / (p + r) in Q16
+        uint32_t k = (uint32_t)(((uint64_t)p << 16) / (p + (R << 8)));
+        x += (int32_t)(((int64_t)(meas - x) * k) >> 16);
+        p -= (uint32_t)(((uint64_t)p * k) >> 16);
+
+        return (uint16_t)((x + 128) >> 8);
+    }
+
+    void reset() {
+        primed = false;
+    }
+
+private:
+    int32_t x = 0;   // estimate, Q8 mm
+    uint32_t p = 0;  // error covariance, Q8 mm^2
+    bool primed = false;
+};
+
+// -----------------------------------------------------------------
+// Compile-time filter chain
+// -----------------------------------------------------------------
+template <typename... Stages>
+class FilterChain;
+
+template <>
+class FilterChain<> {
+public:
+    uint16_t process(uint16_t x) { return x; }
+    void reset() {}
+};
+
+template <typename First, typename... Rest>
+class FilterChain<First, Rest...> {
+public:
+    uint16_t process(uint16_t x) {
+        return rest.process(first.process(x));
+    }
+
+    void reset() {
+        first.reset();
+        rest.reset();
+    }
+
+private:
+    First first;
+    FilterChain<Rest...> rest;
+};
+
+#endif // FILTERS_H
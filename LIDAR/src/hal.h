@@ -0,0 +1,167 @@
+#ifndef HAL_H
+#define HAL_H
+
+// =================================================================
+// --- Thin hardware abstraction for the LIDAR firmware ---
+// =================================================================
+// The sampling, stats, display and upload logic only talks to these
+// classes, never to the VL53L0X / SSD1306 / WiFi / HTTPClient globals
+// directly. main.cpp uses them through the LidarRanger, LidarDisplay,
+// LidarUplink and LidarTask names at the bottom; the host build (pio
+// test -e native) binds those to a trace-replay ranger, a framebuffer
+// display, a recording uplink and a simulated-time task from
+// test/host/hal_host.h instead.
+
+#ifndef ARDUINO
+#include <hal_host.h>
+#else
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <VL53L0X.h>
+#include <Adafruit_SSD1306.h>
+#include <dirty_ssd1306.h>
+#include <i2c_bus.h>
+
+// -----------------------------------------------------------------
+// Range sensor: one VL53L0X
+// -----------------------------------------------------------------
+// Once attach()ed to the I2C bus manager, the polling calls run as
+// sensor-priority jobs on the bus task, so they slot in between the
+// display's queued writes instead of waiting behind a whole frame.
+// Setup-time calls (init, configuration) still go straight to Wire.
+class Vl53l0xRanger {
+public:
+    // Shared by every ranger on the bus
+    static void attach(I2cBus* bus) { sharedBus() = bus; }
+
+    void setTimeout(uint16_t timeoutMs) { dev.setTimeout(timeoutMs); }
+    bool init() { return dev.init(); }
+    void setAddress(uint8_t address) { dev.setAddress(address); }
+
+    // HIGH SPEED + LONG RANGE MODE (balanced for responsiveness)
+    void configureLongRange(uint32_t timingBudgetUs) {
+        // Lower the return signal rate limit for long range detection
+        dev.setSignalRateLimit(0.1);
+
+        // Increase laser pulse periods for better long-range detection
+        dev.setVcselPulsePeriod(VL53L0X::VcselPeriodPreRange, 18);
+        dev.setVcselPulsePeriod(VL53L0X::VcselPeriodFinalRange, 14);
+
+        dev.setMeasurementTimingBudget(timingBudgetUs);
+    }
+
+    void startContinuous() { dev.startContinuous(); }
+
+    // Non-blocking: true when a continuous-mode result is waiting
+    bool dataReady() {
+        uint8_t status = 0;
+        onBus([&] { status = dev.readReg(VL53L0X::RESULT_INTERRUPT_STATUS); });
+        return (status & 0x07) != 0;
+    }
+
+    // Only call after dataReady(); returns false for timeouts and
+    // out-of-range results
+    bool read(uint16_t& distance_mm) {
+        bool timedOut = false;
+        onBus([&] {
+            distance_mm = dev.readRangeContinuousMillimeters();
+            timedOut = dev.timeoutOccurred();
+        });
+        return !timedOut && distance_mm < 8190;
+    }
+
+private:
+    static I2cBus*& sharedBus() {
+        static I2cBus* bus = nullptr;
+        return bus;
+    }
+
+    template <class F>
+    void onBus(F&& f) {
+        I2cBus* bus = sharedBus();
+        if (bus) {
+            bus->run(I2C_SENSOR, f);
+        } else {
+            f();
+        }
+    }
+
+    VL53L0X dev;
+};
+
+// -----------------------------------------------------------------
+// Uplink: WiFi link state + JSON requests to Firebase
+// -----------------------------------------------------------------
+class FirebaseUplink {
+public:
+    FirebaseUplink(const char* host, const char* secret) : host(host), secret(secret) {}
+
+    bool connected() { return WiFi.status() == WL_CONNECTED; }
+
+    // path is relative to the host, e.g. "/latest.json"
+    int put(const char* path, const String& payload) { return request("PUT", path, payload); }
+    int post(const char* path, const String& payload) { return request("POST", path, payload); }
+
+private:
+    int request(const char* method, const char* path, const String& payload) {
+        HTTPClient http;
+        http.setTimeout(5000);
+        String url = String(host) + path + "?auth=" + String(secret);
+        http.begin(url);
+        http.addHeader("Content-Type", "application/json");
+        int httpCode = http.sendRequest(method, payload);
+        http.end();
+        return httpCode;
+    }
+
+    const char* host;
+    const char* secret;
+};
+
+// -----------------------------------------------------------------
+// Display: SSD1306 OLED drawn through Adafruit_GFX
+// -----------------------------------------------------------------
+// DirtySSD1306 keeps the Adafruit_SSD1306 drawing API and only sends
+// the pages / columns that changed since the last frame.
+
+// -----------------------------------------------------------------
+// Task: a body run over and over on its own core
+// -----------------------------------------------------------------
+// Between passes it sleeps periodMs, or until wake().
+class FreeRtosTask {
+public:
+    bool begin(void (*body)(), uint32_t periodMs, const char* name, uint8_t core) {
+        this->body = body;
+        this->periodMs = periodMs;
+        // HTTPS requests need the room: the TLS handshake alone takes several kB
+        return xTaskCreatePinnedToCore(run, name, 12288, this, 1, &handle, core) == pdPASS;
+    }
+
+    void wake() {
+        if (handle) xTaskNotifyGive(handle);
+    }
+
+private:
+    static void run(void* arg) {
+        FreeRtosTask* self = static_cast<FreeRtosTask*>(arg);
+        for (;;) {
+            self->body();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(self->periodMs));
+        }
+    }
+
+    void (*body)() = nullptr;
+    uint32_t periodMs = 0;
+    TaskHandle_t handle = nullptr;
+};
+
+typedef Vl53l0xRanger LidarRanger;
+typedef FirebaseUplink LidarUplink;
+typedef DirtySSD1306 LidarDisplay;
+typedef FreeRtosTask LidarTask;
+
+#endif // ARDUINO
+
+#endif // HAL_H
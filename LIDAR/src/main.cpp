@@ -1,10 +1,15 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <WiFi.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <Adafruit_SSD1306.h>
-#include <VL53L0X.h>
+#include <i2c_bus.h>
+#include <wifi_link.h>
+#include "hal.h"
+#include "filters.h"
+#include "sensor_array.h"
+#include "change_detector.h"
+#include "seqlock.h"
+#include "spsc_ring.h"
 
 // =================================================================
 // --- OLED Display Configuration (from KeepItUp reference) ---
@@ -13,7 +18,14 @@
 #define SCREEN_HEIGHT 64
 #define OLED_RESET -1
 #define OLED_ADDRESS 0x3C
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+LidarDisplay display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET); // Sends only changed bytes
+
+// The OLED and the VL53L0X(s) share one bus. After setup every access
+// goes through the bus manager: display frames are queued as bulk
+// writes and sensor polls jump the queue between them.
+I2cBus i2cBus(Wire);
+const unsigned long BUS_REPORT_INTERVAL = 10000; // Print bus utilization / latency
+unsigned long lastBusReport = 0;
 
 // =================================================================
 // --- WiFi & Firebase Configuration (from KeepItUp reference) ---
@@ -24,11 +36,32 @@ const char* password = "Airtel@Home2025";  //"Melvin420";              // Your W
 // Firebase Configuration
 const char* FIREBASE_HOST = "https://openware-ai-default-rtdb.firebaseio.com/ESP32/LIDAR";
 const char* FIREBASE_SECRET = "YOUR_DATABASE_SECRET"; // Your Firebase DB Secret
+LidarUplink uplink(FIREBASE_HOST, FIREBASE_SECRET);
+
+// Firebase uploads (periodic batches + change events), DISABLED TEMPORARILY
+#ifndef FIREBASE_UPLOADS
+#define FIREBASE_UPLOADS 0
+#endif
 
 // =================================================================
-// --- VL53L0X Laser Distance Sensor ---
+// --- VL53L0X Laser Distance Sensors ---
 // =================================================================
-VL53L0X lox;
+// Sensors share the I2C bus; each needs its own XSHUT pin so it can be
+// given a unique address at boot. A single sensor may use -1 (no XSHUT).
+// e.g. three sensors: NUM_SENSORS = 3, XSHUT_PINS = {16, 17, 18}
+const uint8_t NUM_SENSORS = 1;
+const int8_t XSHUT_PINS[NUM_SENSORS] = {-1};
+const uint8_t SENSOR_BASE_ADDRESS = 0x30;
+const uint32_t TIMING_BUDGET_US = 33000;
+
+// Sample-path DSP chain: median spike rejection, then a 1D Kalman
+// smoother. Swap stages here (e.g. EmaFilter<2>) to retune.
+typedef FilterChain<MedianFilter<5>, KalmanFilter<4, 100>> DistanceFilter;
+SensorArray<NUM_SENSORS, DistanceFilter, LidarRanger> sensors;
+
+// Per-sensor change detection: ignore drift under 15mm, trip once
+// 300mm of shift has accumulated (object arriving / leaving)
+ChangeDetector<15, 300> detectors[NUM_SENSORS];
 
 // =================================================================
 // --- Timing & Buffering Configuration ---
@@ -38,12 +71,32 @@ const unsigned long DISPLAY_INTERVAL = 50;       // Update display every 50ms (f
 unsigned long lastDisplayTime = 0;
 
 // Firebase bulk upload interval
+// Starts at 10s and doubles (up to 60s) while the scene stays static;
+// any change event drops it back to 10s
 const unsigned long FIREBASE_INTERVAL = 10000;   // Upload to Firebase every 10 seconds
+const unsigned long FIREBASE_MAX_INTERVAL = 60000;
+const uint16_t STATIC_RANGE_MM = 30;             // 10s max-min below this = static
+std::atomic<unsigned long> firebaseInterval{FIREBASE_INTERVAL}; // Reset by the sampler, stretched by the uplink
 unsigned long lastFirebaseTime = 0;
 
+// Change events are uploaded immediately, at most one per second.
+// A change inside the holdoff is held (per sensor: first "from",
+// latest "to") and sent when the holdoff expires, never dropped -
+// the detector has already moved its baseline past it.
+const unsigned long EVENT_HOLDOFF = 1000;
+unsigned long lastEventTime = 0;
+std::atomic<bool> eventSinceUpload{false};
+struct HeldEvent {
+    bool pending;
+    uint16_t from;
+    uint16_t to;
+};
+HeldEvent heldEvents[NUM_SENSORS];
+uint8_t nextEventSensor = 0;                     // Round-robin so no sensor starves the others
+
 // Buffer for storing 1-SECOND AVERAGES (not raw readings)
 // This ensures each second has equal weight in the final average
-const int MAX_SECOND_SAMPLES = 10;               // Store 10 seconds of 1-second averages
+const int MAX_SECOND_SAMPLES = FIREBASE_MAX_INTERVAL / 1000;  // One slot per second of the longest interval
 uint16_t secondAvgBuffer[MAX_SECOND_SAMPLES];    // 1-second averages
 uint16_t secondMinBuffer[MAX_SECOND_SAMPLES];    // 1-second minimums
 uint16_t secondMaxBuffer[MAX_SECOND_SAMPLES];    // 1-second maximums
@@ -70,6 +123,50 @@ unsigned long lastSecondTime = 0;
 bool firebaseUploading = false;
 unsigned long lastFirebaseSuccess = 0;
 
+// =================================================================
+// --- Published Sensor State (seqlock snapshot) ---
+// =================================================================
+// The globals above belong to the sampling loop. Everything the
+// display and uploads need is published from them in one piece, so
+// those readers can run on another task/core and still get a
+// coherent view without locks.
+struct LidarState {
+    uint16_t currentDistance;
+    bool valid;
+    uint16_t lastSecondAvg;
+    uint16_t secondMin;        // current (partial) second
+    uint16_t secondMax;
+    uint16_t running10sMin;
+    uint16_t running10sMax;
+    uint8_t bufferCount;
+    uint16_t secondAvgs[MAX_SECOND_SAMPLES];
+    uint16_t secondMins[MAX_SECOND_SAMPLES];
+    uint16_t secondMaxs[MAX_SECOND_SAMPLES];
+};
+SeqLock<LidarState> sensorState;
+
+// Upload -> sampler: how many buffered seconds uploads have sent since
+// the sampler last looked. It drops them from its buffer on its next
+// pass; counts from uploads in between add up.
+std::atomic<uint8_t> uploadedSeconds{0};
+
+// =================================================================
+// --- Uplink Task ---
+// =================================================================
+// Requests block for as long as the network takes (seconds, on a bad
+// link), so they run on a task of their own on core 0, beside the WiFi
+// stack; loop() keeps sampling on core 1 and never waits for them.
+// The uplink reads the sensor state from the snapshot above; change
+// events reach it through a ring, after the holdoff.
+const uint32_t UPLINK_POLL_MS = 20;
+struct ChangeEvent {
+    uint8_t sensor;
+    uint16_t from;
+    uint16_t to;
+};
+SpscRing<ChangeEvent, 8> pendingEvents;
+LidarTask uplinkTask;
+
 // =================================================================
 // --- Forward Declarations ---
 // =================================================================
@@ -79,6 +176,11 @@ void connectToWiFi();
 void displayDistance(uint16_t distance_mm, uint16_t avg_dist, uint16_t min_dist, uint16_t max_dist, uint16_t min10s, uint16_t max10s, bool valid, bool wifiConnected, int bufferCount);
 void displayError(const char* message);
 void uploadToFirebaseAsync();
+void onSensorSample(uint8_t index, uint16_t distance, bool valid);
+void uploadEventToFirebase(uint8_t sensor, uint16_t fromMm, uint16_t toMm);
+void consumeUploadedSeconds();
+void uplinkPass();
+void publishState();
 
 // =================================================================
 // SETUP: Runs once on boot
@@ -103,10 +205,25 @@ void setup() {
     // Initialize VL53L0X Sensor
     initVL53L0X();
     
+    // Hand the bus to the manager (400 kHz, both devices support it)
+    if (i2cBus.begin(400000)) {
+        display.useBus(&i2cBus);
+        LidarRanger::attach(&i2cBus);
+    } else {
+        Serial.println("I2C bus manager failed, using Wire directly");
+    }
+    
     unsigned long now = millis();
+    lastBusReport = now;
     lastDisplayTime = now;
     lastFirebaseTime = now;
     lastSecondTime = now;
+    
+#if FIREBASE_UPLOADS
+    if (!uplinkTask.begin(uplinkPass, UPLINK_POLL_MS, "uplink", 0)) {
+        Serial.println("Uplink task failed to start, uploads disabled");
+    }
+#endif
 }
 
 // =================================================================
@@ -115,23 +232,15 @@ void setup() {
 void loop() {
     unsigned long currentTime = millis();
     
-    // --- 1. READ SENSOR (as fast as possible) ---
-    uint16_t distance = lox.readRangeContinuousMillimeters();
-    
-    if (!lox.timeoutOccurred() && distance < 8190) {
-        lastReadingValid = true;
-        currentDistance = distance;
-        lastValidDistance = distance;
-        
-        // Accumulate for 1-second stats
-        secondSum += distance;
-        secondCount++;
-        
-        // Track min/max within this second
-        if (distance < secondMin) secondMin = distance;
-        if (distance > secondMax) secondMax = distance;
-    } else {
-        lastReadingValid = false;
+    // --- 1. READ SENSORS (only those with a result ready) ---
+    if (sensors.poll(onSensorSample) > 0) {
+        // Display the closest object seen by any sensor
+        uint16_t nearest;
+        lastReadingValid = sensors.nearest(nearest);
+        if (lastReadingValid) {
+            currentDistance = nearest;
+            lastValidDistance = nearest;
+        }
     }
     
     // --- 2. STORE 1-SECOND AVERAGE TO BUFFER ---
@@ -164,6 +273,22 @@ void loop() {
             Serial.print(" (");
             Serial.print(secondCount);
             Serial.println(" readings)");
+            
+            // Per-sensor rate counters
+            for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+                Serial.print("  Sensor ");
+                Serial.print(i);
+                Serial.print(" @0x");
+                Serial.print(sensors.channel(i).address, HEX);
+                Serial.print(": ");
+                Serial.print(sensors.channel(i).samplesPerSec);
+                Serial.println(" Hz");
+            }
+        }
+        
+        if (currentTime - lastBusReport >= BUS_REPORT_INTERVAL) {
+            i2cBus.report(Serial);
+            lastBusReport = currentTime;
         }
         
         // Reset for next second
@@ -174,36 +299,173 @@ void loop() {
         lastSecondTime = currentTime;
     }
     
+    // Drop seconds the uploader has already sent, then publish
+    consumeUploadedSeconds();
+    publishState();
+    
     // --- 3. UPDATE DISPLAY (every 100ms for smooth updates) ---
     if (currentTime - lastDisplayTime >= DISPLAY_INTERVAL) {
-        bool wifiConnected = (WiFi.status() == WL_CONNECTED);
+        LidarState snap;
+        sensorState.read(snap);
+        
+        bool wifiConnected = uplink.connected();
         // Pass current 1-second stats (use stored values if second just reset)
-        uint16_t dispMin = (secondMin == 65535) ? lastSecondAvg : secondMin;
-        uint16_t dispMax = (secondMax == 0) ? lastSecondAvg : secondMax;
+        uint16_t dispMin = (snap.secondMin == 65535) ? snap.lastSecondAvg : snap.secondMin;
+        uint16_t dispMax = (snap.secondMax == 0) ? snap.lastSecondAvg : snap.secondMax;
         // Pass running 10-second ABSOLUTE min/max
-        uint16_t disp10sMin = (running10sMin == 65535) ? dispMin : running10sMin;
-        uint16_t disp10sMax = (running10sMax == 0) ? dispMax : running10sMax;
-        displayDistance(currentDistance, lastSecondAvg, dispMin, dispMax, disp10sMin, disp10sMax, lastReadingValid, wifiConnected, secondBufferIndex);
+        uint16_t disp10sMin = (snap.running10sMin == 65535) ? dispMin : snap.running10sMin;
+        uint16_t disp10sMax = (snap.running10sMax == 0) ? dispMax : snap.running10sMax;
+        displayDistance(snap.currentDistance, snap.lastSecondAvg, dispMin, dispMax, disp10sMin, disp10sMax, snap.valid, wifiConnected, snap.bufferCount);
         lastDisplayTime = currentTime;
     }
     
-    // --- 4. UPLOAD TO FIREBASE (DISABLED TEMPORARILY) ---
-    /*
-    if (currentTime - lastFirebaseTime >= FIREBASE_INTERVAL) {
-        if (secondBufferIndex > 0 && WiFi.status() == WL_CONNECTED) {
-            Serial.print("Uploading ");
-            Serial.print(secondBufferIndex);
-            Serial.println(" second-averages to Firebase...");
-            uploadToFirebaseAsync();
+    // --- 4. HAND CHANGE EVENTS TO THE UPLINK (at most one per holdoff) ---
+    if (currentTime - lastEventTime >= EVENT_HOLDOFF) {
+        for (uint8_t n = 0; n < NUM_SENSORS; n++) {
+            uint8_t i = (nextEventSensor + n) % NUM_SENSORS;
+            HeldEvent& event = heldEvents[i];
+            if (!event.pending) {
+                continue;
+            }
+#if FIREBASE_UPLOADS
+            if (!pendingEvents.push({i, event.from, event.to})) {
+                break; // Uplink is behind: keep holding, merging any later change
+            }
+            uplinkTask.wake();
+#endif
+            event.pending = false;
+            Serial.print("Change on sensor ");
+            Serial.print(i);
+            Serial.print(": ");
+            Serial.print(event.from);
+            Serial.print(" -> ");
+            Serial.print(event.to);
+            Serial.println(" mm");
+            nextEventSensor = (i + 1) % NUM_SENSORS;
+            lastEventTime = currentTime;
+            break;
         }
-        lastFirebaseTime = currentTime;
     }
-    */
     
     // Minimal delay - sensor timing budget handles the rest
     delay(5);  // Reduced from 10ms for faster response
 }
 
+// =================================================================
+// --- UPLINK PASS (uplink task, core 0) ---
+// =================================================================
+// Sends the change events handed over so far, then the bulk upload
+// when its adaptive interval is up
+void uplinkPass() {
+    ChangeEvent event;
+    while (pendingEvents.pop(event)) {
+        if (uplink.connected()) {
+            uploadEventToFirebase(event.sensor, event.from, event.to);
+        }
+    }
+    
+    unsigned long currentTime = millis();
+    unsigned long interval = firebaseInterval;
+    if (currentTime - lastFirebaseTime < interval) {
+        return;
+    }
+    LidarState snap;
+    sensorState.read(snap);
+    
+    // Stretch the interval while nothing is happening
+    bool changed = eventSinceUpload.exchange(false);
+    bool staticScene = !changed && snap.running10sMax >= snap.running10sMin &&
+                       (snap.running10sMax - snap.running10sMin) < STATIC_RANGE_MM;
+    
+    if (snap.bufferCount > 0 && uplink.connected()) {
+        Serial.print("Uploading ");
+        Serial.print(snap.bufferCount);
+        Serial.println(" second-averages to Firebase...");
+        uploadToFirebaseAsync();
+    }
+    
+    // A change event the sampler saw meanwhile has already reset the
+    // interval; don't stretch over it
+    unsigned long next = staticScene ? min(interval * 2, FIREBASE_MAX_INTERVAL) : FIREBASE_INTERVAL;
+    firebaseInterval.compare_exchange_strong(interval, next);
+    lastFirebaseTime = currentTime;
+}
+
+// =================================================================
+// --- SAMPLE PIPELINE (called once per sensor result) ---
+// =================================================================
+void onSensorSample(uint8_t index, uint16_t distance, bool valid) {
+    if (!valid) {
+        return;
+    }
+    
+    // Every sensor feeds the same 1-second stats, so the sample rate
+    // scales with the number of sensors
+    secondSum += distance;
+    secondCount++;
+    
+    // Track min/max within this second
+    if (distance < secondMin) secondMin = distance;
+    if (distance > secondMax) secondMax = distance;
+    
+    // Level change: hold it for upload. Several changes before it goes
+    // out merge into one, from the level before the first to the latest.
+    if (detectors[index].update(distance)) {
+        HeldEvent& event = heldEvents[index];
+        if (!event.pending) {
+            event.pending = true;
+            event.from = detectors[index].from();
+        }
+        event.to = detectors[index].to();
+        eventSinceUpload = true;
+        
+        // Back to the short interval so the new scene is reported promptly
+        firebaseInterval = FIREBASE_INTERVAL;
+    }
+}
+
+// =================================================================
+// --- STATE PUBLISHING (sampler side) ---
+// =================================================================
+void consumeUploadedSeconds() {
+    uint8_t consumed = uploadedSeconds.exchange(0);
+    if (consumed == 0) {
+        return;
+    }
+    if (consumed > secondBufferIndex) consumed = secondBufferIndex;
+    
+    // Keep any seconds that arrived while the upload was in flight
+    int remaining = secondBufferIndex - consumed;
+    memmove(secondAvgBuffer, secondAvgBuffer + consumed, remaining * sizeof(uint16_t));
+    memmove(secondMinBuffer, secondMinBuffer + consumed, remaining * sizeof(uint16_t));
+    memmove(secondMaxBuffer, secondMaxBuffer + consumed, remaining * sizeof(uint16_t));
+    secondBufferIndex = remaining;
+    
+    // Running min/max now only covers the seconds still buffered
+    running10sMin = 65535;
+    running10sMax = 0;
+    for (int i = 0; i < remaining; i++) {
+        if (secondMinBuffer[i] < running10sMin) running10sMin = secondMinBuffer[i];
+        if (secondMaxBuffer[i] > running10sMax) running10sMax = secondMaxBuffer[i];
+    }
+}
+
+void publishState() {
+    LidarState next;
+    next.currentDistance = currentDistance;
+    next.valid = lastReadingValid;
+    next.lastSecondAvg = lastSecondAvg;
+    next.secondMin = secondMin;
+    next.secondMax = secondMax;
+    next.running10sMin = running10sMin;
+    next.running10sMax = running10sMax;
+    next.bufferCount = secondBufferIndex;
+    memcpy(next.secondAvgs, secondAvgBuffer, secondBufferIndex * sizeof(uint16_t));
+    memcpy(next.secondMins, secondMinBuffer, secondBufferIndex * sizeof(uint16_t));
+    memcpy(next.secondMaxs, secondMaxBuffer, secondBufferIndex * sizeof(uint16_t));
+    sensorState.publish(next);
+}
+
 // =================================================================
 // --- INITIALIZATION FUNCTIONS ---
 // =================================================================
@@ -238,11 +500,12 @@ void connectToWiFi() {
     display.println(ssid);
     display.display();
     
-    WiFi.begin(ssid, password);
+    // Cached BSSID/channel when we have one; the link keeps retrying in
+    // the background if this 20 s window runs out
+    WiFiLink::getInstance().begin(ssid, password);
     
     int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 40) {
-        delay(500);
+    while (!WiFiLink::getInstance().waitConnected(500) && attempts < 40) {
         Serial.print(".");
         display.print(".");
         display.display();
@@ -280,9 +543,11 @@ void initVL53L0X() {
     display.println("Init VL53L0X...");
     display.display();
     
-    lox.setTimeout(500);
-    if (!lox.init()) {
-        Serial.println(F("Failed to boot VL53L0X sensor!"));
+    // XSHUT sequencing: give every sensor its own I2C address
+    int failed = sensors.begin(XSHUT_PINS, SENSOR_BASE_ADDRESS, 500);
+    if (failed >= 0) {
+        Serial.print(F("Failed to boot VL53L0X sensor "));
+        Serial.println(failed);
         displayError("VL53L0X FAILED!");
         for(;;); // Don't proceed, loop forever
     }
@@ -290,27 +555,24 @@ void initVL53L0X() {
     // =================================================================
     // HIGH SPEED + LONG RANGE MODE (balanced for responsiveness)
     // =================================================================
-    // Lower the return signal rate limit for long range detection
-    lox.setSignalRateLimit(0.1);
-    
-    // Increase laser pulse periods for better long-range detection
-    lox.setVcselPulsePeriod(VL53L0X::VcselPeriodPreRange, 18);
-    lox.setVcselPulsePeriod(VL53L0X::VcselPeriodFinalRange, 14);
-    
-    // FASTER timing budget: 33ms for ~30 readings/sec
+    // FASTER timing budget: 33ms for ~30 readings/sec per sensor
     // Prioritizes speed for responsive display
-    lox.setMeasurementTimingBudget(33000); // 33ms for faster readings
+    for (uint8_t i = 0; i < NUM_SENSORS; i++) {
+        sensors.device(i).configureLongRange(TIMING_BUDGET_US);
+    }
     
     Serial.println("High-speed long range mode enabled");
     
-    // Start continuous ranging measurements
-    lox.startContinuous();
+    // Start continuous ranging, staggered so conversions interleave
+    sensors.startStaggered(TIMING_BUDGET_US);
     
-    Serial.println("VL53L0X initialized successfully!");
+    Serial.print(NUM_SENSORS);
+    Serial.println(" VL53L0X sensor(s) initialized successfully!");
     
     display.clearDisplay();
     display.setCursor(0, 0);
-    display.println("VL53L0X Ready!");
+    display.print("VL53L0X Ready! x");
+    display.println(NUM_SENSORS);
     display.println("Fast + Long Range");
     display.display();
     delay(1000);
@@ -328,9 +590,18 @@ void displayDistance(uint16_t distance_mm, uint16_t avg_dist, uint16_t min_dist,
     display.setCursor(0, 0);
     display.print("LIDAR ");
     display.print(wifiConnected ? "[OK]" : "[--]");
-    display.print(" T-");
-    display.print(10 - bufferCount);
-    display.println("s");
+    // Countdown to the next upload; once that has passed (offline, or
+    // uploads disabled) the seconds waiting in the buffer instead
+    int countdown = (int)(firebaseInterval / 1000) - bufferCount;
+    if (countdown > 0) {
+        display.print(" T-");
+        display.print(countdown);
+        display.println("s");
+    } else {
+        display.print(" ");
+        display.print(bufferCount);
+        display.println("s buf");
+    }
     display.drawFastHLine(0, 10, SCREEN_WIDTH, SSD1306_WHITE);
     
     if (valid) {
@@ -387,7 +658,11 @@ void displayError(const char* message) {
 // --- FIREBASE BULK UPLOAD (using 1-second averages) ---
 // =================================================================
 void uploadToFirebaseAsync() {
-    if (WiFi.status() != WL_CONNECTED || secondBufferIndex == 0) {
+    // Work from a snapshot - safe to run off the sampling core
+    LidarState snap;
+    sensorState.read(snap);
+    
+    if (!uplink.connected() || snap.bufferCount == 0) {
         return;
     }
     
@@ -395,49 +670,42 @@ void uploadToFirebaseAsync() {
     
     // Calculate AVERAGE from 1-SECOND data
     uint32_t sum = 0;
-    for (int i = 0; i < secondBufferIndex; i++) {
-        sum += secondAvgBuffer[i];
+    for (int i = 0; i < snap.bufferCount; i++) {
+        sum += snap.secondAvgs[i];
     }
-    uint16_t avgDist = sum / secondBufferIndex;
+    uint16_t avgDist = sum / snap.bufferCount;
     
     // Use running ABSOLUTE min/max (NOT averaged!)
     // These track the true minimum and maximum across entire 10-second window
-    uint16_t overallMin = running10sMin;
-    uint16_t overallMax = running10sMax;
-    
-    HTTPClient http;
-    http.setTimeout(5000);
+    uint16_t overallMin = snap.running10sMin;
+    uint16_t overallMax = snap.running10sMax;
     
     // --- 1. Update "latest" with comprehensive stats ---
     JsonDocument latestDoc;
     
     // Current reading (most recent 1-sec values)
-    latestDoc["distance_mm"] = secondAvgBuffer[secondBufferIndex - 1];
-    latestDoc["distance_cm"] = secondAvgBuffer[secondBufferIndex - 1] / 10.0;
+    latestDoc["distance_mm"] = snap.secondAvgs[snap.bufferCount - 1];
+    latestDoc["distance_cm"] = snap.secondAvgs[snap.bufferCount - 1] / 10.0;
     
     // 1-second stats (most recent second)
     JsonObject oneSecond = latestDoc["one_second"].to<JsonObject>();
-    oneSecond["avg_mm"] = secondAvgBuffer[secondBufferIndex - 1];
-    oneSecond["min_mm"] = secondMinBuffer[secondBufferIndex - 1];
-    oneSecond["max_mm"] = secondMaxBuffer[secondBufferIndex - 1];
+    oneSecond["avg_mm"] = snap.secondAvgs[snap.bufferCount - 1];
+    oneSecond["min_mm"] = snap.secondMins[snap.bufferCount - 1];
+    oneSecond["max_mm"] = snap.secondMaxs[snap.bufferCount - 1];
     
     // 10-second stats (all seconds combined)
     JsonObject tenSecond = latestDoc["ten_second"].to<JsonObject>();
     tenSecond["avg_mm"] = avgDist;
     tenSecond["min_mm"] = overallMin;
     tenSecond["max_mm"] = overallMax;
-    tenSecond["seconds"] = secondBufferIndex;
+    tenSecond["seconds"] = snap.bufferCount;
     
     latestDoc["timestamp"] = millis();
     
     String latestPayload;
     serializeJson(latestDoc, latestPayload);
     
-    String url = String(FIREBASE_HOST) + "/latest.json?auth=" + String(FIREBASE_SECRET);
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    int httpCode = http.PUT(latestPayload);
-    http.end();
+    int httpCode = uplink.put("/latest.json", latestPayload);
     
     if (httpCode == 200) {
         Serial.println("Latest data uploaded successfully");
@@ -449,7 +717,7 @@ void uploadToFirebaseAsync() {
     // --- 2. Add batch to history with ALL 1-second data ---
     JsonDocument batchDoc;
     batchDoc["timestamp"] = millis();
-    batchDoc["seconds"] = secondBufferIndex;
+    batchDoc["seconds"] = snap.bufferCount;
     
     // 10-second summary
     batchDoc["avg_mm"] = avgDist;
@@ -461,27 +729,20 @@ void uploadToFirebaseAsync() {
     JsonArray minArray = batchDoc["second_mins"].to<JsonArray>();
     JsonArray maxArray = batchDoc["second_maxs"].to<JsonArray>();
     
-    for (int i = 0; i < secondBufferIndex; i++) {
-        avgArray.add(secondAvgBuffer[i]);
-        minArray.add(secondMinBuffer[i]);
-        maxArray.add(secondMaxBuffer[i]);
+    for (int i = 0; i < snap.bufferCount; i++) {
+        avgArray.add(snap.secondAvgs[i]);
+        minArray.add(snap.secondMins[i]);
+        maxArray.add(snap.secondMaxs[i]);
     }
     
     String batchPayload;
     serializeJson(batchDoc, batchPayload);
     
-    String historyUrl = String(FIREBASE_HOST) + "/history.json?auth=" + String(FIREBASE_SECRET);
-    http.begin(historyUrl);
-    http.addHeader("Content-Type", "application/json");
-    http.POST(batchPayload);
-    http.end();
+    uplink.post("/history.json", batchPayload);
     
-    // Clear buffer after successful upload
-    secondBufferIndex = 0;
-    
-    // Reset running 10-second min/max for next window
-    running10sMin = 65535;
-    running10sMax = 0;
+    // Hand the sent seconds back to the sampler to clear from its buffer
+    // (this also resets the running min/max for the next window)
+    uploadedSeconds.fetch_add(snap.bufferCount);
     
     unsigned long uploadTime = millis() - startTime;
     Serial.print("Firebase bulk upload completed in ");
@@ -489,4 +750,25 @@ void uploadToFirebaseAsync() {
     Serial.println("ms");
     
     lastFirebaseSuccess = millis();
+}
+
+// =================================================================
+// --- FIREBASE EVENT UPLOAD (compact, sent as soon as a change trips) ---
+// =================================================================
+void uploadEventToFirebase(uint8_t sensor, uint16_t fromMm, uint16_t toMm) {
+    JsonDocument eventDoc;
+    eventDoc["t"] = millis();
+    eventDoc["s"] = sensor;
+    eventDoc["from"] = fromMm;
+    eventDoc["to"] = toMm;
+    
+    String payload;
+    serializeJson(eventDoc, payload);
+    
+    int httpCode = uplink.post("/events.json", payload);
+    
+    if (httpCode != 200) {
+        Serial.print("Event upload failed: ");
+        Serial.println(httpCode);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#ifndef SENSOR_ARRAY_H
+#define SENSOR_ARRAY_H
+
+#include <Arduino.h>
+
+// =================================================================
+// --- Array of VL53L0X sensors sharing one I2C bus ---
+// =================================================================
+// All sensors power up at the same default address (0x29), so each
+// one is held in reset through its XSHUT pin and released one at a
+// time to be given its own address.
+//
+// Sensors run in continuous mode with staggered start times, so their
+// conversions overlap and the bus sees one ready result at a time.
+// poll() never waits on a sensor: it only reads the ones that report
+// data ready, so one slow sensor can't stall the others.
+//
+// Ranger is the per-sensor device (see Vl53l0xRanger in hal.h).
+template <uint8_t N, typename Filter, typename Ranger>
+class SensorArray {
+public:
+    typedef void (*SampleCallback)(uint8_t index, uint16_t distance_mm, bool valid);
+
+    struct Channel {
+        Ranger dev;
+        int8_t xshutPin;
+        uint8_t address;
+        Filter filter;
+        uint16_t distance;
+        bool valid;
+        unsigned long lastSampleTime;
+        uint16_t windowSamples;   // samples in the current rate window
+        uint16_t samplesPerSec;   // last completed rate window
+    };
+
+    // Returns the index of the first sensor that failed to boot, or -1
+    // if all of them came up. A pin of -1 means that sensor has no
+    // XSHUT line (only valid for a single-sensor array).
+    int begin(const int8_t xshutPins[N], uint8_t baseAddress, uint16_t timeoutMs) {
+        this->timeoutMs = timeoutMs;
+
+        // Hold every sensor in reset
+        for (uint8_t i = 0; i < N; i++) {
+            channels[i].xshutPin = xshutPins[i];
+            if (xshutPins[i] >= 0) {
+                pinMode(xshutPins[i], OUTPUT);
+                digitalWrite(xshutPins[i], LOW);
+            }
+        }
+        delay(10);
+
+        // Wake them one by one and move each off the default address
+        for (uint8_t i = 0; i < N; i++) {
+            Channel& ch = channels[i];
+            if (ch.xshutPin >= 0) {
+                digitalWrite(ch.xshutPin, HIGH);
+                delay(10);
+            }
+
+            ch.dev.setTimeout(timeoutMs);
+            if (!ch.dev.init()) {
+                return i;
+            }
+
+            ch.address = baseAddress + i;
+            ch.dev.setAddress(ch.address);
+
+            ch.distance = 0;
+            ch.valid = false;
+            ch.lastSampleTime = millis();
+            ch.windowSamples = 0;
+            ch.samplesPerSec = 0;
+        }
+        return -1;
+    }
+
+    // Start continuous ranging, offsetting each sensor by budget / N so
+    // results become ready evenly spread across the timing budget.
+    void startStaggered(uint32_t timingBudgetUs) {
+        uint32_t stepUs = timingBudgetUs / N;
+        for (uint8_t i = 0; i < N; i++) {
+            channels[i].dev.startContinuous();
+            channels[i].lastSampleTime = millis();
+            if (i + 1 < N) {
+                delayMicroseconds(stepUs);
+            }
+        }
+        lastRateTime = millis();
+    }
+
+    // Read every sensor that has a result ready. Returns the number of
+    // samples delivered to the callback.
+    uint8_t poll(SampleCallback onSample) {
+        uint8_t delivered = 0;
+        unsigned long now = millis();
+
+        for (uint8_t i = 0; i < N; i++) {
+            Channel& ch = channels[i];
+
+            if (!ch.dev.dataReady()) {
+                // Nothing ready - only report a timeout once it's overdue
+                if (now - ch.lastSampleTime >= timeoutMs) {
+                    ch.valid = false;
+                    ch.lastSampleTime = now;
+                    onSample(i, ch.distance, false);
+                    delivered++;
+                }
+                continue;
+            }
+
+            // Data is ready, so this returns without polling the sensor
+            uint16_t raw;
+            bool ok = ch.dev.read(raw);
+            ch.lastSampleTime = now;
+            ch.windowSamples++;
+
+            if (ok) {
+                ch.distance = ch.filter.process(raw);
+                ch.valid = true;
+            } else {
+                ch.valid = false;
+            }
+            onSample(i, ch.distance, ch.valid);
+            delivered++;
+        }
+
+        if (now - lastRateTime >= 1000) {
+            for (uint8_t i = 0; i < N; i++) {
+                channels[i].samplesPerSec = channels[i].windowSamples;
+                channels[i].windowSamples = 0;
+            }
+            lastRateTime = now;
+        }
+
+        return delivered;
+    }
+
+    // Nearest valid distance across the array (the closest object in
+    // the covered area). Returns false if no sensor has a valid reading.
+    bool nearest(uint16_t& distance_mm) const {
+        bool found = false;
+        for (uint8_t i = 0; i < N; i++) {
+            if (channels[i].valid && (!found || channels[i].distance < distance_mm)) {
+                distance_mm = channels[i].distance;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    uint16_t totalSamplesPerSec() const {
+        uint16_t total = 0;
+        for (uint8_t i = 0; i < N; i++) {
+            total += channels[i].samplesPerSec;
+        }
+        return total;
+    }
+
+    Ranger& device(uint8_t i) { return channels[i].dev; }
+    const Channel& channel(uint8_t i) const { return channels[i]; }
+    uint8_t size() const { return N; }
+
+private:
+    Channel channels[N];
+    uint16_t timeoutMs = 500;
+    unsigned long lastRateTime = 0;
+};
+
+#endif // SENSOR_ARRAY_H
@@ -0,0 +1,54 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+
+// =================================================================
+// --- Single-writer seqlock ---
+// =================================================================
+// The writer (the sampling loop) publishes a whole struct at once;
+// readers on any core/task copy it out without taking a lock. The
+// sequence number is odd while a write is in progress, so a reader
+// that raced with the writer just retries and never sees a torn mix
+// of old and new fields.
+//
+// publish() never waits, so the sampler is never held up by a slow
+// reader (display flush, HTTP upload).
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+public:
+    // Writer side - must only be called from one task
+    void publish(const T& value) {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&data, &value, sizeof(T));
+        sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side - safe from any task or core
+    void read(T& out) const {
+        uint32_t before, after;
+        do {
+            before = sequence.load(std::memory_order_acquire);
+            memcpy(&out, &data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+    }
+
+    // Number of completed publishes (handy to skip unchanged frames)
+    uint32_t version() const {
+        return sequence.load(std::memory_order_acquire) >> 1;
+    }
+
+private:
+    std::atomic<uint32_t> sequence{0};
+    T data{};
+};
+
+#endif // SEQLOCK_H
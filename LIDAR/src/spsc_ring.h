@@ -0,0 +1,43 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <stdint.h>
+
+// =================================================================
+// --- Single-producer, single-consumer ring ---
+// =================================================================
+// Hands small items from one task to another without a lock: only
+// the producer moves head and only the consumer moves tail. push()
+// fails rather than waits when the ring is full, so the producer
+// decides what to do with the item.
+template <typename T, uint32_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    // Producer side
+    bool push(const T& item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == N) return false;
+        slots[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    T slots[N];
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,194 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// =================================================================
+// --- Just enough of the Arduino core to build main.cpp on a host ---
+// =================================================================
+// Time is simulated: millis() / micros() read a clock that only moves
+// when delay() or a fake device advances it, so a replay runs as fast
+// as the CPU allows and is the same on every run. Serial output is
+// dropped unless Serial.echo is set.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT 0
+#define DEC 10
+#define HEX 16
+#define F(s) (s)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// -----------------------------------------------------------------
+// Simulated clock
+// -----------------------------------------------------------------
+inline uint64_t& hostMicros() {
+    static uint64_t now = 0;
+    return now;
+}
+inline void hostAdvance(uint32_t ms) { hostMicros() += (uint64_t)ms * 1000; }
+
+inline unsigned long millis() { return (unsigned long)(hostMicros() / 1000); }
+inline unsigned long micros() { return (unsigned long)hostMicros(); }
+
+// Other simulated tasks get the CPU while the caller sleeps in delay(),
+// as they would on the device's other core (see hal_host.h's SteppedTask)
+typedef void (*HostSleepHook)();
+inline HostSleepHook& hostSleepHook() {
+    static HostSleepHook hook = nullptr;
+    return hook;
+}
+
+inline void delay(unsigned long ms) {
+    hostAdvance(ms);
+    if (hostSleepHook()) hostSleepHook()();
+}
+inline void delayMicroseconds(unsigned int us) { hostMicros() += us; }
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// -----------------------------------------------------------------
+// String: what main.cpp and ArduinoJson (ARDUINOJSON_ENABLE_ARDUINO_STRING)
+// use of it
+// -----------------------------------------------------------------
+class String {
+public:
+    String() {}
+    String(const char* s) : s(s ? s : "") {}
+    String(const std::string& s) : s(s) {}
+    String(char c) : s(1, c) {}
+    String(int v) : s(std::to_string(v)) {}
+    String(unsigned int v) : s(std::to_string(v)) {}
+    String(long v) : s(std::to_string(v)) {}
+    String(unsigned long v) : s(std::to_string(v)) {}
+    String(float v, unsigned char decimals = 2) : s(fixed(v, decimals)) {}
+    String(double v, unsigned char decimals = 2) : s(fixed(v, decimals)) {}
+
+    String& operator=(const char* other) {
+        s = other ? other : "";
+        return *this;
+    }
+    bool concat(const char* other) {
+        s += other;
+        return true;
+    }
+    bool concat(const String& other) {
+        s += other.s;
+        return true;
+    }
+    String& operator+=(const String& other) {
+        s += other.s;
+        return *this;
+    }
+    friend String operator+(const String& a, const String& b) { return String(a.s + b.s); }
+    friend String operator+(const String& a, const char* b) { return String(a.s + b); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.s); }
+    bool operator==(const String& other) const { return s == other.s; }
+    bool operator==(const char* other) const { return s == other; }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int)s.size(); }
+    int indexOf(const char* needle) const {
+        size_t at = s.find(needle);
+        return at == std::string::npos ? -1 : (int)at;
+    }
+
+private:
+    static std::string fixed(double v, unsigned char decimals) {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.*f", decimals, v);
+        return buffer;
+    }
+
+    std::string s;
+};
+
+// ArduinoJson's String adapter also names this type
+class StringSumHelper : public String {};
+
+// -----------------------------------------------------------------
+// IPAddress / Print / Serial
+// -----------------------------------------------------------------
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : octets{a, b, c, d} {}
+    String toString() const {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+        return String(buffer);
+    }
+
+private:
+    uint8_t octets[4];
+};
+
+// Everything printed ends up in write(), as on the device, so a
+// display fake deriving from Print sees the same characters
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const char* s) {
+        size_t n = 0;
+        while (*s) n += write((uint8_t)*s++);
+        return n;
+    }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return write(buffer);
+    }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str()); }
+    size_t print(const IPAddress& ip) { return write(ip.toString().c_str()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+    size_t print(long v, int base = DEC) { return printf(base == HEX ? "%lX" : "%ld", v); }
+    size_t print(unsigned long v, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", v); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(unsigned short v, int base = DEC) { return print((unsigned long)v, base); }
+
+    size_t println() { return write((uint8_t)'\n'); }
+    template <typename T>
+    size_t println(const T& v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(const T& v, int format) { return print(v, format) + println(); }
+};
+
+class HardwareSerial : public Print {
+public:
+    using Print::write;
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override {
+        if (echo) putchar(c);
+        return 1;
+    }
+
+    bool echo = false;
+};
+
+inline HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,23 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_CONNECTED = 3,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+// Host build: the link is up unless a test takes it down
+class WiFiClass {
+public:
+    wl_status_t status() { return linkUp ? WL_CONNECTED : WL_DISCONNECTED; }
+    IPAddress localIP() { return IPAddress(192, 168, 1, 50); }
+
+    bool linkUp = true;
+};
+
+inline WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
@@ -0,0 +1,15 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+// Host build: the bus itself is never touched, only passed around
+class TwoWire {
+public:
+    bool begin(int sda = -1, int scl = -1) { return true; }
+    void setClock(uint32_t) {}
+};
+
+inline TwoWire Wire;
+
+#endif // HOST_WIRE_H
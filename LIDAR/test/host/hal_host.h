@@ -0,0 +1,280 @@
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Wire.h>
+#include <i2c_bus.h>
+#include <vector>
+
+// =================================================================
+// --- Host-side stand-ins for the LIDAR HAL (see src/hal.h) ---
+// =================================================================
+// Same methods as the device classes, so main.cpp builds unchanged:
+//   TraceRanger          replays a recorded distance trace at the
+//                        configured timing budget
+//   RecordingUplink      keeps every request instead of sending it
+//   FrameBufferDisplay   draws into an SSD1306-layout framebuffer
+//   SteppedTask          runs a task body in simulated time
+
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_BLACK 0
+#define SSD1306_WHITE 1
+
+// -----------------------------------------------------------------
+// Range sensor: trace replay
+// -----------------------------------------------------------------
+// Every ranger plays the same trace from the start, looping, one
+// result per timing budget of simulated time. As with the real sensor
+// in continuous mode, a result not read before the next one is ready
+// is overwritten; totals across all rangers are kept for the tests.
+class TraceRanger {
+public:
+    static void play(const uint16_t* samples, uint16_t count) {
+        source().samples = samples;
+        source().count = count;
+    }
+    static void attach(I2cBus*) {}
+
+    void setTimeout(uint16_t) {}
+    bool init() { return true; }
+    void setAddress(uint8_t) {}
+    void configureLongRange(uint32_t timingBudgetUs) { periodMs = timingBudgetUs / 1000; }
+    void startContinuous() { readyAt = millis() + periodMs; }
+
+    bool dataReady() { return source().count > 0 && millis() >= readyAt; }
+
+    bool read(uint16_t& distance_mm) {
+        while (millis() >= readyAt + periodMs) { // Overwritten before we got to it
+            position++;
+            readyAt += periodMs;
+            totals().missed++;
+        }
+        distance_mm = source().samples[position % source().count];
+        position++;
+        readyAt += periodMs;
+        totals().samples++;
+        return distance_mm < 8190;
+    }
+
+    static uint32_t samples() { return totals().samples; }
+    static uint32_t missed() { return totals().missed; }
+    static uint32_t played() { return totals().samples + totals().missed; } // Trace position (one ranger)
+
+private:
+    struct Source {
+        const uint16_t* samples = nullptr;
+        uint16_t count = 0;
+    };
+    static Source& source() {
+        static Source shared;
+        return shared;
+    }
+
+    struct Totals {
+        uint32_t samples = 0;
+        uint32_t missed = 0;
+    };
+    static Totals& totals() {
+        static Totals shared;
+        return shared;
+    }
+
+    uint32_t position = 0;
+    uint32_t periodMs = 33;
+    unsigned long readyAt = 0;
+};
+
+// -----------------------------------------------------------------
+// Uplink: records requests
+// -----------------------------------------------------------------
+// Connected while WiFi.linkUp. Each request takes latencyMs of
+// simulated time, as a blocking HTTPClient call would.
+class RecordingUplink {
+public:
+    struct Request {
+        String method;
+        String path;
+        String payload;
+        unsigned long atMs;
+    };
+
+    RecordingUplink(const char*, const char*) {}
+
+    bool connected() { return WiFi.status() == WL_CONNECTED; }
+    int put(const char* path, const String& payload) { return request("PUT", path, payload); }
+    int post(const char* path, const String& payload) { return request("POST", path, payload); }
+
+    uint32_t count(const char* path) const {
+        uint32_t n = 0;
+        for (const Request& r : requests) {
+            if (r.path == path) n++;
+        }
+        return n;
+    }
+
+    std::vector<Request> requests;
+    int status = 200;
+    uint32_t latencyMs = 0;
+
+private:
+    int request(const char* method, const char* path, const String& payload) {
+        requests.push_back({method, path, payload, millis()});
+        delay(latencyMs);
+        return status;
+    }
+};
+
+// -----------------------------------------------------------------
+// Display: framebuffer
+// -----------------------------------------------------------------
+// The Adafruit_GFX calls main.cpp makes, drawing into a buffer with
+// the SSD1306's page layout. Text is drawn as solid character cells
+// (no font) and also kept as plain text, so tests can check both
+// what is on screen and where. display() "sends" the frame: it
+// becomes shown() and the bytes that changed are counted.
+class FrameBufferDisplay : public Print {
+public:
+    using Print::write;
+
+    FrameBufferDisplay(uint8_t width, uint8_t height, TwoWire*, int8_t) : width(width), height(height) {
+        buffer.assign(width * ((height + 7) / 8), 0);
+        shownBuffer = buffer;
+    }
+
+    bool begin(uint8_t, uint8_t) { return true; }
+    void useBus(I2cBus*) {}
+
+    void clearDisplay() {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        text.clear();
+    }
+    void setTextSize(uint8_t size) { textSize = size; }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void setCursor(int16_t x, int16_t y) {
+        cursorX = x;
+        cursorY = y;
+        if (!text.empty() && text.back() != '\n') text += '\n';
+    }
+
+    size_t write(uint8_t c) override {
+        text += (char)c;
+        if (c == '\n') {
+            cursorX = 0;
+            cursorY += 8 * textSize;
+            return 1;
+        }
+        if (cursorX + 6 * textSize > width) { // Wrap, as Adafruit_GFX does
+            cursorX = 0;
+            cursorY += 8 * textSize;
+        }
+        if (c != ' ') {
+            fillRect(cursorX, cursorY, 5 * textSize, 7 * textSize, textColor);
+        }
+        cursorX += 6 * textSize;
+        return 1;
+    }
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) {
+        if (x < 0 || y < 0 || x >= width || y >= height) return;
+        uint8_t& b = buffer[x + (y / 8) * width];
+        b = color ? (b | (1 << (y & 7))) : (b & ~(1 << (y & 7)));
+    }
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRect(x, y, w, 1, color); }
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRect(x, y, 1, h, color); }
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        for (int16_t i = x; i < x + w; i++) {
+            for (int16_t j = y; j < y + h; j++) drawPixel(i, j, color);
+        }
+    }
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+        drawFastHLine(x, y, w, color);
+        drawFastHLine(x, y + h - 1, w, color);
+        drawFastVLine(x, y, h, color);
+        drawFastVLine(x + w - 1, y, h, color);
+    }
+
+    void display() {
+        for (size_t i = 0; i < buffer.size(); i++) {
+            if (buffer[i] != shownBuffer[i]) changedBytes++;
+        }
+        shownBuffer = buffer;
+        shownText = text;
+        frameCount++;
+    }
+
+    // What the panel shows after the last display()
+    bool pixel(int16_t x, int16_t y) const { return shownBuffer[x + (y / 8) * width] & (1 << (y & 7)); }
+    const std::string& shown() const { return shownText; }
+    uint32_t frames() const { return frameCount; }
+    uint32_t bytesChanged() const { return changedBytes; }
+
+private:
+    uint8_t width;
+    uint8_t height;
+    std::vector<uint8_t> buffer;
+    std::vector<uint8_t> shownBuffer;
+    std::string text;
+    std::string shownText;
+    uint8_t textSize = 1;
+    uint16_t textColor = SSD1306_WHITE;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint32_t frameCount = 0;
+    uint32_t changedBytes = 0;
+};
+
+// -----------------------------------------------------------------
+// Task: the device's task on the other core, in simulated time
+// -----------------------------------------------------------------
+// The body runs while the main task sleeps in delay(), once it is due:
+// woken, or periodMs after its last pass ended. Time the body spends
+// (a slow request, say) is its own - the clock is put back afterwards,
+// so the main task doesn't wait for it - but the next pass can't start
+// until that one would have finished. One task per build.
+class SteppedTask {
+public:
+    bool begin(void (*body)(), uint32_t periodMs, const char*, uint8_t) {
+        this->body = body;
+        this->periodMs = periodMs;
+        nextAt = millis();
+        current() = this;
+        hostSleepHook() = [] { current()->step(); };
+        return true;
+    }
+
+    void wake() { woken = true; }
+
+private:
+    static SteppedTask*& current() {
+        static SteppedTask* task = nullptr;
+        return task;
+    }
+
+    void step() {
+        unsigned long now = millis();
+        if (running || (long)(now - busyUntil) < 0 || (!woken && (long)(now - nextAt) < 0)) return;
+        woken = false;
+        running = true;
+        uint64_t start = hostMicros();
+        body();
+        busyUntil = millis();
+        nextAt = busyUntil + periodMs;
+        hostMicros() = start;
+        running = false;
+    }
+
+    void (*body)() = nullptr;
+    uint32_t periodMs = 0;
+    unsigned long nextAt = 0;
+    unsigned long busyUntil = 0;
+    bool woken = false;
+    bool running = false;
+};
+
+typedef TraceRanger LidarRanger;
+typedef RecordingUplink LidarUplink;
+typedef FrameBufferDisplay LidarDisplay;
+typedef SteppedTask LidarTask;
+
+#endif // HAL_HOST_H
@@ -0,0 +1,15 @@
+#ifndef HOST_I2C_BUS_H
+#define HOST_I2C_BUS_H
+
+#include <Wire.h>
+
+// Host build: nothing is on a real bus, so there is nothing to queue
+class I2cBus {
+public:
+    explicit I2cBus(TwoWire&) {}
+
+    bool begin(uint32_t clockHz = 400000, uint8_t core = 1, unsigned priority = 4) { return true; }
+    void report(Print&) {}
+};
+
+#endif // HOST_I2C_BUS_H
@@ -0,0 +1,18 @@
+#ifndef HOST_WIFI_LINK_H
+#define HOST_WIFI_LINK_H
+
+#include <WiFi.h>
+
+// Host build: connecting is instant and follows WiFi.linkUp
+class WiFiLink {
+public:
+    static WiFiLink& getInstance() {
+        static WiFiLink instance;
+        return instance;
+    }
+
+    void begin(const char*, const char*) {}
+    bool waitConnected(uint32_t) { return WiFi.linkUp; }
+};
+
+#endif // HOST_WIFI_LINK_H
@@ -0,0 +1,189 @@
+// Host-side tests for the fixed-point filter chain (src/filters.h),
+// replaying the traces in ../traces.h. Run with: pio test -e native
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include "filters.h"
+#include "../traces.h"
+
+// The chain the firmware runs (see main.cpp)
+typedef FilterChain<MedianFilter<5>, KalmanFilter<4, 100>> DistanceFilter;
+
+// Samples after a level change that a filter may spend catching up
+const uint16_t SETTLE = 25;
+
+static bool settling(uint16_t i) {
+    return i < SETTLE || (i >= TRACE_ARRIVE && i < TRACE_ARRIVE + SETTLE) ||
+           (i >= TRACE_LEAVE && i < TRACE_LEAVE + SETTLE);
+}
+
+static bool isSpike(uint16_t i) {
+    for (uint8_t s = 0; s < TRACE_SPIKE_COUNT; s++) {
+        if (TRACE_SPIKES[s] == i) return true;
+    }
+    return false;
+}
+
+// RMS error against the scene level over the settled samples. With
+// despike, each spike is replaced by the sample before it, for stages
+// that aren't meant to reject spikes themselves.
+template <typename F>
+static double rmsError(F& filter, bool despike) {
+    double sum = 0;
+    uint32_t n = 0;
+    for (uint16_t i = 0; i < TRACE_LENGTH; i++) {
+        uint16_t out = filter.process(despike && isSpike(i) ? TRACE[i - 1] : TRACE[i]);
+        if (settling(i)) continue;
+        double e = (double)out - traceLevel(i);
+        sum += e * e;
+        n++;
+    }
+    return sqrt(sum / n);
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_median_rejects_isolated_spikes(void) {
+    MedianFilter<5> median;
+    for (uint16_t i = 0; i < TRACE_LENGTH; i++) {
+        uint16_t out = median.process(TRACE[i]);
+        if (i >= TRACE_ARRIVE && i < TRACE_ARRIVE + 3) continue; // Median switches half a window late
+        if (i >= TRACE_LEAVE && i < TRACE_LEAVE + 3) continue;
+        TEST_ASSERT_UINT16_WITHIN(30, traceLevel(i), out);
+    }
+}
+
+void test_median_of_one_sample_is_that_sample(void) {
+    MedianFilter<5> median;
+    TEST_ASSERT_EQUAL_UINT16(812, median.process(812));
+    median.reset();
+    TEST_ASSERT_EQUAL_UINT16(430, median.process(430));
+}
+
+void test_ema_holds_a_constant_exactly(void) {
+    EmaFilter<4> ema;
+    for (uint16_t i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL_UINT16(812, ema.process(812));
+    }
+}
+
+void test_ema_reaches_a_step_without_truncation_loss(void) {
+    EmaFilter<4> ema;
+    ema.process(812);
+    uint16_t out = 0;
+    for (uint16_t i = 0; i < 200; i++) {
+        out = ema.process(430);
+    }
+    TEST_ASSERT_EQUAL_UINT16(430, out); // Kept in whole mm it would stall short of 430
+}
+
+void test_kalman_reduces_noise(void) {
+    KalmanFilter<4, 100> kalman;
+    double raw = 0;
+    uint32_t n = 0;
+    for (uint16_t i = 0; i < TRACE_LENGTH; i++) {
+        if (settling(i) || isSpike(i)) continue;
+        double e = (double)TRACE[i] - traceLevel(i);
+        raw += e * e;
+        n++;
+    }
+    raw = sqrt(raw / n);
+
+    double filtered = rmsError(kalman, true);
+    char line[96];
+    snprintf(line, sizeof(line), "raw %.2f mm rms, kalman %.2f mm rms", raw, filtered);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(raw / 2, filtered);
+}
+
+void test_chain_keeps_spikes_out_of_min_and_max(void) {
+    DistanceFilter filter;
+    uint16_t wallMin = 65535, wallMax = 0;
+    for (uint16_t i = 0; i < TRACE_LENGTH; i++) {
+        uint16_t out = filter.process(TRACE[i]);
+        if (settling(i) || (i >= TRACE_ARRIVE && i < TRACE_LEAVE)) continue;
+        if (out < wallMin) wallMin = out;
+        if (out > wallMax) wallMax = out;
+    }
+    // Raw, the wall segments span 58..2047 mm
+    TEST_ASSERT_GREATER_OR_EQUAL(TRACE_WALL_MM - 15, wallMin);
+    TEST_ASSERT_LESS_OR_EQUAL(TRACE_WALL_MM + 5 + 15, wallMax);
+}
+
+void test_chain_follows_a_person_arriving(void) {
+    DistanceFilter filter;
+    uint16_t settledAt = 0;
+    for (uint16_t i = 0; i < TRACE_LEAVE; i++) {
+        uint16_t out = filter.process(TRACE[i]);
+        if (i >= TRACE_ARRIVE && settledAt == 0 && out < TRACE_PERSON_MM + 20) {
+            settledAt = i;
+        }
+    }
+    TEST_ASSERT_NOT_EQUAL(0, settledAt);
+    TEST_ASSERT_LESS_THAN(TRACE_ARRIVE + SETTLE, settledAt);
+}
+
+void test_chain_rms_error_on_trace(void) {
+    DistanceFilter filter;
+    double rms = rmsError(filter, false); // Spikes included
+    char line[64];
+    snprintf(line, sizeof(line), "chain %.2f mm rms, spikes included", rms);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_LESS_THAN(4.0, rms);
+}
+
+void test_chain_reset_reprimes_every_stage(void) {
+    DistanceFilter filter;
+    for (uint16_t i = 0; i < TRACE_LENGTH; i++) {
+        filter.process(TRACE[i]);
+    }
+    filter.reset();
+    TEST_ASSERT_EQUAL_UINT16(250, filter.process(250));
+}
+
+// -----------------------------------------------------------------
+// Benchmark: replays the trace through each stage and the chain
+// -----------------------------------------------------------------
+const uint32_t BENCH_PASSES = 2000;
+
+template <typename F>
+static void bench(const char* name) {
+    F filter;
+    volatile uint16_t sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t pass = 0; pass < BENCH_PASSES; pass++) {
+        for (uint16_t i = 0; i < TRACE_LENGTH; i++) {
+            sink = filter.process(TRACE[i]);
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    double ns = std::chrono::duration<double, std::nano>(elapsed).count() / ((double)BENCH_PASSES * TRACE_LENGTH);
+    char line[96];
+    snprintf(line, sizeof(line), "%-28s %7.1f ns/sample (last %u)", name, ns, (unsigned)sink);
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark_trace_replay(void) {
+    bench<MedianFilter<5>>("MedianFilter<5>");
+    bench<EmaFilter<2>>("EmaFilter<2>");
+    bench<KalmanFilter<4, 100>>("KalmanFilter<4, 100>");
+    bench<DistanceFilter>("firmware chain");
+    bench<FilterChain<MedianFilter<5>, EmaFilter<2>, KalmanFilter<4, 100>>>("median + ema + kalman");
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_median_rejects_isolated_spikes);
+    RUN_TEST(test_median_of_one_sample_is_that_sample);
+    RUN_TEST(test_ema_holds_a_constant_exactly);
+    RUN_TEST(test_ema_reaches_a_step_without_truncation_loss);
+    RUN_TEST(test_kalman_reduces_noise);
+    RUN_TEST(test_chain_keeps_spikes_out_of_min_and_max);
+    RUN_TEST(test_chain_follows_a_person_arriving);
+    RUN_TEST(test_chain_rms_error_on_trace);
+    RUN_TEST(test_chain_reset_reprimes_every_stage);
+    RUN_TEST(test_benchmark_trace_replay);
+    return UNITY_END();
+}
@@ -0,0 +1,254 @@
+// Host build of the firmware's setup() / loop() (src/main.cpp) against
+// the fakes in ../host: the trace in ../traces.h replayed through the
+// sampling, stats, display and upload code in simulated time.
+// Run with: pio test -e native
+//
+// The tests share one boot of the firmware and run in order, each
+// picking up where the previous one left the scene.
+#include <unity.h>
+#include <stdlib.h>
+#include <chrono>
+#include "hal.h"
+#include "../traces.h"
+
+void setup();
+void loop();
+extern LidarUplink uplink;
+extern LidarDisplay display;
+
+// Runs the loop until cond() holds, or for at most limitMs of simulated time
+template <typename Cond>
+static bool runUntil(Cond cond, unsigned long limitMs) {
+    unsigned long start = millis();
+    while (!cond()) {
+        if (millis() - start > limitMs) return false;
+        loop();
+    }
+    return true;
+}
+
+static void runFor(unsigned long ms) {
+    runUntil([] { return false; }, ms);
+}
+
+// Number after "key": in a compact JSON payload, searching from the
+// first occurrence of section (nullptr: the start)
+static long jsonNumber(const String& payload, const char* section, const char* key) {
+    const char* from = payload.c_str();
+    if (section) {
+        from = strstr(from, section);
+        TEST_ASSERT_NOT_NULL(from);
+    }
+    char quoted[32];
+    snprintf(quoted, sizeof(quoted), "\"%s\":", key);
+    const char* at = strstr(from, quoted);
+    TEST_ASSERT_NOT_NULL(at);
+    return strtol(at + strlen(quoted), nullptr, 10);
+}
+
+static const RecordingUplink::Request* lastRequest(const char* path) {
+    for (size_t i = uplink.requests.size(); i > 0; i--) {
+        if (uplink.requests[i - 1].path == path) return &uplink.requests[i - 1];
+    }
+    return nullptr;
+}
+
+static std::vector<RecordingUplink::Request> requestsSince(const char* path, size_t first) {
+    std::vector<RecordingUplink::Request> found;
+    for (size_t i = first; i < uplink.requests.size(); i++) {
+        if (uplink.requests[i].path == path) found.push_back(uplink.requests[i]);
+    }
+    return found;
+}
+
+static bool showing(const char* text) {
+    return display.shown().find(text) != std::string::npos;
+}
+
+// Empty scene for the static-scene and offline tests: the trace's last,
+// person-free, stretch
+static const uint16_t* const WALL_ONLY = TRACE + TRACE_LEAVE;
+static const uint16_t WALL_ONLY_LENGTH = TRACE_LENGTH - TRACE_LEAVE;
+
+static size_t arrivalStart = 0;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_setup_reports_the_sensor_ready(void) {
+    TEST_ASSERT_TRUE(showing("VL53L0X Ready!"));
+    TEST_ASSERT_EQUAL_UINT32(0, TraceRanger::played());
+}
+
+void test_samples_arrive_at_the_timing_budget_rate(void) {
+    // The sensor started ranging during setup(), which then waited on
+    // the splash screen; those results were overwritten, as on the device
+    TEST_ASSERT_TRUE(runUntil([] { return TraceRanger::samples() >= 1; }, 1000));
+    uint32_t missed = TraceRanger::missed();
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE(runUntil([] { return TraceRanger::samples() >= 121; }, 10000));
+    TEST_ASSERT_UINT32_WITHIN(40, 120 * 33, millis() - start);
+    TEST_ASSERT_EQUAL_UINT32(missed, TraceRanger::missed());
+    TEST_ASSERT_LESS_THAN(TRACE_ARRIVE - 40, TraceRanger::played()); // Still the empty scene
+}
+
+void test_display_shows_the_filtered_distance(void) {
+    runFor(200);
+    TEST_ASSERT_TRUE(showing("LIDAR [OK]"));
+    TEST_ASSERT_TRUE(showing(" mm"));
+    TEST_ASSERT_TRUE(showing("10s m:"));
+    TEST_ASSERT_TRUE(display.pixel(0, 52)); // Distance bar frame
+    TEST_ASSERT_TRUE(display.pixel(2, 54)); // ... and its fill
+
+    // DISPLAY_INTERVAL is 50 ms; only changed bytes count as sent
+    uint32_t frames = display.frames();
+    uint32_t changed = display.bytesChanged();
+    runFor(1000);
+    TEST_ASSERT_UINT32_WITHIN(2, 20, display.frames() - frames);
+    TEST_ASSERT_LESS_THAN(20 * 1024, display.bytesChanged() - changed);
+    arrivalStart = uplink.requests.size();
+}
+
+void test_person_arriving_is_uploaded_as_change_events(void) {
+    // Through the arrival and until the events have settled
+    TEST_ASSERT_TRUE(runUntil([] { return TraceRanger::played() >= TRACE_ARRIVE + 90; }, 10000));
+    std::vector<RecordingUplink::Request> events = requestsSince("/events.json", arrivalStart);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, events.size());
+    TEST_ASSERT_UINT16_WITHIN(20, TRACE_WALL_MM, jsonNumber(events.front().payload, nullptr, "from"));
+    // The detector trips more than once on the way down; the trips
+    // inside the holdoff go out later, so the last one reaches the person
+    TEST_ASSERT_UINT16_WITHIN(30, TRACE_PERSON_MM, jsonNumber(events.back().payload, nullptr, "to"));
+    for (size_t i = 1; i < events.size(); i++) {
+        TEST_ASSERT_GREATER_OR_EQUAL(1000, events[i].atMs - events[i - 1].atMs); // EVENT_HOLDOFF
+    }
+    TEST_ASSERT_TRUE(showing("LIDAR [OK]"));
+}
+
+void test_stats_upload_carries_the_scene_not_the_spikes(void) {
+    TEST_ASSERT_TRUE(runUntil([] { return uplink.count("/history.json") >= 1; }, 15000));
+    const RecordingUplink::Request* latest = lastRequest("/latest.json");
+    TEST_ASSERT_NOT_NULL(latest);
+    TEST_ASSERT_EQUAL_STRING("PUT", latest->method.c_str());
+
+    // The window spans the wall and the person; raw it also holds
+    // spikes from 66 to 1904 mm
+    long min = jsonNumber(latest->payload, "ten_second", "min_mm");
+    long max = jsonNumber(latest->payload, "ten_second", "max_mm");
+    TEST_ASSERT_UINT16_WITHIN(20, TRACE_PERSON_MM, min);
+    TEST_ASSERT_UINT16_WITHIN(20, TRACE_WALL_MM, max);
+    TEST_ASSERT_UINT16_WITHIN(20, TRACE_PERSON_MM, jsonNumber(latest->payload, "one_second", "avg_mm"));
+
+    const RecordingUplink::Request* history = lastRequest("/history.json");
+    long seconds = jsonNumber(history->payload, nullptr, "seconds");
+    TEST_ASSERT_UINT_WITHIN(1, 10, seconds);
+    TEST_ASSERT_EQUAL(min, jsonNumber(history->payload, nullptr, "min_mm"));
+    TEST_ASSERT_EQUAL(max, jsonNumber(history->payload, nullptr, "max_mm"));
+}
+
+void test_person_leaving_is_uploaded_as_change_events(void) {
+    size_t first = uplink.requests.size();
+    TEST_ASSERT_TRUE(runUntil([] { return TraceRanger::played() >= TRACE_LEAVE + 90; }, 15000));
+    std::vector<RecordingUplink::Request> events = requestsSince("/events.json", first);
+    TEST_ASSERT_GREATER_OR_EQUAL(1, events.size());
+    TEST_ASSERT_UINT16_WITHIN(30, TRACE_PERSON_MM, jsonNumber(events.front().payload, nullptr, "from"));
+    TEST_ASSERT_UINT16_WITHIN(30, TRACE_WALL_MM, jsonNumber(events.back().payload, nullptr, "to"));
+}
+
+void test_static_scene_stretches_the_upload_interval(void) {
+    TraceRanger::play(WALL_ONLY, WALL_ONLY_LENGTH);
+    runFor(20000); // Let the last of the person leave the 10 s window
+    size_t first = uplink.requests.size();
+    runFor(240000);
+    std::vector<RecordingUplink::Request> uploads = requestsSince("/history.json", first);
+    TEST_ASSERT_GREATER_OR_EQUAL(4, uploads.size());
+    TEST_ASSERT_EQUAL(0, requestsSince("/events.json", first).size());
+
+    // 10 s doubling to the 60 s cap, never beyond
+    unsigned long longest = 0;
+    for (size_t i = 1; i < uploads.size(); i++) {
+        unsigned long gap = uploads[i].atMs - uploads[i - 1].atMs;
+        TEST_ASSERT_LESS_OR_EQUAL(60000 + 50, gap);
+        if (gap > longest) longest = gap;
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(60000, longest);
+    TEST_ASSERT_UINT_WITHIN(1, 60, jsonNumber(uploads.back().payload, nullptr, "seconds"));
+}
+
+void test_offline_uploads_nothing_and_says_so(void) {
+    WiFi.linkUp = false;
+    size_t first = uplink.requests.size();
+    runFor(90000);
+    TEST_ASSERT_EQUAL(first, uplink.requests.size());
+    TEST_ASSERT_TRUE(showing("LIDAR [--]"));
+    TEST_ASSERT_TRUE(showing(" mm"));
+    // The buffer holds more seconds than an interval; past the due
+    // upload the header shows them rather than a negative countdown
+    TEST_ASSERT_TRUE(showing("60s buf"));
+    TEST_ASSERT_FALSE(showing("T--"));
+
+    WiFi.linkUp = true;
+    TEST_ASSERT_TRUE(runUntil([&] { return uplink.requests.size() > first; }, 61000));
+}
+
+// -----------------------------------------------------------------
+// Benchmark: loop() iterations per second and worst-case latency
+// -----------------------------------------------------------------
+// Host CPU time per loop() call (the firmware's own work, with the
+// fakes costing next to nothing; on the host that includes the uplink
+// task's passes), and the loop period in simulated time, which
+// includes the 5 ms delay() but not the uplink's requests, since those
+// run on the other core.
+static void benchLoop(const char* name, uint32_t uploadLatencyMs, uint32_t iterations) {
+    uplink.latencyMs = uploadLatencyMs;
+    TraceRanger::play(TRACE, TRACE_LENGTH);
+    uint32_t missedBefore = TraceRanger::missed();
+    uint32_t samplesBefore = TraceRanger::samples();
+    unsigned long simStart = millis();
+
+    typedef std::chrono::steady_clock Clock;
+    double worstUs = 0;
+    unsigned long worstSimMs = 0;
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        unsigned long simBefore = millis();
+        Clock::time_point before = Clock::now();
+        loop();
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - before).count();
+        if (us > worstUs) worstUs = us;
+        if (millis() - simBefore > worstSimMs) worstSimMs = millis() - simBefore;
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double simSeconds = (millis() - simStart) / 1000.0;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%s: host %.0f loops/s (avg %.2f us, worst %.1f us)", name, iterations / seconds,
+             seconds * 1e6 / iterations, worstUs);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "%s: simulated %.1f loops/s, worst period %lu ms, %lu samples, %lu overwritten",
+             name, iterations / simSeconds, worstSimMs, (unsigned long)(TraceRanger::samples() - samplesBefore),
+             (unsigned long)(TraceRanger::missed() - missedBefore));
+    TEST_MESSAGE(line);
+    uplink.latencyMs = 0;
+}
+
+void test_benchmark_loop(void) {
+    benchLoop("instant uplink", 0, 200000);
+    benchLoop("300 ms uplink", 300, 200000);
+}
+
+int main(int argc, char** argv) {
+    TraceRanger::play(TRACE, TRACE_LENGTH);
+    setup();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_setup_reports_the_sensor_ready);
+    RUN_TEST(test_samples_arrive_at_the_timing_budget_rate);
+    RUN_TEST(test_display_shows_the_filtered_distance);
+    RUN_TEST(test_person_arriving_is_uploaded_as_change_events);
+    RUN_TEST(test_stats_upload_carries_the_scene_not_the_spikes);
+    RUN_TEST(test_person_leaving_is_uploaded_as_change_events);
+    RUN_TEST(test_static_scene_stretches_the_upload_interval);
+    RUN_TEST(test_offline_uploads_nothing_and_says_so);
+    RUN_TEST(test_benchmark_loop);
+    return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#ifndef TRACES_H
+#define TRACES_H
+
+#include <stdint.h>
+
+// =================================================================
+// --- Distance traces for host-side replay ---
+// =================================================================
+// One VL53L0X in long range mode at ~30 Hz, looking at a wall:
+//   [0, 200)    empty scene, wall at 812 mm, ~6 mm noise
+//   [200, 400)  someone standing in front of it at 430 mm, ~4 mm noise
+//   [400, 600)  empty again, the reading drifting up 1 mm every 40
+//               samples as the sensor warms
+// with the sensor's isolated spikes mixed in: multipath returns far
+// behind the wall and cross-talk returns off the cover glass.
+//
+// Generated (seeded, so it never changes) to match what the sensor
+// reports, so the expected levels below are exact.
+
+const uint16_t TRACE_WALL_MM = 812;
+const uint16_t TRACE_PERSON_MM = 430;
+const uint16_t TRACE_ARRIVE = 200;      // First sample with the person
+const uint16_t TRACE_LEAVE = 400;       // First sample without
+const uint16_t TRACE_LENGTH = 600;
+
+// Samples that are spikes rather than the scene
+const uint16_t TRACE_SPIKES[] = {37, 91, 150, 255, 333, 460, 521, 577};
+const uint8_t TRACE_SPIKE_COUNT = sizeof(TRACE_SPIKES) / sizeof(TRACE_SPIKES[0]);
+
+// Level of the scene (no noise, no spikes) at sample i
+inline uint16_t traceLevel(uint16_t i) {
+    if (i < TRACE_ARRIVE) return TRACE_WALL_MM;
+    if (i < TRACE_LEAVE) return TRACE_PERSON_MM;
+    return TRACE_WALL_MM + (i - TRACE_LEAVE) / 40;
+}
+
+const uint16_t TRACE[TRACE_LENGTH] = {
+     812,  808,  814,  820,  822,  816,  812,  810,  809,  806,  802,  801,
+     818,  811,  818,  803,  813,  812,  816,  810,  818,  818,  820,  799,
+     805,  820,  827,  815,  810,  819,  813,  813,  820,  812,  802,  808,
+     816, 1904,  814,  809,  815,  809,  817,  810,  805,  815,  814,  813,
+     803,  809,  818,  814,  805,  820,  815,  812,  809,  811,  815,  798,
+     810,  804,  815,  813,  812,  814,  822,  823,  804,  823,  813,  802,
+     820,  807,  808,  818,  811,  813,  819,  814,  796,  810,  804,  804,
+     804,  813,  813,  811,  818,  813,  810,   66,  815,  813,  819,  817,
+     813,  812,  809,  806,  826,  814,  798,  813,  808,  806,  810,  814,
+     818,  811,  811,  815,  798,  802,  803,  818,  810,  805,  806,  804,
+     814,  811,  815,  816,  816,  814,  808,  814,  811,  812,  820,  807,
+     815,  815,  812,  809,  812,  810,  805,  806,  802,  809,  828,  806,
+     819,  814,  819,  819,  813,  815, 1311,  812,  812,  816,  801,  810,
+     811,  807,  812,  822,  811,  821,  820,  811,  810,  812,  811,  827,
+     814,  813,  808,  809,  808,  809,  813,  816,  810,  803,  821,  814,
+     813,  805,  813,  813,  815,  812,  814,  812,  831,  800,  813,  798,
+     813,  810,  806,  818,  808,  803,  811,  809,  422,  436,  428,  428,
+     421,  435,  430,  432,  432,  425,  427,  433,  429,  436,  428,  435,
+     435,  427,  429,  432,  429,  430,  431,  426,  427,  431,  429,  426,
+     427,  431,  431,  431,  431,  437,  429,  428,  433,  431,  429,  427,
+     428,  431,  431,  425,  419,  434,  427,  430,  426,  421,  424,  424,
+     427,  429,  429, 1908,  435,  430,  433,  431,  424,  424,  433,  428,
+     434,  427,  423,  426,  429,  425,  434,  430,  430,  426,  438,  431,
+     426,  435,  428,  433,  426,  427,  435,  428,  427,  434,  430,  423,
+     435,  430,  434,  427,  431,  432,  423,  428,  430,  426,  433,  431,
+     426,  427,  428,  432,  428,  431,  429,  428,  435,  438,  434,  431,
+     428,  430,  425,  436,  430,  426,  428,  432,  432,  427,  430,  420,
+     429,  436,  432,  425,  433,  429,  426,  431,  428,   71,  433,  431,
+     433,  430,  426,  423,  430,  433,  429,  429,  423,  425,  437,  425,
+     423,  431,  436,  428,  430,  437,  426,  430,  434,  436,  429,  429,
+     430,  431,  424,  428,  429,  432,  426,  433,  432,  430,  425,  423,
+     429,  429,  427,  430,  427,  429,  430,  440,  427,  433,  434,  430,
+     428,  433,  434,  436,  435,  428,  429,  429,  434,  432,  436,  432,
+     428,  422,  427,  433,  818,  814,  816,  810,  805,  808,  813,  817,
+     821,  819,  820,  804,  813,  811,  816,  815,  817,  819,  808,  809,
+     813,  812,  813,  816,  817,  814,  804,  797,  808,  811,  804,  811,
+     816,  820,  818,  806,  818,  817,  821,  810,  810,  817,  814,  808,
+     828,  810,  810,  811,  807,  808,  815,  813,  807,  814,  820,  820,
+     810,  809,  814,  805, 2047,  820,  814,  814,  810,  806,  809,  818,
+     811,  810,  811,  810,  817,  811,  807,  807,  816,  815,  828,  806,
+     821,  804,  819,  812,  815,  818,  812,  817,  807,  820,  812,  814,
+     817,  810,  816,  812,  819,  814,  805,  803,  804,  811,  819,  815,
+     810,  815,  816,  815,  816,  818,  813,  815,  804,  808,  812,  810,
+     803,  815,  811,  821,  811,   58,  806,  821,  816,  812,  811,  805,
+     813,  813,  820,  812,  807,  816,  815,  817,  823,  813,  816,  816,
+     815,  813,  821,  814,  814,  806,  821,  813,  820,  811,  811,  821,
+     815,  820,  811,  804,  820,  821,  812,  808,  815,  806,  814,  816,
+     817,  812,  825,  825,  821,  812,  810,  816,  817,  809,  827,  810,
+     817, 1502,  809,  814,  817,  818,  819,  822,  804,  813,  815,  812,
+     803,  826,  819,  819,  806,  824,  813,  827,  815,  815,  823,  822,
+};
+
+#endif // TRACES_H
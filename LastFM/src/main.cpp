@@ -1,6 +1,7 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <wifi_link.h>
 
 // Replace with your Wi-Fi credentials
 const char* ssid = "JioFiber_401_2.4Gz";
@@ -17,9 +18,8 @@ void setup() {
   delay(1000);
 
   // Connect to Wi-Fi
-  WiFi.begin(ssid, password);
-  while (WiFi.status() != WL_CONNECTED) {
-    delay(1000);
+  WiFiLink::getInstance().begin(ssid, password);
+  while (!WiFiLink::getInstance().waitConnected(1000)) {
     Serial.println("Connecting to WiFi...");
   }
   Serial.println("Connected to Wi-Fi");
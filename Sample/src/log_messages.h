@@ -0,0 +1,24 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+// Interned log messages.
+// Only the ID (and one integer argument, for %d) is recorded and sent;
+// tools/log_decode.py expands IDs back to text from this table.
+// IDs are positional - only ever append new messages at the end.
+#define LOG_MESSAGES(X) \
+    X(LOG_NONE,                "No log") \
+    X(LOG_SENSOR_TEST,         "DHT Temperature and Humidity Sensor Test") \
+    X(LOG_SENSOR_DISPLAY,      "DHT Sensor with OLED Display") \
+    X(LOG_SSD1306_FAILED,      "SSD1306 allocation failed") \
+    X(LOG_WIFI_CONNECTING,     "Connecting to WiFi...") \
+    X(LOG_WIFI_CONNECTED,      "Connected to WiFi") \
+    X(LOG_TIME_SYNC_STARTED,   "Time sync started...") \
+    X(LOG_TIME_FAILED,         "Failed to obtain time") \
+    X(LOG_TIME_SYNCED,         "Time synced") \
+    X(LOG_BOOTING,             "Booting...") \
+    X(LOG_DHT_READ_FAILED,     "Failed to read from DHT sensor!") \
+    X(LOG_SENSOR_ERROR,        "Error in reading sensor") \
+    X(LOG_DHT_VALUES_SET,      "DHT values set") \
+    X(LOG_DHT_VALUES_SENT,     "DHT values sent")
+
+#endif // LOG_MESSAGES_H
@@ -1,52 +1,18 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
-#include <queue>
-#include <string>
-#include <mutex>
-#include <ArduinoJson.h>
+#include <queue_logger.h>
+#include "log_messages.h"
 
-class Logger
-{
-    public:
-        // Singleton pattern to ensure only one instance of Logger
-        static Logger& getInstance()
-        {
-            static Logger instance;
-            return instance;
-        }
-
-        // Add a log message to the queue
-        void log(const std::string& message)
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            logQueue.push(message);
-        }
-
-        // Retrieve and remove the oldest log message from the queue
-        bool getLog(std::string& message)
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (logQueue.empty())
-            {
-                message = "No log";
-                return false;
-            }
-            message = logQueue.front();
-            logQueue.pop();
-            return true;
-        }
-
-    private:
-        // Private constructor to prevent instantiation
-        Logger() {}
+#define LOG_AS_ID(id, format) id,
 
-        // Disable copy constructor and assignment operator
-        Logger(const Logger&) = delete;
-        Logger& operator=(const Logger&) = delete;
-
-        std::queue<std::string> logQueue;
-        std::mutex mutex_;
+enum LogId : uint8_t
+{
+    LOG_MESSAGES(LOG_AS_ID)
+    LOG_ID_COUNT
 };
 
-#endif // LOGGER_H
\ No newline at end of file
+// Shared queue logger, instantiated for this firmware's message table
+typedef QueueLogger<LogId, LOG_NONE> Logger;
+
+#endif // LOGGER_H
@@ -0,0 +1,344 @@
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+#ifndef ALERT_RULES
+// metric [rate] >|< value [for s] [hyst delta] [cooldown s]; ...
+// Metrics are temp (degC), humidity (%RH) and sound (dBA); rate is per minute.
+#define ALERT_RULES "temp > 35 for 60 hyst 1 cooldown 600;" \
+                    "temp < 5 for 60 hyst 1 cooldown 600;" \
+                    "humidity > 80 for 300 hyst 3 cooldown 1800;" \
+                    "temp rate > 3 cooldown 600;" \
+                    "temp rate < -3 cooldown 600"
+#endif
+
+#ifndef ALERT_MAX_RULES
+#define ALERT_MAX_RULES 16
+#endif
+
+#ifndef ALERT_RATE_WINDOW
+#define ALERT_RATE_WINDOW 60000     // ms of samples behind a rate
+#endif
+
+#define ALERT_RATE_SAMPLES 64       // Ring per metric; covers the window at 1 s sampling
+
+enum AlertMetric : uint8_t
+{
+    ALERT_TEMP,
+    ALERT_HUMIDITY,
+    ALERT_SOUND,
+    ALERT_METRIC_COUNT
+};
+
+// A rule changing state; only these are reported
+struct AlertEvent
+{
+    uint8_t rule;
+    bool firing;                    // false: resolved
+    float value;                    // The value that caused the transition
+};
+
+// Alert rules evaluated on every sample. The rule text is compiled once
+// at startup into a flat table; evaluating a sample is then one pass
+// over that table with no parsing, allocation or string work.
+//
+// Each rule is a small state machine:
+//
+//   Idle -> Pending  condition true
+//   Pending -> Firing  still true after "for" seconds (at once without "for")
+//   Firing -> Cooldown  value back past threshold by "hyst"; reports resolved
+//   Cooldown -> Idle  "cooldown" seconds later
+//
+// Only Firing and resolved transitions produce events, so a sample that
+// changes nothing costs no network traffic, and an alert goes out on the
+// sample that crosses its threshold (or ends its "for").
+//
+// Pure C++ with no Arduino dependency, so rules can be tested on a host.
+class AlertEngine
+{
+public:
+    AlertEngine() : count_(0), rateCount_(0), rateHead_(0) {}
+
+    // Compiles rules separated by ';'. Returns the number of rules that
+    // failed to parse; those are skipped and the rest still run.
+    uint8_t begin(const char* rules = ALERT_RULES)
+    {
+        count_ = 0;
+        uint8_t failed = 0;
+        char text[48];
+        const char* p = rules;
+        while (*p)
+        {
+            const char* end = strchr(p, ';');
+            size_t length = end ? (size_t)(end - p) : strlen(p);
+            if (length >= sizeof(text) || count_ == ALERT_MAX_RULES)
+            {
+                failed++;
+            }
+            else
+            {
+                memcpy(text, p, length);
+                text[length] = '\0';
+                if (blank(text))
+                {
+                    // Empty rule, e.g. a trailing ';'
+                }
+                else if (compile(text, rules_[count_]))
+                {
+                    describe(rules_[count_], descriptions_[count_], sizeof(descriptions_[count_]));
+                    count_++;
+                }
+                else
+                {
+                    failed++;
+                }
+            }
+            p += length;
+            if (*p == ';')
+            {
+                p++;
+            }
+        }
+        return failed;
+    }
+
+    // Evaluates every rule against one sample. Calls onEvent(const
+    // AlertEvent&) for each transition; returns how many there were.
+    template <class OnEvent>
+    uint8_t evaluate(uint32_t nowMs, float tempC, float humidity, float dbA, OnEvent&& onEvent)
+    {
+        float inputs[2 * ALERT_METRIC_COUNT] = {tempC, humidity, dbA};
+        bool rateValid = updateRates(nowMs, inputs, inputs + ALERT_METRIC_COUNT);
+
+        uint8_t events = 0;
+        for (uint8_t i = 0; i < count_; i++)
+        {
+            Rule& rule = rules_[i];
+            if (rule.input >= ALERT_METRIC_COUNT && !rateValid)
+            {
+                continue;
+            }
+            float value = inputs[rule.input];
+            if (isnan(value))
+            {
+                continue;
+            }
+            bool over = rule.above ? value > rule.threshold : value < rule.threshold;
+
+            if (rule.state == Cooldown && nowMs - rule.since >= rule.cooldownMs)
+            {
+                rule.state = Idle;
+            }
+            switch (rule.state)
+            {
+            case Idle:
+                if (over)
+                {
+                    rule.state = Pending;
+                    rule.since = nowMs;
+                }
+                else
+                {
+                    break;
+                }
+                // Fall through - a rule without "for" fires on this sample
+            case Pending:
+                if (!over)
+                {
+                    rule.state = Idle;
+                }
+                else if (nowMs - rule.since >= rule.forMs)
+                {
+                    rule.state = Firing;
+                    onEvent(AlertEvent{i, true, value});
+                    events++;
+                }
+                break;
+            case Firing:
+                if (rule.above ? value < rule.release : value > rule.release)
+                {
+                    rule.state = Cooldown;
+                    rule.since = nowMs;
+                    onEvent(AlertEvent{i, false, value});
+                    events++;
+                }
+                break;
+            case Cooldown:
+                break;
+            }
+        }
+        return events;
+    }
+
+    uint8_t count() const
+    {
+        return count_;
+    }
+
+    // Canonical text of a compiled rule, e.g. "temp > 35 for 60s"
+    const char* describe(uint8_t rule) const
+    {
+        return rule < count_ ? descriptions_[rule] : "";
+    }
+
+    bool firing(uint8_t rule) const
+    {
+        return rule < count_ && rules_[rule].state == Firing;
+    }
+
+private:
+    enum State : uint8_t
+    {
+        Idle,
+        Pending,
+        Firing,
+        Cooldown
+    };
+
+    // One row of the evaluation table
+    struct Rule
+    {
+        uint8_t input;              // Metric, or ALERT_METRIC_COUNT + metric for its rate
+        bool above;
+        State state;
+        float threshold;
+        float release;              // threshold -/+ hysteresis
+        uint32_t forMs;
+        uint32_t cooldownMs;
+        uint32_t since;             // Pending start or Cooldown start
+    };
+
+    static bool blank(const char* text)
+    {
+        return text[strspn(text, " \t")] == '\0';
+    }
+
+    static bool compile(char* text, Rule& rule)
+    {
+        static const char* const names[ALERT_METRIC_COUNT] = {"temp", "humidity", "sound"};
+        char* save = nullptr;
+        char* token = strtok_r(text, " \t", &save);
+        rule.input = ALERT_METRIC_COUNT;
+        for (uint8_t m = 0; token && m < ALERT_METRIC_COUNT; m++)
+        {
+            if (strcmp(token, names[m]) == 0)
+            {
+                rule.input = m;
+            }
+        }
+        if (rule.input == ALERT_METRIC_COUNT)
+        {
+            return false;
+        }
+
+        token = strtok_r(nullptr, " \t", &save);
+        if (token && strcmp(token, "rate") == 0)
+        {
+            rule.input += ALERT_METRIC_COUNT;
+            token = strtok_r(nullptr, " \t", &save);
+        }
+        if (!token || (strcmp(token, ">") != 0 && strcmp(token, "<") != 0))
+        {
+            return false;
+        }
+        rule.above = token[0] == '>';
+        if (!number(strtok_r(nullptr, " \t", &save), rule.threshold))
+        {
+            return false;
+        }
+
+        float forS = 0, hysteresis = 0, cooldownS = 0;
+        while ((token = strtok_r(nullptr, " \t", &save)) != nullptr)
+        {
+            float* target = strcmp(token, "for") == 0        ? &forS
+                            : strcmp(token, "hyst") == 0     ? &hysteresis
+                            : strcmp(token, "cooldown") == 0 ? &cooldownS
+                                                             : nullptr;
+            if (!target || !number(strtok_r(nullptr, " \t", &save), *target) || *target < 0)
+            {
+                return false;
+            }
+        }
+        rule.release = rule.above ? rule.threshold - hysteresis : rule.threshold + hysteresis;
+        rule.forMs = (uint32_t)(forS * 1000);
+        rule.cooldownMs = (uint32_t)(cooldownS * 1000);
+        rule.state = Idle;
+        rule.since = 0;
+        return true;
+    }
+
+    static bool number(const char* token, float& value)
+    {
+        if (!token)
+        {
+            return false;
+        }
+        char* end;
+        value = strtof(token, &end);
+        return end != token && *end == '\0';
+    }
+
+    static void describe(const Rule& rule, char* out, size_t size)
+    {
+        static const char* const names[ALERT_METRIC_COUNT] = {"temp", "humidity", "sound"};
+        bool rate = rule.input >= ALERT_METRIC_COUNT;
+        int n = snprintf(out, size, "%s%s %c %g", names[rule.input % ALERT_METRIC_COUNT], rate ? " rate" : "",
+                         rule.above ? '>' : '<', rule.threshold);
+        if (rule.forMs > 0 && n > 0 && (size_t)n < size)
+        {
+            snprintf(out + n, size - n, " for %lus", (unsigned long)(rule.forMs / 1000));
+        }
+    }
+
+    // Per-minute rate of each metric over ALERT_RATE_WINDOW. Returns false
+    // until the ring spans at least half the window.
+    bool updateRates(uint32_t nowMs, const float* values, float* rates)
+    {
+        RateSample& sample = rateRing_[rateHead_];
+        sample.ms = nowMs;
+        memcpy(sample.values, values, sizeof(sample.values));
+        rateHead_ = (rateHead_ + 1) % ALERT_RATE_SAMPLES;
+        if (rateCount_ < ALERT_RATE_SAMPLES)
+        {
+            rateCount_++;
+        }
+
+        // Oldest sample still inside the window
+        uint8_t oldest = (rateHead_ + ALERT_RATE_SAMPLES - rateCount_) % ALERT_RATE_SAMPLES;
+        while (nowMs - rateRing_[oldest].ms > ALERT_RATE_WINDOW)
+        {
+            oldest = (oldest + 1) % ALERT_RATE_SAMPLES;
+            rateCount_--;
+        }
+        uint32_t elapsed = nowMs - rateRing_[oldest].ms;
+        if (elapsed < ALERT_RATE_WINDOW / 2)
+        {
+            return false;
+        }
+        for (uint8_t m = 0; m < ALERT_METRIC_COUNT; m++)
+        {
+            rates[m] = (values[m] - rateRing_[oldest].values[m]) * 60000.0f / elapsed;
+        }
+        return true;
+    }
+
+    struct RateSample
+    {
+        uint32_t ms;
+        float values[ALERT_METRIC_COUNT];
+    };
+
+    Rule rules_[ALERT_MAX_RULES];
+    char descriptions_[ALERT_MAX_RULES][40];
+    uint8_t count_;
+    RateSample rateRing_[ALERT_RATE_SAMPLES];
+    uint8_t rateCount_;
+    uint8_t rateHead_;
+};
+
+#endif // ALERTS_H
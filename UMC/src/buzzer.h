@@ -24,10 +24,44 @@ public:
         ledcWrite(0, 0); // Stop the tone
     }
 
+    // Non-blocking: starts the tone, update() stops it once duration has passed
+    void start(int frequency, int duration)
+    {
+        pinMode(BUZZER_PIN, OUTPUT);
+        ledcSetup(0, frequency, 8);
+        ledcAttachPin(BUZZER_PIN, 0);
+        ledcWrite(0, 127);
+        stopAt_ = millis() + duration;
+        playing_ = true;
+    }
+
+    void update()
+    {
+        if (playing_ && (int32_t)(millis() - stopAt_) >= 0)
+        {
+            ledcWrite(0, 0);
+            playing_ = false;
+        }
+    }
+
+    // ms until update() has something to do, UINT32_MAX while silent
+    uint32_t msUntilUpdate() const
+    {
+        if (!playing_)
+        {
+            return UINT32_MAX;
+        }
+        int32_t left = (int32_t)(stopAt_ - millis());
+        return left > 0 ? left : 0;
+    }
+
 private:
-    Buzzer() {} // Private constructor
+    Buzzer() : stopAt_(0), playing_(false) {} // Private constructor
     Buzzer(const Buzzer&) = delete;
     Buzzer& operator=(const Buzzer&) = delete;
+
+    uint32_t stopAt_;
+    bool playing_;
 };
 
 #endif // BUZZER_H
\ No newline at end of file
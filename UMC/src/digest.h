@@ -0,0 +1,120 @@
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <Arduino.h>
+#include <float.h>
+
+// Aggregates readings over a window so one message can summarise many
+// samples (min / avg / max of temperature and humidity, plus count).
+class TelemetryDigest
+{
+public:
+    TelemetryDigest()
+    {
+        reset();
+    }
+
+    void add(float tempC, float humidity)
+    {
+        if (tempC < tempMin_) tempMin_ = tempC;
+        if (tempC > tempMax_) tempMax_ = tempC;
+        if (humidity < humMin_) humMin_ = humidity;
+        if (humidity > humMax_) humMax_ = humidity;
+        tempSum_ += tempC;
+        humSum_ += humidity;
+        count_++;
+    }
+
+    uint32_t count() const
+    {
+        return count_;
+    }
+
+    // Telegram markdown text, lines separated by %0A
+    String format(uint32_t windowMs, const char* lastLog) const
+    {
+        String s;
+        s += "*Digest: *";
+        s += String(count_);
+        s += " readings / ";
+        s += String(windowMs / 1000);
+        s += "s";
+        if (count_ > 0)
+        {
+            s += "%0A*Temperature: *";
+            s += String(tempMin_) + " / " + String(tempSum_ / count_) + " / " + String(tempMax_);
+            s += "%0A*Humidity: *";
+            s += String(humMin_) + " / " + String(humSum_ / count_) + " / " + String(humMax_);
+        }
+        s += "%0A*Log: *";
+        s += lastLog;
+        return s;
+    }
+
+    void reset()
+    {
+        tempMin_ = FLT_MAX;
+        tempMax_ = -FLT_MAX;
+        humMin_ = FLT_MAX;
+        humMax_ = -FLT_MAX;
+        tempSum_ = 0;
+        humSum_ = 0;
+        count_ = 0;
+    }
+
+private:
+    float tempMin_, tempMax_, humMin_, humMax_;
+    float tempSum_, humSum_;
+    uint32_t count_;
+};
+
+// Classic token bucket: holds up to `capacity` tokens and refills one
+// every `refillMs`. Each message spends one token.
+class TokenBucket
+{
+public:
+    TokenBucket(uint8_t capacity, uint32_t refillMs)
+        : capacity_(capacity), refillMs_(refillMs), tokens_(capacity), lastRefill_(0) {}
+
+    bool take(uint32_t now)
+    {
+        refill(now);
+        if (tokens_ == 0)
+        {
+            return false;
+        }
+        tokens_--;
+        return true;
+    }
+
+    // ms until the next token is available (0 if one is available now)
+    uint32_t wait(uint32_t now)
+    {
+        refill(now);
+        return tokens_ > 0 ? 0 : refillMs_ - (now - lastRefill_);
+    }
+
+private:
+    void refill(uint32_t now)
+    {
+        uint32_t elapsed = now - lastRefill_;
+        if (elapsed < refillMs_)
+        {
+            return;
+        }
+        uint32_t earned = elapsed / refillMs_;
+        tokens_ = (tokens_ + earned > capacity_) ? capacity_ : tokens_ + earned;
+        lastRefill_ += earned * refillMs_;
+        if (tokens_ == capacity_)
+        {
+            lastRefill_ = now;
+        }
+    }
+
+    uint8_t capacity_;
+    uint32_t refillMs_;
+    uint32_t tokens_;
+    uint32_t lastRefill_;
+};
+
+#endif // DIGEST_H
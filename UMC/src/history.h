@@ -0,0 +1,672 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef HISTORY_RAW_STEP
+#define HISTORY_RAW_STEP 2          // s per raw slot; match SENSOR_INTERVAL
+#endif
+
+#ifndef HISTORY_RAW_ROWS
+#define HISTORY_RAW_ROWS 1800       // 1 hour of raw readings
+#endif
+
+#ifndef HISTORY_MINUTE_ROWS
+#define HISTORY_MINUTE_ROWS 1440    // 24 hours
+#endif
+
+#ifndef HISTORY_HOUR_ROWS
+#define HISTORY_HOUR_ROWS 720       // 30 days
+#endif
+
+#ifndef HISTORY_DAY_ROWS
+#define HISTORY_DAY_ROWS 730        // 2 years
+#endif
+
+#ifndef HISTORY_SEGMENT_BYTES
+#define HISTORY_SEGMENT_BYTES 4000  // Per file, so a slot write rewrites one flash block
+#endif
+
+#ifndef HISTORY_FLUSH_INTERVAL
+#define HISTORY_FLUSH_INTERVAL 300  // s of slots held in RAM between flash writes
+#endif
+
+#define HISTORY_PENDING_RAW (HISTORY_FLUSH_INTERVAL / HISTORY_RAW_STEP + 1)
+#define HISTORY_PENDING_ROLLUP 8
+#define HISTORY_QUERY_CHUNK 32      // Slots read from flash per storage call
+#define HISTORY_MIN_TIME 1577836800UL // 2020-01-01; anything earlier means no NTP yet
+#define HISTORY_MAGIC 0x31445252UL  // "RRD1"
+
+enum HistoryArchive : uint8_t
+{
+    HISTORY_RAW,
+    HISTORY_MINUTE,
+    HISTORY_HOUR,
+    HISTORY_DAY,
+    HISTORY_ARCHIVE_COUNT
+};
+
+// One slot of any archive, values in centi-degC / centi-%RH.
+// Raw slots have count 1 and min = avg = max.
+struct HistorySlot
+{
+    uint32_t time;                  // Epoch seconds at the start of the step
+    int16_t minC;
+    int16_t avgC;
+    int16_t maxC;
+    int16_t minRH;
+    int16_t avgRH;
+    int16_t maxRH;
+    uint16_t count;                 // Samples behind this slot
+};
+
+// Round-robin time-series store in the style of RRDtool: fixed-size
+// archives of raw readings and minute / hour / day rollups (min, avg,
+// max), so the space used never grows and old data ages out by itself.
+//
+// Each archive is a ring of slots; a timestamp maps straight to its
+// slot, (time / step) % rows, and every slot stores its own timestamp,
+// so a slot left over from an earlier lap is recognised as stale
+// instead of being cleared. A range query is therefore a direct read of
+// the slots in the range - O(points), no scan and no index.
+//
+// Rollups are updated incrementally: every sample is merged into an
+// in-RAM accumulator per rollup, which is emitted as a slot when its
+// step ends. After a reboot the accumulators are rebuilt from the
+// finer archives, so an hour or day isn't cut short.
+//
+// Flash wear is bounded by batching: new slots wait in RAM and are
+// written out every HISTORY_FLUSH_INTERVAL seconds, each contiguous run
+// as one write. Archives are split into HISTORY_SEGMENT_BYTES files,
+// so a write only ever rewrites a single small file - LittleFS copies
+// every block after the one modified. Up to HISTORY_FLUSH_INTERVAL of
+// readings can be lost on a power cut. Queries see the RAM slots and
+// the in-progress rollups too.
+//
+// Storage is any type providing:
+//   size_t read(uint8_t archive, uint16_t segment, uint32_t offset, void* data, size_t length)
+//   bool write(uint8_t archive, uint16_t segment, uint32_t offset, const void* data, size_t length)
+//   void remove(uint8_t archive, uint16_t segment)
+//   bool readMeta(void* data, size_t length)
+//   bool writeMeta(const void* data, size_t length)
+// where write() zero-fills a missing or short segment up to offset.
+//
+// Not thread safe; use it from one task.
+template <class Storage>
+class History
+{
+public:
+    static const uint16_t SLOTS_PER_SEGMENT = HISTORY_SEGMENT_BYTES / sizeof(HistorySlot);
+
+    struct Stats
+    {
+        uint32_t samples;
+        uint32_t flushes;
+        uint32_t bytesWritten;
+        uint32_t writeErrors;
+    };
+
+    explicit History(Storage& storage) : storage_(storage), ready_(false), resumed_(false), lastFlush_(0), stats_()
+    {
+        pending_[HISTORY_RAW].slots = pendingRaw_;
+        pending_[HISTORY_RAW].capacity = HISTORY_PENDING_RAW;
+        for (uint8_t a = HISTORY_MINUTE; a < HISTORY_ARCHIVE_COUNT; a++)
+        {
+            pending_[a].slots = pendingRollup_[a - HISTORY_MINUTE];
+            pending_[a].capacity = HISTORY_PENDING_ROLLUP;
+        }
+        for (uint8_t a = 0; a < HISTORY_ARCHIVE_COUNT; a++)
+        {
+            pending_[a].count = 0;
+            accumulators_[a].reset(0);
+        }
+    }
+
+    // Checks the stored layout matches this build's, and starts afresh
+    // if it doesn't (archive sizes changed, first boot)
+    bool begin()
+    {
+        Meta meta, stored;
+        meta.magic = HISTORY_MAGIC;
+        meta.segmentBytes = HISTORY_SEGMENT_BYTES;
+        for (uint8_t a = 0; a < HISTORY_ARCHIVE_COUNT; a++)
+        {
+            meta.step[a] = step(a);
+            meta.rows[a] = rows(a);
+        }
+        if (!storage_.readMeta(&stored, sizeof(stored)) || memcmp(&meta, &stored, sizeof(meta)) != 0)
+        {
+            for (uint8_t a = 0; a < HISTORY_ARCHIVE_COUNT; a++)
+            {
+                for (uint16_t s = 0; s < segments(a); s++)
+                {
+                    storage_.remove(a, s);
+                }
+            }
+            if (!storage_.writeMeta(&meta, sizeof(meta)))
+            {
+                return false;
+            }
+        }
+        ready_ = true;
+        return true;
+    }
+
+    // Records one sample. Ignored until the clock has been set.
+    bool add(uint32_t now, float tempC, float humidity)
+    {
+        if (!ready_ || now < HISTORY_MIN_TIME)
+        {
+            return false;
+        }
+        if (!resumed_)
+        {
+            resume(now);
+        }
+
+        HistorySlot raw;
+        raw.time = now - now % HISTORY_RAW_STEP;
+        raw.minC = raw.avgC = raw.maxC = (int16_t)lroundf(tempC * 100);
+        raw.minRH = raw.avgRH = raw.maxRH = (int16_t)lroundf(humidity * 100);
+        raw.count = 1;
+        queue(HISTORY_RAW, raw);
+
+        for (uint8_t a = HISTORY_MINUTE; a < HISTORY_ARCHIVE_COUNT; a++)
+        {
+            Accumulator& acc = accumulators_[a];
+            uint32_t start = now - now % step(a);
+            if (acc.start != start)
+            {
+                if (acc.count > 0)
+                {
+                    queue(a, acc.slot());
+                }
+                acc.reset(start);
+            }
+            acc.merge(raw);
+        }
+
+        stats_.samples++;
+        if (now - lastFlush_ >= HISTORY_FLUSH_INTERVAL)
+        {
+            flush();
+            lastFlush_ = now;
+        }
+        return true;
+    }
+
+    // Writes all RAM slots to storage
+    void flush()
+    {
+        for (uint8_t a = 0; a < HISTORY_ARCHIVE_COUNT; a++)
+        {
+            Pending& pending = pending_[a];
+            uint16_t i = 0;
+            while (i < pending.count)
+            {
+                // Extend the run while slots are adjacent in the same file
+                uint32_t first = index(a, pending.slots[i].time);
+                uint16_t n = 1;
+                while (i + n < pending.count &&
+                       index(a, pending.slots[i + n].time) == first + n &&
+                       (first + n) / SLOTS_PER_SEGMENT == first / SLOTS_PER_SEGMENT)
+                {
+                    n++;
+                }
+                size_t length = n * sizeof(HistorySlot);
+                if (storage_.write(a, first / SLOTS_PER_SEGMENT, (first % SLOTS_PER_SEGMENT) * sizeof(HistorySlot),
+                                   &pending.slots[i], length))
+                {
+                    stats_.bytesWritten += length;
+                }
+                else
+                {
+                    stats_.writeErrors++;
+                }
+                i += n;
+            }
+            pending.count = 0;
+        }
+        stats_.flushes++;
+    }
+
+    // Calls emit(const HistorySlot&) for every slot of archive with a
+    // time in [from, to], oldest first, including unflushed slots and the
+    // in-progress rollup. Returns the number of slots emitted.
+    template <class Emit>
+    uint32_t query(uint8_t archive, uint32_t from, uint32_t to, Emit&& emit)
+    {
+        if (!ready_ || archive >= HISTORY_ARCHIVE_COUNT || to < from)
+        {
+            return 0;
+        }
+        const uint32_t stepS = step(archive);
+        uint32_t last = to - to % stepS;
+        uint32_t oldest = last >= (rows(archive) - 1) * stepS ? last - (rows(archive) - 1) * stepS : 0;
+        uint32_t t = from % stepS == 0 ? from : from - from % stepS + stepS;
+        if (t < oldest)
+        {
+            t = oldest;
+        }
+
+        const Pending& pending = pending_[archive];
+        const Accumulator& acc = accumulators_[archive];
+        uint16_t p = 0;
+        uint32_t emitted = 0;
+        HistorySlot chunk[HISTORY_QUERY_CHUNK];
+        while (t <= last)
+        {
+            // Read the longest run that stays within one file and the ring
+            uint32_t first = index(archive, t);
+            uint32_t n = (last - t) / stepS + 1;
+            n = n < HISTORY_QUERY_CHUNK ? n : HISTORY_QUERY_CHUNK;
+            uint32_t toSegmentEnd = SLOTS_PER_SEGMENT - first % SLOTS_PER_SEGMENT;
+            n = n < toSegmentEnd ? n : toSegmentEnd;
+            n = n < rows(archive) - first ? n : rows(archive) - first;
+            size_t got = storage_.read(archive, first / SLOTS_PER_SEGMENT, (first % SLOTS_PER_SEGMENT) * sizeof(HistorySlot),
+                                       chunk, n * sizeof(HistorySlot));
+            memset((uint8_t*)chunk + got, 0, n * sizeof(HistorySlot) - got);
+
+            for (uint32_t j = 0; j < n; j++, t += stepS)
+            {
+                const HistorySlot* slot = &chunk[j];
+                while (p < pending.count && pending.slots[p].time < t)
+                {
+                    p++;
+                }
+                if (p < pending.count && pending.slots[p].time == t)
+                {
+                    slot = &pending.slots[p];
+                }
+                HistorySlot partial;
+                if (archive != HISTORY_RAW && acc.count > 0 && acc.start == t)
+                {
+                    partial = acc.slot();
+                    slot = &partial;
+                }
+                if (slot->time == t && slot->count > 0)
+                {
+                    emit(*slot);
+                    emitted++;
+                }
+            }
+        }
+        return emitted;
+    }
+
+    static uint32_t step(uint8_t archive)
+    {
+        static const uint32_t steps[HISTORY_ARCHIVE_COUNT] = {HISTORY_RAW_STEP, 60, 3600, 86400};
+        return steps[archive];
+    }
+
+    static uint16_t rows(uint8_t archive)
+    {
+        static const uint16_t counts[HISTORY_ARCHIVE_COUNT] = {HISTORY_RAW_ROWS, HISTORY_MINUTE_ROWS, HISTORY_HOUR_ROWS, HISTORY_DAY_ROWS};
+        return counts[archive];
+    }
+
+    static const char* name(uint8_t archive)
+    {
+        static const char* const names[HISTORY_ARCHIVE_COUNT] = {"raw", "minute", "hour", "day"};
+        return names[archive];
+    }
+
+    bool ready() const
+    {
+        return ready_;
+    }
+
+    Stats stats() const
+    {
+        return stats_;
+    }
+
+private:
+    struct Meta
+    {
+        uint32_t magic;
+        uint32_t segmentBytes;
+        uint32_t step[HISTORY_ARCHIVE_COUNT];
+        uint32_t rows[HISTORY_ARCHIVE_COUNT];
+    };
+
+    struct Pending
+    {
+        HistorySlot* slots;         // Sorted by time
+        uint16_t capacity;
+        uint16_t count;
+    };
+
+    struct Accumulator
+    {
+        uint32_t start;
+        int32_t sumC;
+        int32_t sumRH;
+        int16_t minC;
+        int16_t maxC;
+        int16_t minRH;
+        int16_t maxRH;
+        uint16_t count;
+
+        void reset(uint32_t startTime)
+        {
+            start = startTime;
+            sumC = sumRH = 0;
+            minC = minRH = INT16_MAX;
+            maxC = maxRH = INT16_MIN;
+            count = 0;
+        }
+
+        void merge(const HistorySlot& slot)
+        {
+            sumC += (int32_t)slot.avgC * slot.count;
+            sumRH += (int32_t)slot.avgRH * slot.count;
+            minC = slot.minC < minC ? slot.minC : minC;
+            maxC = slot.maxC > maxC ? slot.maxC : maxC;
+            minRH = slot.minRH < minRH ? slot.minRH : minRH;
+            maxRH = slot.maxRH > maxRH ? slot.maxRH : maxRH;
+            count += slot.count;
+        }
+
+        HistorySlot slot() const
+        {
+            HistorySlot s;
+            s.time = start;
+            s.minC = minC;
+            s.avgC = (int16_t)lroundf((float)sumC / count);
+            s.maxC = maxC;
+            s.minRH = minRH;
+            s.avgRH = (int16_t)lroundf((float)sumRH / count);
+            s.maxRH = maxRH;
+            s.count = count;
+            return s;
+        }
+    };
+
+    static uint32_t index(uint8_t archive, uint32_t time)
+    {
+        return (time / step(archive)) % rows(archive);
+    }
+
+    static uint16_t segments(uint8_t archive)
+    {
+        return (rows(archive) + SLOTS_PER_SEGMENT - 1) / SLOTS_PER_SEGMENT;
+    }
+
+    void queue(uint8_t archive, const HistorySlot& slot)
+    {
+        Pending& pending = pending_[archive];
+        if (pending.count > 0 && pending.slots[pending.count - 1].time == slot.time)
+        {
+            pending.slots[pending.count - 1] = slot; // Two samples in one raw step
+            return;
+        }
+        if (pending.count == pending.capacity)
+        {
+            flush();
+        }
+        pending.slots[pending.count++] = slot;
+    }
+
+    // Rebuilds the in-progress rollups after a reboot: the minute from
+    // raw slots, the hour from minutes, the day from hours
+    void resume(uint32_t now)
+    {
+        resumed_ = true;
+        for (uint8_t a = HISTORY_MINUTE; a < HISTORY_ARCHIVE_COUNT; a++)
+        {
+            Accumulator& acc = accumulators_[a];
+            acc.reset(now - now % step(a));
+            uint32_t finerStart = now - now % step(a - 1);
+            if (finerStart > acc.start)
+            {
+                rebuild(acc, a - 1, acc.start, finerStart - 1);
+            }
+            if (a > HISTORY_MINUTE && accumulators_[a - 1].count > 0)
+            {
+                acc.merge(accumulators_[a - 1].slot());
+            }
+        }
+    }
+
+    // Merges archive's slots in [from, to] into acc. The rollup that
+    // was open when the power went never became a slot, so whatever
+    // follows the last slot found is taken from the next finer archive.
+    void rebuild(Accumulator& acc, uint8_t archive, uint32_t from, uint32_t to)
+    {
+        uint32_t covered = from;
+        query(archive, from, to, [&acc, &covered, archive](const HistorySlot& slot) {
+            acc.merge(slot);
+            covered = slot.time + step(archive);
+        });
+        if (archive > HISTORY_RAW && covered <= to)
+        {
+            rebuild(acc, archive - 1, covered, to);
+        }
+    }
+
+    Storage& storage_;
+    bool ready_;
+    bool resumed_;
+    uint32_t lastFlush_;
+    Pending pending_[HISTORY_ARCHIVE_COUNT];
+    HistorySlot pendingRaw_[HISTORY_PENDING_RAW];
+    HistorySlot pendingRollup_[HISTORY_ARCHIVE_COUNT - 1][HISTORY_PENDING_ROLLUP];
+    Accumulator accumulators_[HISTORY_ARCHIVE_COUNT];
+    Stats stats_;
+};
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <FS.h>
+#include <WebServer.h>
+
+#ifndef HISTORY_PORT
+#define HISTORY_PORT 80
+#endif
+
+// History storage on an Arduino filesystem, one file per segment
+class FsHistoryStorage
+{
+public:
+    explicit FsHistoryStorage(fs::FS& fs) : fs_(fs) {}
+
+    size_t read(uint8_t archive, uint16_t segment, uint32_t offset, void* data, size_t length)
+    {
+        char path[24];
+        File file = fs_.open(segmentPath(path, archive, segment), FILE_READ);
+        if (!file || !file.seek(offset))
+        {
+            return 0;
+        }
+        size_t n = file.read((uint8_t*)data, length);
+        file.close();
+        return n;
+    }
+
+    bool write(uint8_t archive, uint16_t segment, uint32_t offset, const void* data, size_t length)
+    {
+        char path[24];
+        segmentPath(path, archive, segment);
+        File file = fs_.open(path, fs_.exists(path) ? "r+" : FILE_WRITE);
+        if (!file)
+        {
+            return false;
+        }
+        // Empty slots up to the offset, for a new or short segment
+        static const uint8_t zeros[64] = {0};
+        uint32_t size = file.size();
+        if (size < offset && file.seek(size))
+        {
+            while (size < offset)
+            {
+                size_t n = offset - size < sizeof(zeros) ? offset - size : sizeof(zeros);
+                size += file.write(zeros, n);
+            }
+        }
+        bool ok = file.seek(offset) && file.write((const uint8_t*)data, length) == length;
+        file.close();
+        return ok;
+    }
+
+    void remove(uint8_t archive, uint16_t segment)
+    {
+        char path[24];
+        if (fs_.exists(segmentPath(path, archive, segment)))
+        {
+            fs_.remove(path);
+        }
+    }
+
+    bool readMeta(void* data, size_t length)
+    {
+        File file = fs_.open("/rrd.meta", FILE_READ);
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = file.read((uint8_t*)data, length);
+        file.close();
+        return n == length;
+    }
+
+    bool writeMeta(const void* data, size_t length)
+    {
+        File file = fs_.open("/rrd.meta", FILE_WRITE);
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = file.write((const uint8_t*)data, length);
+        file.close();
+        return n == length;
+    }
+
+private:
+    static const char* segmentPath(char* path, uint8_t archive, uint16_t segment)
+    {
+        snprintf(path, 24, "/rrd_%u_%u.bin", archive, segment);
+        return path;
+    }
+
+    fs::FS& fs_;
+};
+
+typedef History<FsHistoryStorage> FsHistory;
+
+// Range queries over HTTP, streamed as chunked JSON:
+//
+//   GET /history?archive=minute&from=<epoch>&to=<epoch>
+//   {"archive":"minute","step":60,"points":[[t,minC,avgC,maxC,minRH,avgRH,maxRH,n],...]}
+//
+// Raw points are [t,c,rh]. archive defaults to the finest one that
+// still covers from; from defaults to that archive's whole span and to
+// defaults to now.
+class HistoryServer
+{
+public:
+    explicit HistoryServer(FsHistory& history) : history_(history), server_(HISTORY_PORT), used_(0) {}
+
+    void begin()
+    {
+        server_.on("/history", [this]() { handleQuery(); });
+        server_.begin();
+    }
+
+    void poll()
+    {
+        server_.handleClient();
+    }
+
+private:
+    void handleQuery()
+    {
+        uint32_t now = (uint32_t)time(nullptr);
+        uint32_t to = server_.hasArg("to") ? strtoul(server_.arg("to").c_str(), nullptr, 10) : now;
+        uint8_t archive = HISTORY_ARCHIVE_COUNT;
+        if (server_.hasArg("archive"))
+        {
+            for (uint8_t a = 0; a < HISTORY_ARCHIVE_COUNT; a++)
+            {
+                if (server_.arg("archive") == FsHistory::name(a))
+                {
+                    archive = a;
+                }
+            }
+            if (archive == HISTORY_ARCHIVE_COUNT)
+            {
+                server_.send(400, "text/plain", "archive must be raw, minute, hour or day");
+                return;
+            }
+        }
+        bool hasFrom = server_.hasArg("from");
+        uint32_t from = hasFrom ? strtoul(server_.arg("from").c_str(), nullptr, 10) : 0;
+        if (archive == HISTORY_ARCHIVE_COUNT)
+        {
+            archive = HISTORY_RAW;
+            while (hasFrom && archive < HISTORY_DAY && now - from > span(archive))
+            {
+                archive++;
+            }
+        }
+        if (!hasFrom)
+        {
+            from = to > span(archive) ? to - span(archive) : 0;
+        }
+
+        server_.setContentLength(CONTENT_LENGTH_UNKNOWN);
+        server_.send(200, "application/json", "");
+        used_ = snprintf(buffer_, sizeof(buffer_), "{\"archive\":\"%s\",\"step\":%lu,\"points\":[",
+                         FsHistory::name(archive), (unsigned long)FsHistory::step(archive));
+        bool first = true;
+        history_.query(archive, from, to, [this, archive, &first](const HistorySlot& s) {
+            char point[96];
+            int n;
+            if (archive == HISTORY_RAW)
+            {
+                n = snprintf(point, sizeof(point), "%s[%lu,%.2f,%.2f]", first ? "" : ",",
+                             (unsigned long)s.time, s.avgC / 100.0, s.avgRH / 100.0);
+            }
+            else
+            {
+                n = snprintf(point, sizeof(point), "%s[%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%u]", first ? "" : ",",
+                             (unsigned long)s.time, s.minC / 100.0, s.avgC / 100.0, s.maxC / 100.0,
+                             s.minRH / 100.0, s.avgRH / 100.0, s.maxRH / 100.0, s.count);
+            }
+            first = false;
+            append(point, n);
+        });
+        append("]}", 2);
+        server_.sendContent(buffer_, used_);
+        server_.sendContent("");    // Ends the chunked response
+        used_ = 0;
+    }
+
+    // Batches points into one chunk per buffer-full
+    void append(const char* text, int length)
+    {
+        if (used_ + length > sizeof(buffer_))
+        {
+            server_.sendContent(buffer_, used_);
+            used_ = 0;
+        }
+        memcpy(buffer_ + used_, text, length);
+        used_ += length;
+    }
+
+    static uint32_t span(uint8_t archive)
+    {
+        return FsHistory::step(archive) * FsHistory::rows(archive);
+    }
+
+    FsHistory& history_;
+    WebServer server_;
+    char buffer_[1024];
+    size_t used_;
+};
+#endif // ARDUINO
+
+#endif // HISTORY_H
@@ -0,0 +1,340 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include <ArduinoJson.h>
+#include <time.h>
+#include "constant.h"
+#include "journal.h"
+#include "metrics.h"
+
+#ifndef INGEST_BATCH_SIZE
+#define INGEST_BATCH_SIZE 60        // Readings per POST
+#endif
+
+#ifndef INGEST_FLUSH_INTERVAL
+#define INGEST_FLUSH_INTERVAL 600000 // ms - post a partial batch after this long
+#endif
+
+#ifndef INGEST_RETRY_DELAY
+#define INGEST_RETRY_DELAY 10000    // ms to wait after a failed POST
+#endif
+
+#ifndef INGEST_BUFFER_SIZE
+#define INGEST_BUFFER_SIZE 1024     // Encoded MessagePack payload bytes
+#endif
+
+// Worst-case MessagePack size of n readings: keys and headers, then at
+// most 5 bytes of dt and 3 each of c, h and db per reading
+#define INGEST_ENCODED_MAX(n) (48 + 14 * (n))
+
+#ifndef JOURNAL_SYNC_INTERVAL
+#define JOURNAL_SYNC_INTERVAL 60000 // ms - max time readings wait in RAM before hitting the card
+#endif
+
+// Batched binary upload of readings to API_ENDPOINT.
+// Readings are handed to a background task through a queue, collected
+// into a fixed array and posted as one MessagePack document per batch:
+//
+//   {"v": 2, "t0": <epoch of first>, "n": <count>,
+//    "dt": [<seconds since t0>...], "c": [<centi-degC>...], "h": [<centi-%RH>...],
+//    "db": [<centi-dBA>...]}
+//
+// Values are sent as scaled integers, so a reading costs ~12 bytes
+// instead of a ~100 byte JSON object and its own HTTP request.
+// See tools/ingest_server.py for a local receiver.
+//
+// With a journal attached, readings taken while WiFi is down (or that
+// would otherwise be dropped) go to the SD card instead, and are
+// replayed one journal block per POST once the link is back. The
+// journal is only touched from the ingest task.
+class IngestBatcher
+{
+public:
+    typedef Journal<FsStorage> SdJournal;
+
+    struct Stats
+    {
+        uint32_t posts;
+        uint32_t failed;
+        uint32_t samples;           // Readings delivered
+        uint32_t dropped;           // Readings lost (queue full / batch failed / too big to encode)
+        uint32_t oversized;         // Batches dropped because they didn't fit INGEST_BUFFER_SIZE
+        uint32_t journaled;         // Readings written to the journal
+        uint32_t replayed;          // Journaled readings delivered
+        uint32_t lastPayloadBytes;
+    };
+
+    IngestBatcher() : count_(0), batchStart_(0), lastAttempt_(0), lastFailed_(false), journal_(nullptr), lastSync_(0), task_(nullptr), counters_()
+    {
+        incoming_ = xQueueCreate(8, sizeof(JournalRecord));
+    }
+
+    // Optional; call before begin(). The journal must already be begun.
+    void attachJournal(SdJournal* journal)
+    {
+        journal_ = journal;
+    }
+
+    void begin()
+    {
+        if (task_ == nullptr)
+        {
+            xTaskCreatePinnedToCore(run, "ingest", 8192, this, 1, &task_, 0);
+        }
+    }
+
+    // Never blocks
+    bool add(float tempC, float humidity, float dbA = 0)
+    {
+        JournalRecord reading = {(uint32_t)time(nullptr), (int16_t)lroundf(tempC * 100), (int16_t)lroundf(humidity * 100),
+                                 (int16_t)lroundf(dbA * 100), 0};
+        if (xQueueSend(incoming_, &reading, 0) != pdTRUE)
+        {
+            counters_.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    // Written by the ingest task and add(); safe to call from anywhere
+    Stats stats() const
+    {
+        Stats s;
+        s.posts = counters_.posts.load(std::memory_order_relaxed);
+        s.failed = counters_.failed.load(std::memory_order_relaxed);
+        s.samples = counters_.samples.load(std::memory_order_relaxed);
+        s.dropped = counters_.dropped.load(std::memory_order_relaxed);
+        s.oversized = counters_.oversized.load(std::memory_order_relaxed);
+        s.journaled = counters_.journaled.load(std::memory_order_relaxed);
+        s.replayed = counters_.replayed.load(std::memory_order_relaxed);
+        s.lastPayloadBytes = counters_.lastPayloadBytes.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Encodes and POSTs readings now, on the caller's task. Used directly
+    // by the deep-sleep path, where the ingest task is never started.
+    //
+    // A batch that can't be encoded into payload_ is dropped and counted
+    // rather than failed: retrying it could never succeed, and would
+    // block every later batch behind it. Returns false only for a failed
+    // POST, which the caller should retry.
+    bool post(const JournalRecord* readings, uint16_t count)
+    {
+        return send(readings, count) != Failed;
+    }
+
+private:
+    static_assert(INGEST_ENCODED_MAX(INGEST_BATCH_SIZE) <= INGEST_BUFFER_SIZE, "INGEST_BUFFER_SIZE too small for a batch");
+    static_assert(INGEST_ENCODED_MAX(SdJournal::RECORDS_PER_BLOCK) <= INGEST_BUFFER_SIZE,
+                  "INGEST_BUFFER_SIZE too small for a journal block");
+
+    enum SendResult
+    {
+        Delivered,
+        Failed,
+        Dropped                     // Too big to encode; counted as dropped
+    };
+
+    // Stats, one atomic per field
+    struct Counters
+    {
+        std::atomic<uint32_t> posts;
+        std::atomic<uint32_t> failed;
+        std::atomic<uint32_t> samples;
+        std::atomic<uint32_t> dropped;
+        std::atomic<uint32_t> oversized;
+        std::atomic<uint32_t> journaled;
+        std::atomic<uint32_t> replayed;
+        std::atomic<uint32_t> lastPayloadBytes;
+    };
+
+    SendResult send(const JournalRecord* readings, uint16_t count)
+    {
+        doc_.clear();
+        uint32_t t0 = readings[0].timestamp;
+        doc_["v"] = 2;
+        doc_["t0"] = t0;
+        doc_["n"] = count;
+        JsonArray dt = doc_["dt"].to<JsonArray>();
+        JsonArray c = doc_["c"].to<JsonArray>();
+        JsonArray h = doc_["h"].to<JsonArray>();
+        JsonArray db = doc_["db"].to<JsonArray>();
+        for (uint16_t i = 0; i < count; i++)
+        {
+            dt.add(readings[i].timestamp - t0);
+            c.add(readings[i].centiC);
+            h.add(readings[i].centiRH);
+            db.add(readings[i].centiDbA);
+        }
+
+        if (doc_.overflowed() || measureMsgPack(doc_) > sizeof(payload_))
+        {
+            counters_.oversized.fetch_add(1, std::memory_order_relaxed);
+            counters_.dropped.fetch_add(count, std::memory_order_relaxed);
+            Serial.printf("Ingest batch of %u readings doesn't fit %u bytes, dropped\n", count, (unsigned)sizeof(payload_));
+            return Dropped;
+        }
+        size_t length = serializeMsgPack(doc_, payload_, sizeof(payload_));
+
+        uint32_t start = micros();
+        HTTPClient http;
+        http.begin(API_ENDPOINT);
+        http.addHeader("Content-Type", "application/msgpack");
+        int httpResponseCode = http.POST(payload_, length);
+        http.end();
+        Metrics::getInstance().observe(MH_INGEST_POST, micros() - start);
+
+        bool ok = httpResponseCode >= 200 && httpResponseCode < 300;
+        lastAttempt_ = millis();
+        lastFailed_ = !ok;
+        counters_.lastPayloadBytes.store(length, std::memory_order_relaxed);
+        if (ok)
+        {
+            counters_.posts.fetch_add(1, std::memory_order_relaxed);
+            counters_.samples.fetch_add(count, std::memory_order_relaxed);
+            Metrics::getInstance().inc(MC_INGEST_POSTS);
+        }
+        else
+        {
+            // Caller keeps the readings and retries on a later pass
+            counters_.failed.fetch_add(1, std::memory_order_relaxed);
+            Metrics::getInstance().inc(MC_INGEST_FAILED);
+            Serial.print("Error on sending POST: ");
+            Serial.println(httpResponseCode);
+        }
+        return ok ? Delivered : Failed;
+    }
+
+    static void run(void* arg)
+    {
+        IngestBatcher* self = static_cast<IngestBatcher*>(arg);
+        JournalRecord reading;
+        for (;;)
+        {
+            bool online = WiFi.status() == WL_CONNECTED;
+            if (xQueueReceive(self->incoming_, &reading, pdMS_TO_TICKS(1000)) == pdTRUE)
+            {
+                if (self->journal_ != nullptr && !online)
+                {
+                    self->journalAppend(reading);
+                }
+                else
+                {
+                    self->collect(reading);
+                }
+            }
+
+            bool full = self->count_ == INGEST_BATCH_SIZE;
+            bool stale = self->count_ > 0 && millis() - self->batchStart_ >= INGEST_FLUSH_INTERVAL;
+            bool backoff = self->lastFailed_ && millis() - self->lastAttempt_ < INGEST_RETRY_DELAY;
+            if (!online || backoff)
+            {
+                self->journalSync(false);
+            }
+            else if (full || stale)
+            {
+                self->flush();
+            }
+            else if (self->journal_ != nullptr)
+            {
+                self->replay();
+            }
+        }
+    }
+
+    void collect(const JournalRecord& reading)
+    {
+        if (count_ == INGEST_BATCH_SIZE)
+        {
+            if (journal_ != nullptr)
+            {
+                // Can't post: move the whole batch to the card
+                for (uint16_t i = 0; i < count_; i++)
+                {
+                    journalAppend(batch_[i]);
+                }
+                count_ = 0;
+            }
+            else
+            {
+                // Still can't post a full batch: make room by dropping the oldest half
+                uint16_t half = INGEST_BATCH_SIZE / 2;
+                memmove(batch_, batch_ + half, (INGEST_BATCH_SIZE - half) * sizeof(JournalRecord));
+                count_ -= half;
+                counters_.dropped.fetch_add(half, std::memory_order_relaxed);
+            }
+        }
+        if (count_ == 0)
+        {
+            batchStart_ = millis();
+        }
+        batch_[count_++] = reading;
+    }
+
+    void journalAppend(const JournalRecord& reading)
+    {
+        if (journal_->buffered() == 0)
+        {
+            lastSync_ = millis();
+        }
+        journal_->append(reading);
+        counters_.journaled.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Writes a partial block once readings have waited long enough
+    void journalSync(bool force)
+    {
+        if (journal_ != nullptr && journal_->buffered() > 0 && (force || millis() - lastSync_ >= JOURNAL_SYNC_INTERVAL))
+        {
+            journal_->sync();
+        }
+    }
+
+    // Sends one journal block; the live batch always goes first
+    void replay()
+    {
+        journalSync(true);
+        uint16_t n = journal_->peek(replay_);
+        if (n == 0)
+        {
+            return;
+        }
+        SendResult result = send(replay_, n);
+        if (result != Failed)
+        {
+            journal_->ack(n);
+        }
+        if (result == Delivered)
+        {
+            counters_.replayed.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    void flush()
+    {
+        if (post(batch_, count_))
+        {
+            count_ = 0;
+        }
+    }
+
+    JournalRecord batch_[INGEST_BATCH_SIZE];
+    uint16_t count_;
+    uint32_t batchStart_;
+    uint32_t lastAttempt_;
+    bool lastFailed_;
+    SdJournal* journal_;
+    JournalRecord replay_[SdJournal::RECORDS_PER_BLOCK];
+    uint32_t lastSync_;
+    JsonDocument doc_;              // Reused for every batch, cleared before each
+    uint8_t payload_[INGEST_BUFFER_SIZE];
+    QueueHandle_t incoming_;
+    TaskHandle_t task_;
+    Counters counters_;
+};
+
+#endif // INGEST_H
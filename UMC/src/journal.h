@@ -0,0 +1,428 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef JOURNAL_BLOCK_SIZE
+#define JOURNAL_BLOCK_SIZE 512      // One SD sector per block
+#endif
+
+#define JOURNAL_MAGIC 0x324E524AUL  // "JRN2" - record gained centiDbA
+
+// One reading as stored in the journal and sent by the ingest uploader
+struct JournalRecord
+{
+    uint32_t timestamp;             // Epoch seconds
+    int16_t centiC;
+    int16_t centiRH;
+    int16_t centiDbA;               // A-weighted sound level, 0 if not measured
+    int16_t reserved;
+};
+
+// Append-only, block-structured journal for store-and-forward.
+// Records are buffered in RAM and written out a whole block at a time,
+// so each SD write is one aligned sector. Every block carries its
+// sequence number and a CRC32, and a small index records which
+// blocks exist and how far replay has got.
+//
+// The index is rewritten after every block and every replay ack,
+// alternating between two copies so a power cut mid-write leaves the
+// previous one intact; begin() takes the newer copy that passes its
+// CRC. The data file is then scanned forward from the indexed tail, so
+// blocks written after the last index update are still recovered, and
+// a torn block at the end (power cut mid-write) fails its CRC and is
+// cut off. Once replay catches up the data file is emptied.
+//
+// Storage is any type providing:
+//   size_t read(uint32_t offset, void* data, size_t length)
+//   bool append(const void* data, size_t length)
+//   uint32_t size()
+//   bool truncate(uint32_t length)
+//   bool readIndex(uint8_t copy, void* data, size_t length)     copy 0 or 1
+//   bool writeIndex(uint8_t copy, const void* data, size_t length)
+//
+// Not thread safe; use it from one task.
+template <class Storage>
+class Journal
+{
+public:
+    struct BlockHeader
+    {
+        uint32_t magic;
+        uint32_t sequence;
+        uint16_t count;             // Records in this block
+        uint16_t reserved;
+        uint32_t crc;               // Over header (crc = 0) and records
+    };
+
+    static const uint16_t RECORDS_PER_BLOCK = (JOURNAL_BLOCK_SIZE - sizeof(BlockHeader)) / sizeof(JournalRecord);
+
+    struct Stats
+    {
+        uint32_t recordsWritten;
+        uint32_t blocksWritten;
+        uint32_t blocksReplayed;
+        uint32_t recordsReplayed;
+        uint32_t crcErrors;         // Blocks skipped on replay or cut off on recovery
+        uint32_t writeErrors;
+    };
+
+    explicit Journal(Storage& storage) : storage_(storage), pending_(0), stats_()
+    {
+        index_ = Index();
+    }
+
+    // Loads the index and recovers any blocks written after it
+    bool begin()
+    {
+        Index copies[2];
+        bool ok[2];
+        for (uint8_t copy = 0; copy < 2; copy++)
+        {
+            Index& index = copies[copy];
+            ok[copy] = storage_.readIndex(copy, &index, sizeof(index)) && index.magic == JOURNAL_MAGIC &&
+                       index.crc == crc32(&index, offsetof(Index, crc));
+        }
+        if (ok[0] && ok[1])
+        {
+            index_ = (int32_t)(copies[1].generation - copies[0].generation) > 0 ? copies[1] : copies[0];
+        }
+        else if (ok[0] || ok[1])
+        {
+            index_ = ok[0] ? copies[0] : copies[1];
+        }
+        else
+        {
+            // No usable index: treat whatever is on the card as unsent
+            index_ = Index();
+            index_.magic = JOURNAL_MAGIC;
+        }
+
+        // Re-base on what the data file actually holds. The file is
+        // emptied once replay catches up, and the index recording that
+        // may be the older copy (or missing).
+        uint8_t block[JOURNAL_BLOCK_SIZE];
+        if (storage_.read(0, block, sizeof(block)) == sizeof(block) && valid(block))
+        {
+            uint32_t first = ((BlockHeader*)block)->sequence;
+            index_.base = first;
+            if ((int32_t)(index_.head - first) < 0)
+            {
+                index_.head = first;
+            }
+            if ((int32_t)(index_.tail - first) < 0)
+            {
+                index_.tail = first;
+            }
+        }
+        else if (storage_.size() < JOURNAL_BLOCK_SIZE)
+        {
+            index_.base = index_.head = index_.tail;
+        }
+
+        // Roll forward over blocks the index hasn't caught up with
+        while (storage_.read(offsetOf(index_.tail), block, sizeof(block)) == sizeof(block))
+        {
+            if (!valid(block) || ((BlockHeader*)block)->sequence != index_.tail)
+            {
+                break;
+            }
+            index_.tail++;
+        }
+        // Drop anything past the last good block (torn write)
+        if (storage_.size() > offsetOf(index_.tail))
+        {
+            stats_.crcErrors++;
+            storage_.truncate(offsetOf(index_.tail));
+        }
+        return saveIndex();
+    }
+
+    // Buffers a record; writes a block once RECORDS_PER_BLOCK are waiting
+    bool append(const JournalRecord& record)
+    {
+        buffer_[pending_++] = record;
+        stats_.recordsWritten++;
+        if (pending_ == RECORDS_PER_BLOCK)
+        {
+            return sync();
+        }
+        return true;
+    }
+
+    // Writes buffered records now as a (possibly partial) block.
+    // Anything still in RAM is lost on a power cut, so call this
+    // periodically to bound the loss.
+    bool sync()
+    {
+        if (pending_ == 0)
+        {
+            return true;
+        }
+        uint8_t block[JOURNAL_BLOCK_SIZE];
+        memset(block, 0, sizeof(block));
+        BlockHeader* header = (BlockHeader*)block;
+        header->magic = JOURNAL_MAGIC;
+        header->sequence = index_.tail;
+        header->count = pending_;
+        memcpy(block + sizeof(BlockHeader), buffer_, pending_ * sizeof(JournalRecord));
+        header->crc = crc32(block, sizeof(block));
+
+        if (!storage_.append(block, sizeof(block)))
+        {
+            // Keep the records buffered and try again on the next sync.
+            // Cut off any part of the block that did land, or every
+            // later block would sit at the wrong offset.
+            stats_.writeErrors++;
+            if (storage_.size() > offsetOf(index_.tail))
+            {
+                storage_.truncate(offsetOf(index_.tail));
+            }
+            return false;
+        }
+        pending_ = 0;
+        index_.tail++;
+        stats_.blocksWritten++;
+        return saveIndex();
+    }
+
+    // Blocks written but not yet acknowledged by replay
+    uint32_t backlog() const
+    {
+        return index_.tail - index_.head;
+    }
+
+    // Records buffered in RAM, not yet on the card
+    uint16_t buffered() const
+    {
+        return pending_;
+    }
+
+    // Reads the oldest unacknowledged block into records (room for
+    // RECORDS_PER_BLOCK). Returns the record count, 0 when there is no
+    // backlog. Corrupt blocks are skipped and counted.
+    uint16_t peek(JournalRecord* records)
+    {
+        uint8_t block[JOURNAL_BLOCK_SIZE];
+        while (backlog() > 0)
+        {
+            if (storage_.read(offsetOf(index_.head), block, sizeof(block)) == sizeof(block) && valid(block))
+            {
+                BlockHeader* header = (BlockHeader*)block;
+                memcpy(records, block + sizeof(BlockHeader), header->count * sizeof(JournalRecord));
+                return header->count;
+            }
+            stats_.crcErrors++;
+            index_.head++;
+        }
+        saveIndex();
+        return 0;
+    }
+
+    // Marks the block returned by peek() as delivered
+    void ack(uint16_t count)
+    {
+        if (backlog() == 0)
+        {
+            return;
+        }
+        index_.head++;
+        stats_.blocksReplayed++;
+        stats_.recordsReplayed += count;
+        if (backlog() == 0 && storage_.truncate(0))
+        {
+            // Caught up: start the file again rather than let it grow
+            index_.base = index_.head;
+        }
+        saveIndex();
+    }
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+
+    static uint32_t crc32(const void* data, size_t length)
+    {
+        const uint8_t* bytes = (const uint8_t*)data;
+        uint32_t crc = 0xFFFFFFFF;
+        for (size_t i = 0; i < length; i++)
+        {
+            crc ^= bytes[i];
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+            }
+        }
+        return ~crc;
+    }
+
+private:
+    struct Index
+    {
+        uint32_t magic;
+        uint32_t base;              // Sequence of the first block in the data file
+        uint32_t head;              // Next block to replay
+        uint32_t tail;              // Next block to write
+        uint32_t generation;        // Picks the newer of the two copies
+        uint32_t crc;
+    };
+
+    uint32_t offsetOf(uint32_t sequence) const
+    {
+        return (sequence - index_.base) * JOURNAL_BLOCK_SIZE;
+    }
+
+    static bool valid(uint8_t* block)
+    {
+        BlockHeader* header = (BlockHeader*)block;
+        if (header->magic != JOURNAL_MAGIC || header->count == 0 || header->count > RECORDS_PER_BLOCK)
+        {
+            return false;
+        }
+        uint32_t crc = header->crc;
+        header->crc = 0;
+        bool ok = crc32(block, JOURNAL_BLOCK_SIZE) == crc;
+        header->crc = crc;
+        return ok;
+    }
+
+    // Overwrites the older copy. A failed write leaves the generation
+    // alone, so the retry goes to the same copy and the good one survives.
+    bool saveIndex()
+    {
+        index_.generation++;
+        index_.crc = crc32(&index_, offsetof(Index, crc));
+        if (!storage_.writeIndex(index_.generation & 1, &index_, sizeof(index_)))
+        {
+            index_.generation--;
+            stats_.writeErrors++;
+            return false;
+        }
+        return true;
+    }
+
+    Storage& storage_;
+    Index index_;
+    JournalRecord buffer_[RECORDS_PER_BLOCK];
+    uint16_t pending_;
+    Stats stats_;
+};
+
+#ifdef ARDUINO
+#include <FS.h>
+
+#ifndef JOURNAL_DATA_PATH
+#define JOURNAL_DATA_PATH "/journal.bin"
+#endif
+
+#ifndef JOURNAL_INDEX_PATH
+#define JOURNAL_INDEX_PATH "/journal.idx"
+#endif
+
+#define JOURNAL_INDEX_PATH_1 JOURNAL_INDEX_PATH ".1"
+
+// Journal storage on an Arduino filesystem (SD, LittleFS, ...)
+class FsStorage
+{
+public:
+    explicit FsStorage(fs::FS& fs) : fs_(fs) {}
+
+    size_t read(uint32_t offset, void* data, size_t length)
+    {
+        File file = fs_.open(JOURNAL_DATA_PATH, FILE_READ);
+        if (!file || !file.seek(offset))
+        {
+            return 0;
+        }
+        size_t n = file.read((uint8_t*)data, length);
+        file.close();
+        return n;
+    }
+
+    bool append(const void* data, size_t length)
+    {
+        File file = fs_.open(JOURNAL_DATA_PATH, FILE_APPEND);
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = file.write((const uint8_t*)data, length);
+        file.close();
+        return n == length;
+    }
+
+    uint32_t size()
+    {
+        File file = fs_.open(JOURNAL_DATA_PATH, FILE_READ);
+        if (!file)
+        {
+            return 0;
+        }
+        uint32_t n = file.size();
+        file.close();
+        return n;
+    }
+
+    // Only ever asked to cut off a torn tail or to empty the file
+    bool truncate(uint32_t length)
+    {
+        if (length == 0)
+        {
+            return !fs_.exists(JOURNAL_DATA_PATH) || fs_.remove(JOURNAL_DATA_PATH);
+        }
+        // No truncate in fs::File: copy the good prefix to a new file
+        File in = fs_.open(JOURNAL_DATA_PATH, FILE_READ);
+        File out = fs_.open(JOURNAL_DATA_PATH ".tmp", FILE_WRITE);
+        if (!in || !out)
+        {
+            return false;
+        }
+        uint8_t chunk[JOURNAL_BLOCK_SIZE];
+        uint32_t copied = 0;
+        while (copied < length)
+        {
+            size_t n = in.read(chunk, sizeof(chunk) < length - copied ? sizeof(chunk) : length - copied);
+            if (n == 0 || out.write(chunk, n) != n)
+            {
+                break;
+            }
+            copied += n;
+        }
+        in.close();
+        out.close();
+        return copied == length && fs_.remove(JOURNAL_DATA_PATH) && fs_.rename(JOURNAL_DATA_PATH ".tmp", JOURNAL_DATA_PATH);
+    }
+
+    bool readIndex(uint8_t copy, void* data, size_t length)
+    {
+        File file = fs_.open(copy ? JOURNAL_INDEX_PATH_1 : JOURNAL_INDEX_PATH, FILE_READ);
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = file.read((uint8_t*)data, length);
+        file.close();
+        return n == length;
+    }
+
+    bool writeIndex(uint8_t copy, const void* data, size_t length)
+    {
+        File file = fs_.open(copy ? JOURNAL_INDEX_PATH_1 : JOURNAL_INDEX_PATH, FILE_WRITE);
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = file.write((const uint8_t*)data, length);
+        file.close();
+        return n == length;
+    }
+
+private:
+    fs::FS& fs_;
+};
+#endif // ARDUINO
+
+#endif // JOURNAL_H
@@ -0,0 +1,116 @@
+#ifndef LOG_DRAIN_H
+#define LOG_DRAIN_H
+
+#include <Arduino.h>
+#include "logger.h"
+#include "network.h"
+
+#ifndef LOG_FLUSH_INTERVAL
+#define LOG_FLUSH_INTERVAL 60000    // ms between log uploads
+#endif
+
+#ifndef LOG_BATCH_SIZE
+#define LOG_BATCH_SIZE 16           // Max entries per uploaded message
+#endif
+
+#ifndef LOG_COMPACT_UPLOAD
+#define LOG_COMPACT_UPLOAD 1        // 1: send packed records (decode with tools/log_decode.py), 0: send text
+#endif
+
+// Room left in each message for the "(n dropped)" note
+#define LOG_MESSAGE_LIMIT (TG_MESSAGE_SIZE - 1 - 24)
+
+// Background task that empties the Logger ring.
+// Once per flush interval it collects up to LOG_BATCH_SIZE pending
+// entries into a single Telegram message, instead of one request per
+// log call. A batch too long for one message (text mode) goes out as
+// several, split between entries. While WiFi is down nothing is
+// drained, so the ring's overflow policy (not the heap) bounds how much
+// is kept.
+//
+// In compact mode each entry goes out as its 18-char packed record
+// rather than ~50 bytes of text.
+class LogDrain
+{
+public:
+    LogDrain(Logger& logger, Network& network) : logger_(logger), network_(network), lastDropped_(0), task_(nullptr) {}
+
+    void begin()
+    {
+        // Core 0 keeps uploads off the loop() core
+        xTaskCreatePinnedToCore(run, "log_drain", 6144, this, 1, &task_, 0);
+    }
+
+    // Upload one batch now; returns the number of entries sent
+    int flush()
+    {
+        if (WiFi.status() != WL_CONNECTED || logger_.pending() == 0)
+        {
+            return 0;
+        }
+
+        Logger::LogEntry entry;
+        int count = 0;
+#if LOG_COMPACT_UPLOAD
+        const char* header = "*Log:* ";
+#else
+        const char* header = "*Log:*";
+#endif
+        String text = header;
+        while (count < LOG_BATCH_SIZE && logger_.get_log(entry))
+        {
+#if LOG_COMPACT_UPLOAD
+            char line[LOG_RECORD_HEX + 1];
+            Logger::encode(entry, line);
+#else
+            char stamp[24];
+            char message[64];
+            char line[96];
+            Logger::formatTime(entry.timestamp, stamp, sizeof(stamp));
+            Logger::formatMessage(entry, message, sizeof(message));
+            snprintf(line, sizeof(line), "%%0A%s %s", stamp, message);
+#endif
+            // Split between entries rather than let the transport reject it
+            if (text.length() + strlen(line) > LOG_MESSAGE_LIMIT)
+            {
+                network_.send_text(text);
+                text = header;
+            }
+            text += line;
+            count++;
+        }
+
+        uint32_t dropped = logger_.dropped();
+        if (dropped != lastDropped_)
+        {
+            text += "%0A(";
+            text += String(dropped - lastDropped_);
+            text += " dropped)";
+            lastDropped_ = dropped;
+        }
+
+        if (count > 0)
+        {
+            network_.send_text(text);
+        }
+        return count;
+    }
+
+private:
+    static void run(void* arg)
+    {
+        LogDrain* self = static_cast<LogDrain*>(arg);
+        for (;;)
+        {
+            vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_INTERVAL));
+            self->flush();
+        }
+    }
+
+    Logger& logger_;
+    Network& network_;
+    uint32_t lastDropped_;
+    TaskHandle_t task_;
+};
+
+#endif // LOG_DRAIN_H
@@ -0,0 +1,23 @@
+#ifndef LOG_MESSAGES_H
+#define LOG_MESSAGES_H
+
+// Interned log messages.
+// Only the ID (and one integer argument, for %d) is recorded and sent;
+// tools/log_decode.py expands IDs back to text from this table.
+// IDs are positional - only ever append new messages at the end.
+#define LOG_MESSAGES(X) \
+    X(LOG_NONE,                "No log") \
+    X(LOG_SETUP_STARTED,       "Setup started...") \
+    X(LOG_SSD1306_FAILED,      "SSD1306 allocation failed") \
+    X(LOG_WIFI_CONNECTING,     "Connecting to WiFi...") \
+    X(LOG_WIFI_CONNECTED,      "Connected to WiFi") \
+    X(LOG_BOOTING,             "Booting...") \
+    X(LOG_POWER_CUT,           "Suspected power cut. Connecting to WiFi...") \
+    X(LOG_DHT_READ_FAILED,     "Failed to read from DHT sensor!") \
+    X(LOG_SENSOR_ERROR,        "Error in reading sensor") \
+    X(LOG_SD_FAILED,           "SD card journal unavailable") \
+    X(LOG_MIC_FAILED,          "I2S microphone init failed") \
+    X(LOG_HISTORY_FAILED,      "LittleFS history unavailable") \
+    X(LOG_ALERT_RULE_INVALID,  "Alert rule ignored, could not parse")
+
+#endif // LOG_MESSAGES_H
@@ -1,24 +1,70 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
-#include <queue>
-#include <string>
-#include <mutex>
-#include <chrono>
-#include <ctime>
-#include <sstream>
-#include <iomanip>
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <stdio.h>
+#include <log_record.h>
+#include "log_messages.h"
 
+#ifdef ARDUINO
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#define LOG_IRAM IRAM_ATTR      // log() may run from an ISR with the flash cache off
+#else
+#define LOG_IRAM
+#endif
+
+#ifndef LOG_CAPACITY
+#define LOG_CAPACITY 32         // Entries in the ring, must be a power of two
+#endif
+
+#define LOG_AS_ID(id, format) id,
+#define LOG_AS_FORMAT(id, format) format,
+
+enum LogId : uint8_t
+{
+    LOG_MESSAGES(LOG_AS_ID)
+    LOG_ID_COUNT
+};
+
+// Lock-free, fixed-capacity log ring.
+// Any number of tasks (or ISRs) may call log() concurrently and drain
+// with get_log(). Entries are plain structs copied into preallocated
+// slots, so logging never touches the heap and never blocks.
+// Timestamps are stored as epoch seconds and messages as interned IDs
+// (see log_messages.h); text is only produced when the consumer asks
+// for it.
+//
+// time() takes a newlib lock, so an ISR can't call it. Inside an ISR
+// the timestamp is the esp_timer uptime plus the epoch offset cached
+// by the last log() from a task; the ISR path is kept in IRAM.
+//
+// When the ring is full the overflow policy decides what is lost:
+// DropNewest rejects the incoming entry, DropOldest evicts the oldest
+// queued one to make room. Both are counted. DropOldest falls back to
+// dropping the incoming entry when the oldest slot is claimed but not
+// yet written, so log() never waits on another producer.
 class Logger
 {
 public:
+    enum OverflowPolicy
+    {
+        DropNewest,
+        DropOldest
+    };
+
     struct LogEntry
     {
-        std::string timestamp;
+        uint32_t timestamp;     // Epoch seconds, stamped by log()
         float tempC;
         float tempF;
         float humidity;
-        std::string log;
+        LogId id;
+        int32_t arg;            // Value for a %d in the message, if any
     };
 
     static Logger& getInstance()
@@ -27,43 +73,219 @@ public:
         return instance;
     }
 
-    void log(const LogEntry& log)
+    void setOverflowPolicy(OverflowPolicy policy)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        LogEntry entry;
-        entry.timestamp = getCurrentTime();
-        entry.tempC = log.tempC;
-        entry.tempF = log.tempF;
-        entry.humidity = log.humidity;
-        entry.log = log.log;
-        logQueue_.push(entry);
+        policy_ = policy;
+    }
+
+    // Returns false if the ring was full and the entry was dropped
+    LOG_IRAM bool log(const LogEntry& log)
+    {
+        uint32_t pos;
+        Slot* slot = claim(pos);
+        if (!slot)
+        {
+            return false;
+        }
+        publish(slot, pos, log);
+        return true;
+    }
+
+    LOG_IRAM bool log(LogId id, int32_t arg = 0)
+    {
+        LogEntry entry = {0, 0, 0, 0, id, arg};
+        return log(entry);
     }
 
     bool get_log(LogEntry& entry)
     {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (logQueue_.empty())
+        if (!dequeue(entry))
         {
-            entry = {getCurrentTime(), 0, 0, 0, "No log"};
+            entry = {(uint32_t)time(nullptr), 0, 0, 0, LOG_NONE, 0};
             return false;
         }
-        entry = logQueue_.front();
-        logQueue_.pop();
         return true;
     }
 
+    // Most recently logged message, whether or not it has been drained
+    LogId last() const
+    {
+        return (LogId)lastId_.load(std::memory_order_relaxed);
+    }
+
+    // Entries currently queued (approximate while producers are active)
+    uint32_t pending() const
+    {
+        return enqueuePos_.load(std::memory_order_relaxed) - dequeuePos_.load(std::memory_order_relaxed);
+    }
+
+    // Formats an entry's timestamp as "YYYY-MM-DD HH:MM:SS"
+    static void formatTime(uint32_t timestamp, char* out, size_t size)
+    {
+        time_t t = (time_t)timestamp;
+        struct tm tm;
+        localtime_r(&t, &tm);
+        strftime(out, size, "%Y-%m-%d %X", &tm);
+    }
+
+    // Expands an entry's message to text
+    static void formatMessage(const LogEntry& entry, char* out, size_t size)
+    {
+        static const char* const formats[] = {LOG_MESSAGES(LOG_AS_FORMAT)};
+        const char* format = entry.id < LOG_ID_COUNT ? formats[entry.id] : "?";
+        snprintf(out, size, format, entry.arg);
+    }
+
+    // Writes the packed record as LOG_RECORD_HEX hex chars + terminator
+    static void encode(const LogEntry& entry, char* out)
+    {
+        encodeLogRecord(entry.timestamp, entry.id, entry.arg, out);
+    }
+
+    // Entries lost because the ring was full
+    uint32_t droppedNewest() const
+    {
+        return droppedNewest_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t droppedOldest() const
+    {
+        return droppedOldest_.load(std::memory_order_relaxed);
+    }
+
+    uint32_t dropped() const
+    {
+        return droppedNewest() + droppedOldest();
+    }
+
 private:
-    std::string getCurrentTime()
+#ifdef PIO_UNIT_TESTING
+    friend class LoggerProbe;   // Holds a slot claimed but unpublished
+#endif
+    static_assert((LOG_CAPACITY & (LOG_CAPACITY - 1)) == 0, "LOG_CAPACITY must be a power of two");
+
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence;
+        LogEntry entry;
+    };
+
+    // Epoch seconds, without time() when called from an ISR
+    LOG_IRAM uint32_t now()
+    {
+#ifdef ARDUINO
+        uint32_t uptime = (uint32_t)(esp_timer_get_time() / 1000000);
+        if (xPortInIsrContext())
+        {
+            return uptime + epochOffset_.load(std::memory_order_relaxed);
+        }
+        uint32_t t = (uint32_t)time(nullptr);
+        epochOffset_.store(t - uptime, std::memory_order_relaxed);
+        return t;
+#else
+        return (uint32_t)time(nullptr);
+#endif
+    }
+
+    // Claims the slot for the next position, applying the overflow
+    // policy if the ring is full; nullptr if the entry is to be dropped
+    LOG_IRAM Slot* claim(uint32_t& pos)
     {
-        auto now = std::chrono::system_clock::now();
-        auto in_time_t = std::chrono::system_clock::to_time_t(now);
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&in_time_t), "%Y-%m-%d %X");
-        return ss.str();
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            Slot* slot = &slots_[pos & (LOG_CAPACITY - 1)];
+            uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0)
+            {
+                // Slot is free for this position - try to claim it
+                if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    return slot;
+                }
+            }
+            else if (diff < 0)
+            {
+                // Nobody has freed this slot yet: ring is full. The oldest
+                // entry can only be evicted once it is published; if its
+                // producer was preempted between claiming and publishing
+                // (or is the task this ISR interrupted), waiting for it
+                // would never end, so the incoming entry goes instead.
+                LogEntry evicted;
+                if (policy_ == DropNewest || !dequeue(evicted))
+                {
+                    droppedNewest_.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                droppedOldest_.fetch_add(1, std::memory_order_relaxed);
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+            else
+            {
+                pos = enqueuePos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    LOG_IRAM void publish(Slot* slot, uint32_t pos, const LogEntry& log)
+    {
+        slot->entry = log;
+        slot->entry.timestamp = now();
+        lastId_.store(log.id, std::memory_order_relaxed);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    LOG_IRAM bool dequeue(LogEntry& entry)
+    {
+        uint32_t pos = dequeuePos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &slots_[pos & (LOG_CAPACITY - 1)];
+            uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - (pos + 1));
+            if (diff == 0)
+            {
+                if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false; // Empty
+            }
+            else
+            {
+                pos = dequeuePos_.load(std::memory_order_relaxed);
+            }
+        }
+
+        entry = slot->entry;
+        slot->sequence.store(pos + LOG_CAPACITY, std::memory_order_release);
+        return true;
+    }
+
+    Logger() : policy_(DropNewest), enqueuePos_(0), dequeuePos_(0), droppedNewest_(0), droppedOldest_(0), lastId_(LOG_NONE),
+               epochOffset_(0)
+    {
+        for (uint32_t i = 0; i < LOG_CAPACITY; i++)
+        {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
     }
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
 
-    std::queue<LogEntry> logQueue_;
-    std::mutex mutex_;
+    Slot slots_[LOG_CAPACITY];
+    volatile OverflowPolicy policy_;
+    std::atomic<uint32_t> enqueuePos_;
+    std::atomic<uint32_t> dequeuePos_;
+    std::atomic<uint32_t> droppedNewest_;
+    std::atomic<uint32_t> droppedOldest_;
+    std::atomic<uint8_t> lastId_;
+    std::atomic<uint32_t> epochOffset_;  // time() - uptime at the last task-context log()
 };
 
-#endif // LOGGER_H
\ No newline at end of file
+#endif // LOGGER_H
@@ -0,0 +1,244 @@
+#ifndef LOW_POWER_H
+#define LOW_POWER_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_sleep.h>
+#include <time.h>
+#include <wifi_link.h>
+#include "constant.h"
+#include "journal.h"
+#include "ingest.h"
+
+#ifndef LOW_POWER_MODE
+#define LOW_POWER_MODE 0            // 1: deep-sleep between samples, 0: always on
+#endif
+
+#ifndef LOW_POWER_SAMPLE_INTERVAL
+#define LOW_POWER_SAMPLE_INTERVAL 60000 // ms asleep between samples
+#endif
+
+#ifndef LOW_POWER_BATCH
+#define LOW_POWER_BATCH 30          // Samples per WiFi wake-up
+#endif
+
+#ifndef LOW_POWER_WIFI_TIMEOUT
+#define LOW_POWER_WIFI_TIMEOUT 10000 // ms to wait for WiFi before giving up on this wake
+#endif
+
+#ifndef LOW_POWER_SNTP_TIMEOUT
+#define LOW_POWER_SNTP_TIMEOUT 5000 // ms to wait for the clock on each WiFi wake
+#endif
+
+#ifndef NTP_SERVER
+#define NTP_SERVER "pool.ntp.org"
+#endif
+
+#define LOW_POWER_EPOCH_VALID 1600000000UL // time() below this has never been set
+
+// Current draw used for the energy estimate - measure your board and override
+#ifndef LOW_POWER_ACTIVE_MA
+#define LOW_POWER_ACTIVE_MA 30      // CPU awake, radio off
+#endif
+
+#ifndef LOW_POWER_RADIO_MA
+#define LOW_POWER_RADIO_MA 120      // WiFi connecting / transmitting
+#endif
+
+#ifndef LOW_POWER_SLEEP_UA
+#define LOW_POWER_SLEEP_UA 150      // Deep sleep, incl. regulator and DHT
+#endif
+
+#ifndef LOW_POWER_ALWAYS_ON_MA
+#define LOW_POWER_ALWAYS_ON_MA 90   // Average with WiFi associated, for comparison
+#endif
+
+#define LOW_POWER_SUPPLY_V 3.3f
+#define LOW_POWER_CAPACITY (LOW_POWER_BATCH * 2)
+
+static_assert(INGEST_ENCODED_MAX(LOW_POWER_CAPACITY) <= INGEST_BUFFER_SIZE, "a full low-power buffer must fit one POST");
+
+// Everything that must survive deep sleep lives in RTC slow memory
+struct LowPowerState
+{
+    uint32_t magic;
+    uint16_t count;
+    uint16_t retryAt;               // Don't try WiFi again before this many samples
+    JournalRecord readings[LOW_POWER_CAPACITY];
+
+    // Totals since power-on
+    uint32_t wakes;
+    uint32_t samples;
+    uint32_t uploads;
+    uint32_t failedUploads;
+    uint32_t dropped;
+    uint64_t awakeMs;
+    uint64_t radioMs;
+    uint64_t sleepMs;
+};
+
+static RTC_DATA_ATTR LowPowerState lowPowerState;
+
+// Duty-cycled sampling: wake, take one reading into RTC memory, and go
+// back to deep sleep. WiFi is only brought up once LOW_POWER_BATCH
+// readings are waiting, and they go out as one batched upload.
+//
+// The RTC keeps time() running through deep sleep, but it only becomes
+// epoch time once SNTP has run, so every WiFi wake syncs the clock. The
+// first sync also moves readings stamped before it onto the epoch: their
+// time() was counting from power-on, off by the same offset.
+//
+// Radio-on time and awake time are accumulated across wakes, and the
+// energy per reading is estimated from the LOW_POWER_*_MA figures, next
+// to what the always-on loop would use at the same sample rate.
+class LowPower
+{
+public:
+    typedef bool (*UploadFn)(const JournalRecord* readings, uint16_t count);
+
+    LowPower() : state_(lowPowerState)
+    {
+        if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER || state_.magic != JOURNAL_MAGIC)
+        {
+            // Power-on or reset: RTC memory is garbage
+            memset(&state_, 0, sizeof(state_));
+            state_.magic = JOURNAL_MAGIC;
+            state_.retryAt = LOW_POWER_BATCH;
+        }
+        state_.wakes++;
+    }
+
+    void add(float tempC, float humidity)
+    {
+        if (state_.count == LOW_POWER_CAPACITY)
+        {
+            // Uploads keep failing: keep the newest readings
+            memmove(state_.readings, state_.readings + 1, (LOW_POWER_CAPACITY - 1) * sizeof(JournalRecord));
+            state_.count--;
+            state_.dropped++;
+        }
+        JournalRecord& reading = state_.readings[state_.count++];
+        reading.timestamp = (uint32_t)time(nullptr);
+        reading.centiC = (int16_t)lroundf(tempC * 100);
+        reading.centiRH = (int16_t)lroundf(humidity * 100);
+        reading.centiDbA = 0;       // Microphone isn't run in low-power mode
+        reading.reserved = 0;
+        state_.samples++;
+    }
+
+    bool batchReady() const
+    {
+        return state_.count >= state_.retryAt;
+    }
+
+    // Connects, uploads everything buffered, and turns the radio off again
+    bool flush(UploadFn upload)
+    {
+        // Cached BSSID/channel from the last wake makes this the short part
+        uint32_t start = millis();
+        WiFiLink& link = WiFiLink::getInstance();
+        link.begin(WIFI_SSID, WIFI_PASSWORD);
+        bool ok = link.waitConnected(LOW_POWER_WIFI_TIMEOUT);
+        if (ok)
+        {
+            syncClock();
+            ok = upload(state_.readings, state_.count);
+        }
+        link.end();
+        WiFi.disconnect(true);
+        WiFi.mode(WIFI_OFF);
+        state_.radioMs += millis() - start;
+
+        if (ok)
+        {
+            state_.uploads++;
+            state_.count = 0;
+            state_.retryAt = LOW_POWER_BATCH;
+        }
+        else
+        {
+            // Back off a quarter batch before spending radio time again, but
+            // never past a full buffer or batchReady() would stay false
+            state_.failedUploads++;
+            state_.retryAt = min(state_.count + LOW_POWER_BATCH / 4, LOW_POWER_CAPACITY);
+        }
+        return ok;
+    }
+
+    // Estimated energy per reading in microjoules, low-power mode so far
+    float energyPerReadingUj() const
+    {
+        if (state_.samples == 0)
+        {
+            return 0;
+        }
+        float awake = (float)state_.awakeMs * LOW_POWER_ACTIVE_MA;
+        float radio = (float)state_.radioMs * (LOW_POWER_RADIO_MA - LOW_POWER_ACTIVE_MA);
+        float sleep = (float)state_.sleepMs * LOW_POWER_SLEEP_UA / 1000.0f;
+        return (awake + radio + sleep) * LOW_POWER_SUPPLY_V / state_.samples; // mA * ms * V = uJ
+    }
+
+    // Same estimate for the always-on loop sampling at the same interval
+    static float alwaysOnPerReadingUj()
+    {
+        return (float)LOW_POWER_ALWAYS_ON_MA * LOW_POWER_SAMPLE_INTERVAL * LOW_POWER_SUPPLY_V;
+    }
+
+    const LowPowerState& state() const
+    {
+        return state_;
+    }
+
+    void report(Print& out) const
+    {
+        out.printf("wakes=%lu samples=%lu buffered=%u uploads=%lu failed=%lu dropped=%lu\n",
+                   (unsigned long)state_.wakes, (unsigned long)state_.samples, state_.count,
+                   (unsigned long)state_.uploads, (unsigned long)state_.failedUploads, (unsigned long)state_.dropped);
+        out.printf("awake=%llums radio=%llums energy/reading=%.1fmJ (always on %.1fmJ)\n",
+                   state_.awakeMs + millis(), state_.radioMs,
+                   energyPerReadingUj() / 1000.0f, alwaysOnPerReadingUj() / 1000.0f);
+    }
+
+    // Books this wake's awake time and sleeps; does not return
+    void sleep()
+    {
+        state_.awakeMs += millis();
+        state_.sleepMs += LOW_POWER_SAMPLE_INTERVAL;
+        esp_sleep_enable_timer_wakeup((uint64_t)LOW_POWER_SAMPLE_INTERVAL * 1000);
+        esp_deep_sleep_start();
+    }
+
+private:
+    void syncClock()
+    {
+        time_t before = time(nullptr);
+        uint32_t start = millis();
+        configTime(0, 0, NTP_SERVER);
+        if (before >= (time_t)LOW_POWER_EPOCH_VALID)
+        {
+            return; // Already on the epoch; SNTP corrects drift while the upload runs
+        }
+        while (time(nullptr) < (time_t)LOW_POWER_EPOCH_VALID)
+        {
+            if (millis() - start >= LOW_POWER_SNTP_TIMEOUT)
+            {
+                return; // No answer this wake; readings keep their power-on stamps until the next
+            }
+            delay(50);
+        }
+
+        // Readings from before the first sync were stamped in seconds since power-on
+        int64_t offset = (int64_t)time(nullptr) - before - (millis() - start) / 1000;
+        for (uint16_t i = 0; i < state_.count; i++)
+        {
+            if (state_.readings[i].timestamp < LOW_POWER_EPOCH_VALID)
+            {
+                state_.readings[i].timestamp += (uint32_t)offset;
+            }
+        }
+    }
+
+    LowPowerState& state_;
+};
+
+#endif // LOW_POWER_H
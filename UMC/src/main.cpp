@@ -1,133 +1,309 @@
 #include <Arduino.h>
-#include <DHT.h>
-#include <Wire.h>
-#include <Adafruit_Sensor.h>
-#include <Adafruit_SSD1306.h>
 #include <WiFi.h>
 #include <time.h>
 #include <SD.h>
-#include "driver/i2s.h"
+#include <LittleFS.h>
+#include <wifi_link.h>
+#include <dht_rmt.h>
+#include <oled_display.h>
+#include <i2c_bus.h>
 #include "constant.h"
 #include "buzzer.h"
 #include "logger.h"
 #include "network.h"
+#include "log_drain.h"
+#include "scheduler.h"
+#include "journal.h"
+#include "low_power.h"
+#include "metrics.h"
+#include "microphone.h"
+#include "history.h"
+#include "alerts.h"
+
+#ifndef SD_CS_PIN
+#define SD_CS_PIN 5                 // SD card chip select (VSPI default)
+#endif
+
+#ifndef SENSOR_INTERVAL
+#define SENSOR_INTERVAL 2000        // ms between DHT reads (DHT11 needs >= 1s)
+#endif
+
+#ifndef DISPLAY_INTERVAL
+#define DISPLAY_INTERVAL 500        // ms between OLED refreshes
+#endif
+
+#ifndef BEEP_INTERVAL
+#define BEEP_INTERVAL 5000          // ms between heartbeat beeps
+#endif
+
+#ifndef STATS_INTERVAL
+#define STATS_INTERVAL 60000        // ms between scheduler reports on Serial
+#endif
+
+#ifndef METRICS_POLL_INTERVAL
+#define METRICS_POLL_INTERVAL 50    // ms between checks for a metrics scrape
+#endif
+
+#ifndef NTP_SERVER
+#define NTP_SERVER "pool.ntp.org"   // History needs wall-clock time
+#endif
 
 
 #define DHTTYPE DHT11 // DHT11 or DHT22
-DHT dht(DHTPIN, DHTTYPE);
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
+DhtRmt<DHTPIN, DHTTYPE> sensor;
+OledDisplay<SCREEN_WIDTH, SCREEN_HEIGHT, OLED_ADDRESS, OLED_RESET> display;
+I2cBus i2cBus(Wire);
 Logger& logger = Logger::getInstance();
 Buzzer& buzzer = Buzzer::getInstance();
 Network& network = Network::getInstance();
+WiFiLink& wifiLink = WiFiLink::getInstance();
+Metrics& metrics = Metrics::getInstance();
+Microphone microphone;
+LogDrain logDrain(logger, network);
+Scheduler scheduler;
+FsStorage sdStorage(SD);
+IngestBatcher::SdJournal journal(sdStorage);
+FsHistoryStorage historyStorage(LittleFS);
+FsHistory history(historyStorage);
+HistoryServer historyServer(history);
+AlertEngine alerts;
 
-float tempC, tempF, humidity;
+Reading latest;
+bool readingReady = false;          // New reading not yet handed to network
+bool sensorFailed = false;
+volatile bool wifiDown = false;
 
 
-void setup()
+// Only rule transitions are sent, straight away rather than in the digest
+void onAlert(const AlertEvent& event)
 {
-    Serial.begin(BAUD_RATE);
-    logger.log({0, 0, 0, 0, "Setup started..."});
-    network.send();
-    buzzer.play(1000, 500);
+    char text[96];
+    snprintf(text, sizeof(text), "%s%s (now %.1f)", event.firing ? "" : "Resolved: ", alerts.describe(event.rule), event.value);
+    network.alert(text);
+    if (event.firing)
+    {
+        metrics.inc(MC_ALERTS_FIRED);
+    }
+}
 
-    // Start the DHT sensor
-    dht.begin();
+void sampleSensor()
+{
+    uint32_t conversionUs;
+    bool ok = sensor.read(latest, &conversionUs);
+    if (conversionUs != 0)
+    {
+        metrics.observe(MH_DHT_READ, conversionUs);
+    }
+    metrics.inc(MC_DHT_READS);
+    if (!ok)
+    {
+        metrics.inc(MC_DHT_FAILURES);
+        if (!sensorFailed)
+        {
+            logger.log(LOG_DHT_READ_FAILED);
+            logger.log(LOG_SENSOR_ERROR);
+            network.alert("Failed to read from DHT sensor");
+        }
+        sensorFailed = true;
+        return;
+    }
+    sensorFailed = false;
+    readingReady = true;
+    history.add((uint32_t)time(nullptr), latest.tempC, latest.humidity);
+    alerts.evaluate(millis(), latest.tempC, latest.humidity, microphone.latest().dbA, onAlert);
+}
 
-    // Initialize the OLED display
-    if (!display.begin(SSD1306_BLACK, OLED_ADDRESS))
-    { // Default I2C address is 0x3C
-        logger.log({0, 0, 0, 0, "SSD1306 allocation failed"});
-        for (;;); // Halt the program
+// Hands the latest reading to the Telegram digest and ingest batcher
+void upload()
+{
+    if (!readingReady)
+    {
+        return;
     }
+    readingReady = false;
+    network.record(latest.tempC, latest.tempF, latest.humidity, microphone.takeLeqDbA());
+}
 
-    // Clear the display
-    display.clearDisplay();
-    display.display();
+void refreshDisplay()
+{
+    uint32_t start = micros();
+    if (wifiDown)
+    {
+        display.showMessage(F("Suspected power cut. Connecting to WiFi..."));
+    }
+    else if (sensorFailed)
+    {
+        display.showError();
+    }
+    else
+    {
+        display.showReading(latest);
+    }
+    metrics.observe(MH_DISPLAY, micros() - start);
+}
 
-    // Connect to WiFi
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
-    while (WiFi.status() != WL_CONNECTED)
+void beep()
+{
+    buzzer.start(1000, 500);
+}
+
+// Called by WiFiLink on link changes; reconnecting is its job
+void onLinkChange(bool up)
+{
+    wifiDown = !up;
+    logger.log(up ? LOG_WIFI_CONNECTED : LOG_POWER_CUT);
+}
+
+void reportStats()
+{
+    scheduler.report(Serial);
+    metrics.write(Serial);
+
+    SoundAnalyzer::Result sound = microphone.latest();
+    Serial.printf("sound %.1f dBA, bands:", sound.dbA);
+    for (uint8_t b = 0; b < SOUND_BAND_COUNT; b++)
     {
-        delay(DELAY);
-        logger.log({0, 0, 0, 0, "Connecting to WiFi..."});
+        Serial.printf(" %g:%.0f", SoundAnalyzer::bandCentre(b), sound.bands[b]);
     }
-    logger.log({0, 0, 0, 0, "Connected to WiFi"});
+    Serial.println();
 
-    // Display startup message
-    display.setTextSize(1);
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0, 0);
-    display.println(F("Booting..."));
-    logger.log({0, 0, 0, 0, "Booting..."});
-    display.display();
-    delay(SHORT_DELAY);
+    DirtySSD1306::Stats panel = display.raw().stats();
+    if (panel.frames > 0)
+    {
+        Serial.printf("display: %lu frames, %lu bytes/frame (full frame %lu), %lu us/frame\n",
+                      (unsigned long)panel.frames, (unsigned long)(panel.bytes / panel.frames),
+                      (unsigned long)display.raw().fullFrameBusBytes(), (unsigned long)(panel.micros / panel.frames));
+    }
+    i2cBus.report(Serial);
 
+    FsHistory::Stats stored = history.stats();
+    Serial.printf("history: %lu samples, %lu flushes, %lu bytes written, %lu write errors\n",
+                  (unsigned long)stored.samples, (unsigned long)stored.flushes,
+                  (unsigned long)stored.bytesWritten, (unsigned long)stored.writeErrors);
 }
 
-void loop()
+void pollMetrics()
 {
-    delay(SHORT_DELAY);
+    metrics.poll();
+}
+
+void pollHistory()
+{
+    historyServer.poll();
+}
+
+bool postBatch(const JournalRecord* readings, uint16_t count)
+{
+    return network.post_batch(readings, count);
+}
+
+// LOW_POWER_MODE: one sample per wake, WiFi only every LOW_POWER_BATCH
+// samples, deep sleep in between. The display stays off.
+void lowPowerCycle()
+{
+    LowPower lowPower;
+    Reading reading;
+    sensor.begin();
+    if (sensor.wait(DHT_RMT_TIMEOUT + 30) && sensor.read(reading))
+    {
+        lowPower.add(reading.tempC, reading.humidity);
+    }
+    if (lowPower.batchReady())
+    {
+        lowPower.flush(postBatch);
+        lowPower.report(Serial);
+    }
+    lowPower.sleep();
+}
+
+void setup()
+{
+    Serial.begin(BAUD_RATE);
+#if LOW_POWER_MODE
+    lowPowerCycle(); // Does not return
+#endif
+    // Keep the most recent history if uploads fall behind
+    logger.setOverflowPolicy(Logger::DropOldest);
+    logger.log(LOG_SETUP_STARTED);
+    network.send_text("*Log: *Setup started...");
     buzzer.play(1000, 500);
-    while (WiFi.status() != WL_CONNECTED)
+
+    if (alerts.begin() > 0)
+    {
+        logger.log(LOG_ALERT_RULE_INVALID);
+    }
+
+    // Start the DHT sensor and microphone
+    sensor.begin();
+    if (!microphone.begin())
     {
-        delay(LONG_DELAY);
-        logger.log({0, 0, 0, 0, "Suspected power cut. Connecting to WiFi..."});
-        display.clearDisplay();
-        display.setCursor(0, 0);
-        display.println(F("Suspected power cut. Connecting to WiFi..."));
-        display.display();
+        logger.log(LOG_MIC_FAILED);
     }
 
-    while (WiFi.status() != WL_CONNECTED)
+    // Initialize the OLED display
+    if (!display.begin())
+    {
+        logger.log(LOG_SSD1306_FAILED);
+        for (;;); // Halt the program
+    }
+    // Frames go out from the bus task, so a redraw doesn't hold up the scheduler
+    if (i2cBus.begin())
     {
-        delay(DELAY*6);
-        logger.log("Connecting to WiFi...");
+        display.raw().useBus(&i2cBus);
     }
 
-    // Read temperature and humidity values
-    humidity = dht.readHumidity();
-    tempC = dht.readTemperature(); // Celsius
-    tempF = dht.readTemperature(true); // Fahrenheit
+    // Readings taken during outages are kept on the SD card
+    if (SD.begin(SD_CS_PIN) && journal.begin())
+    {
+        network.attach_journal(&journal);
+    }
+    else
+    {
+        logger.log(LOG_SD_FAILED);
+    }
 
-    // Check if any reads failed
-    if (isnan(humidity) || isnan(tempC) || isnan(tempF))
+    // Local history of readings and rollups in the flash filesystem
+    if (!LittleFS.begin(true) || !history.begin())
     {
-        logger.log({0, 0, 0, 0, "Failed to read from DHT sensor!"});
-        // Display error message on OLED
-        display.clearDisplay();
-        display.setCursor(0, 0);
-        display.println(F("Error reading sensor"));
-        logger.log({0, 0, 0, 0, "Error in reading sensor"});
-        display.display();
-        network.send();
-        return;
+        logger.log(LOG_HISTORY_FAILED);
     }
 
-    // Send DHT data to Network
-    network.send();
-
-    // Print the results
-    // Serial.print(F("Humidity: "));
-    // Serial.print(humidity);
-    // Serial.print(F("%  Temperature: "));
-    // Serial.print(tempC);
-    // Serial.print(F("°C "));
-    // Serial.print(tempF);
-    // Serial.println(F("°F"));
-
-    // Display readings on OLED
-    display.clearDisplay();
-    display.setTextSize(1);
-    display.setCursor(0, 0);
-    display.println(F("DHT Sensor Readings:"));
-    display.setTextSize(2);
-    display.setCursor(0, 16);
-    display.print(F("T: "));
-    display.print(tempC);
-    display.println(F(" C"));
-    display.setCursor(0, 40);
-    display.print(F("H: "));
-    display.print(humidity);
-    display.println(F("%"));
-    display.display();
+    // Connect to WiFi
+    wifiLink.begin(WIFI_SSID, WIFI_PASSWORD);
+    while (!wifiLink.waitConnected(DELAY))
+    {
+        logger.log(LOG_WIFI_CONNECTING);
+    }
+    logger.log(LOG_WIFI_CONNECTED);
+    wifiLink.subscribe(onLinkChange);
+    network.begin();
+    logDrain.begin();
+    metrics.begin();
+    configTime(0, 0, NTP_SERVER);
+    historyServer.begin();
+
+    // Display startup message
+    display.showMessage(F("Booting..."));
+    logger.log(LOG_BOOTING);
+    delay(SHORT_DELAY);
+
+    scheduler.add("sensor", sampleSensor, SENSOR_INTERVAL);
+    scheduler.add("upload", upload, SENSOR_INTERVAL);
+    scheduler.add("display", refreshDisplay, DISPLAY_INTERVAL);
+    scheduler.add("beep", beep, BEEP_INTERVAL);
+    scheduler.add("stats", reportStats, STATS_INTERVAL);
+    scheduler.add("metrics", pollMetrics, METRICS_POLL_INTERVAL);
+    scheduler.add("history", pollHistory, METRICS_POLL_INTERVAL);
+}
+
+void loop()
+{
+    static uint32_t lastPass = micros();
+    uint32_t now = micros();
+    metrics.observe(MH_LOOP_PERIOD, now - lastPass);
+    lastPass = now;
+
+    // Sleeps until the next task is due, or the tone has to stop
+    scheduler.run([] { return buzzer.msUntilUpdate(); });
+    buzzer.update();
 }
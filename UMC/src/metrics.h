@@ -0,0 +1,262 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <WiFi.h>
+#include <WebServer.h>
+
+#ifndef METRICS_PORT
+#define METRICS_PORT 9100           // Prometheus node-exporter convention
+#endif
+
+// Metric tables. Like log_messages.h, names are defined once here and
+// expanded into enums and exported names.
+#define METRIC_COUNTERS(X) \
+    X(MC_DHT_READS,          "umc_dht_reads_total",              "DHT reads attempted") \
+    X(MC_DHT_FAILURES,       "umc_dht_failures_total",           "DHT reads that returned NaN") \
+    X(MC_TELEGRAM_SENT,      "umc_telegram_sent_total",          "Telegram messages delivered") \
+    X(MC_TELEGRAM_FAILED,    "umc_telegram_failed_total",        "Telegram requests that failed") \
+    X(MC_TELEGRAM_DROPPED,   "umc_telegram_dropped_total",       "Telegram messages dropped, outbox full") \
+    X(MC_TELEGRAM_OVERSIZED, "umc_telegram_oversized_total",     "Telegram messages rejected, longer than TG_MESSAGE_SIZE") \
+    X(MC_INGEST_POSTS,       "umc_ingest_posts_total",           "Ingest batches posted") \
+    X(MC_INGEST_FAILED,      "umc_ingest_failed_total",          "Ingest batches that failed to post") \
+    X(MC_ALERTS_FIRED,       "umc_alerts_fired_total",           "Alert rules that started firing")
+
+#define METRIC_GAUGES(X) \
+    X(MG_HEAP_FREE,          "umc_heap_free_bytes",              "Free heap") \
+    X(MG_HEAP_MIN_FREE,      "umc_heap_min_free_bytes",          "Lowest free heap since boot") \
+    X(MG_HEAP_LARGEST,       "umc_heap_largest_block_bytes",     "Largest allocatable block (fragmentation)") \
+    X(MG_WIFI_RSSI,          "umc_wifi_rssi_dbm",                "WiFi signal strength") \
+    X(MG_UPTIME,             "umc_uptime_seconds",               "Seconds since boot") \
+    X(MG_SOUND_DBA,          "umc_sound_level_dba",              "A-weighted sound level, last frame")
+
+#define METRIC_HISTOGRAMS(X) \
+    X(MH_LOOP_PERIOD,        "umc_loop_period_seconds",          "Time between loop() wakeups") \
+    X(MH_DHT_READ,           "umc_dht_read_seconds",             "DHT conversion, start pulse to decoded") \
+    X(MH_DISPLAY,            "umc_display_refresh_seconds",      "OLED refresh duration") \
+    X(MH_TELEGRAM_REQUEST,   "umc_telegram_request_seconds",     "Telegram HTTP request duration") \
+    X(MH_TELEGRAM_LATENCY,   "umc_telegram_latency_seconds",     "Telegram enqueue to delivery") \
+    X(MH_INGEST_POST,        "umc_ingest_post_seconds",          "Ingest POST duration")
+
+// Upper bounds of the histogram buckets in microseconds; +Inf is implied
+#define METRIC_BUCKETS_US {100, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000, 30000000}
+#define METRIC_BUCKET_COUNT 10
+
+#define METRIC_AS_ID(id, name, help) id,
+#define METRIC_AS_NAME(id, name, help) name,
+#define METRIC_AS_HELP(id, name, help) help,
+
+enum MetricCounter : uint8_t
+{
+    METRIC_COUNTERS(METRIC_AS_ID)
+    METRIC_COUNTER_COUNT
+};
+
+enum MetricGauge : uint8_t
+{
+    METRIC_GAUGES(METRIC_AS_ID)
+    METRIC_GAUGE_COUNT
+};
+
+enum MetricHistogram : uint8_t
+{
+    METRIC_HISTOGRAMS(METRIC_AS_ID)
+    METRIC_HISTOGRAM_COUNT
+};
+
+// Runtime metrics: counters, gauges and fixed-bucket latency histograms.
+// Every record call is a relaxed atomic add or store into a statically
+// sized array - no locks, no allocation - so it is safe from any task.
+// Text is only built when someone reads the metrics, either by scraping
+// http://<device>:METRICS_PORT/metrics (Prometheus text format) or with
+// write(Serial).
+//
+// Heap, RSSI and stack high-water marks are sampled at read time rather
+// than recorded.
+class Metrics
+{
+public:
+    static Metrics& getInstance()
+    {
+        static Metrics instance;
+        return instance;
+    }
+
+    void inc(MetricCounter id, uint32_t n = 1)
+    {
+        counters_[id].fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void set(MetricGauge id, int32_t value)
+    {
+        gauges_[id].store(value, std::memory_order_relaxed);
+    }
+
+    void observe(MetricHistogram id, uint32_t us)
+    {
+        static const uint32_t bounds[METRIC_BUCKET_COUNT] = METRIC_BUCKETS_US;
+        Histogram& h = histograms_[id];
+        uint8_t bucket = 0;
+        while (bucket < METRIC_BUCKET_COUNT && us > bounds[bucket])
+        {
+            bucket++;
+        }
+        h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        h.count.fetch_add(1, std::memory_order_relaxed);
+        // Sum in us as a 32-bit value plus a count of its wraps: 64-bit
+        // atomics aren't lock-free on the ESP32, and whole ms would round
+        // sub-ms observations (loop period, display, DHT) away entirely
+        uint32_t before = h.sumUs.fetch_add(us, std::memory_order_relaxed);
+        if (before + us < before)
+        {
+            h.sumWraps.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Starts the HTTP endpoint; call poll() regularly afterwards
+    void begin()
+    {
+        server_.on("/metrics", [this]() {
+            String body;
+            body.reserve(4096);
+            StringPrint out(body);
+            write(out);
+            server_.send(200, "text/plain; version=0.0.4", body);
+        });
+        server_.begin();
+    }
+
+    void poll()
+    {
+        server_.handleClient();
+    }
+
+    // Prometheus text exposition format
+    void write(Print& out)
+    {
+        sample();
+
+        static const char* const counterNames[] = {METRIC_COUNTERS(METRIC_AS_NAME)};
+        static const char* const counterHelp[] = {METRIC_COUNTERS(METRIC_AS_HELP)};
+        for (uint8_t i = 0; i < METRIC_COUNTER_COUNT; i++)
+        {
+            header(out, counterNames[i], counterHelp[i], "counter");
+            out.printf("%s %lu\n", counterNames[i], (unsigned long)counters_[i].load(std::memory_order_relaxed));
+        }
+
+        static const char* const gaugeNames[] = {METRIC_GAUGES(METRIC_AS_NAME)};
+        static const char* const gaugeHelp[] = {METRIC_GAUGES(METRIC_AS_HELP)};
+        for (uint8_t i = 0; i < METRIC_GAUGE_COUNT; i++)
+        {
+            header(out, gaugeNames[i], gaugeHelp[i], "gauge");
+            out.printf("%s %ld\n", gaugeNames[i], (long)gauges_[i].load(std::memory_order_relaxed));
+        }
+
+        header(out, "umc_task_stack_free_bytes", "Stack high-water mark per task", "gauge");
+        static const char* const tasks[] = {"loopTask", "telegram", "ingest", "log_drain", "wifi_link", "microphone", "dht"};
+        for (const char* task : tasks)
+        {
+            TaskHandle_t handle = xTaskGetHandle(task);
+            if (handle != nullptr)
+            {
+                out.printf("umc_task_stack_free_bytes{task=\"%s\"} %u\n", task, (unsigned)uxTaskGetStackHighWaterMark(handle));
+            }
+        }
+
+        static const uint32_t bounds[METRIC_BUCKET_COUNT] = METRIC_BUCKETS_US;
+        static const char* const histogramNames[] = {METRIC_HISTOGRAMS(METRIC_AS_NAME)};
+        static const char* const histogramHelp[] = {METRIC_HISTOGRAMS(METRIC_AS_HELP)};
+        for (uint8_t i = 0; i < METRIC_HISTOGRAM_COUNT; i++)
+        {
+            const Histogram& h = histograms_[i];
+            header(out, histogramNames[i], histogramHelp[i], "histogram");
+            uint32_t cumulative = 0;
+            for (uint8_t b = 0; b < METRIC_BUCKET_COUNT; b++)
+            {
+                cumulative += h.buckets[b].load(std::memory_order_relaxed);
+                out.printf("%s_bucket{le=\"%g\"} %lu\n", histogramNames[i], bounds[b] / 1e6, (unsigned long)cumulative);
+            }
+            cumulative += h.buckets[METRIC_BUCKET_COUNT].load(std::memory_order_relaxed);
+            out.printf("%s_bucket{le=\"+Inf\"} %lu\n", histogramNames[i], (unsigned long)cumulative);
+            out.printf("%s_sum %.6f\n", histogramNames[i], sumSeconds(h));
+            out.printf("%s_count %lu\n", histogramNames[i], (unsigned long)h.count.load(std::memory_order_relaxed));
+        }
+    }
+
+private:
+    struct Histogram
+    {
+        std::atomic<uint32_t> buckets[METRIC_BUCKET_COUNT + 1];
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> sumUs;    // Low 32 bits of the sum in us ...
+        std::atomic<uint32_t> sumWraps; // ... and how often they have wrapped (every ~71 min)
+    };
+
+    static double sumSeconds(const Histogram& h)
+    {
+        uint32_t wraps, us;
+        do
+        {
+            wraps = h.sumWraps.load(std::memory_order_relaxed);
+            us = h.sumUs.load(std::memory_order_relaxed);
+        } while (wraps != h.sumWraps.load(std::memory_order_relaxed));
+        return (wraps * 4294967296.0 + us) / 1e6;
+    }
+
+    // Appends printed text to a String, for the HTTP response
+    class StringPrint : public Print
+    {
+    public:
+        explicit StringPrint(String& s) : s_(s) {}
+        size_t write(uint8_t c) override
+        {
+            s_ += (char)c;
+            return 1;
+        }
+        size_t write(const uint8_t* buffer, size_t size) override
+        {
+            s_.concat((const char*)buffer, size);
+            return size;
+        }
+
+    private:
+        String& s_;
+    };
+
+    Metrics() : server_(METRICS_PORT)
+    {
+        for (auto& c : counters_) c.store(0, std::memory_order_relaxed);
+        for (auto& g : gauges_) g.store(0, std::memory_order_relaxed);
+        for (auto& h : histograms_)
+        {
+            for (auto& b : h.buckets) b.store(0, std::memory_order_relaxed);
+            h.count.store(0, std::memory_order_relaxed);
+            h.sumUs.store(0, std::memory_order_relaxed);
+            h.sumWraps.store(0, std::memory_order_relaxed);
+        }
+    }
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    void sample()
+    {
+        set(MG_HEAP_FREE, ESP.getFreeHeap());
+        set(MG_HEAP_MIN_FREE, ESP.getMinFreeHeap());
+        set(MG_HEAP_LARGEST, ESP.getMaxAllocHeap());
+        set(MG_WIFI_RSSI, WiFi.status() == WL_CONNECTED ? WiFi.RSSI() : 0);
+        set(MG_UPTIME, millis() / 1000);
+    }
+
+    static void header(Print& out, const char* name, const char* help, const char* type)
+    {
+        out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    std::atomic<uint32_t> counters_[METRIC_COUNTER_COUNT];
+    std::atomic<int32_t> gauges_[METRIC_GAUGE_COUNT];
+    Histogram histograms_[METRIC_HISTOGRAM_COUNT];
+    WebServer server_;
+};
+
+#endif // METRICS_H
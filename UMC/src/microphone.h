@@ -0,0 +1,137 @@
+#ifndef MICROPHONE_H
+#define MICROPHONE_H
+
+#include <Arduino.h>
+#include <math.h>
+#include "driver/i2s.h"
+#include "sound_dsp.h"
+#include "metrics.h"
+
+#ifndef I2S_SCK_PIN
+#define I2S_SCK_PIN 14
+#endif
+
+#ifndef I2S_WS_PIN
+#define I2S_WS_PIN 15
+#endif
+
+#ifndef I2S_SD_PIN
+#define I2S_SD_PIN 32
+#endif
+
+#ifndef I2S_DMA_BUFFERS
+#define I2S_DMA_BUFFERS 4           // DMA descriptors; >= 2 so one fills while one is read
+#endif
+
+#ifndef I2S_DMA_LENGTH
+#define I2S_DMA_LENGTH 256          // Samples per DMA buffer
+#endif
+
+// I2S MEMS microphone (INMP441 style) sound level monitor.
+// The I2S driver fills a ring of DMA buffers in the background; a task
+// on core 1 (the network tasks live on core 0) blocks in i2s_read() for
+// one SOUND_FRAME_SIZE frame at a time and runs SoundAnalyzer on it
+// while the DMA carries on filling the next buffers.
+//
+// The latest frame's result can be read at any time, and takeLeqDbA()
+// returns the energy-averaged A-weighted level since the previous call,
+// which is what goes into each telemetry record.
+class Microphone
+{
+public:
+    Microphone() : task_(nullptr), leqSum_(0), leqFrames_(0), frames_(0), lock_(portMUX_INITIALIZER_UNLOCKED)
+    {
+        latest_ = SoundAnalyzer::Result();
+    }
+
+    bool begin()
+    {
+        i2s_config_t config = {};
+        config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX);
+        config.sample_rate = SOUND_SAMPLE_RATE;
+        config.bits_per_sample = I2S_BITS_PER_SAMPLE_32BIT;
+        config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+        config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+        config.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1;
+        config.dma_buf_count = I2S_DMA_BUFFERS;
+        config.dma_buf_len = I2S_DMA_LENGTH;
+        config.use_apll = false;
+
+        i2s_pin_config_t pins = {};
+        pins.bck_io_num = I2S_SCK_PIN;
+        pins.ws_io_num = I2S_WS_PIN;
+        pins.data_out_num = I2S_PIN_NO_CHANGE;
+        pins.data_in_num = I2S_SD_PIN;
+
+        if (i2s_driver_install(I2S_NUM_0, &config, 0, nullptr) != ESP_OK ||
+            i2s_set_pin(I2S_NUM_0, &pins) != ESP_OK)
+        {
+            return false;
+        }
+        xTaskCreatePinnedToCore(run, "microphone", 4096, this, 2, &task_, 1);
+        return true;
+    }
+
+    SoundAnalyzer::Result latest()
+    {
+        portENTER_CRITICAL(&lock_);
+        SoundAnalyzer::Result result = latest_;
+        portEXIT_CRITICAL(&lock_);
+        return result;
+    }
+
+    // Energy average of the A-weighted level since the last call; 0 if
+    // no frame has completed since
+    float takeLeqDbA()
+    {
+        portENTER_CRITICAL(&lock_);
+        float sum = leqSum_;
+        uint32_t frames = leqFrames_;
+        leqSum_ = 0;
+        leqFrames_ = 0;
+        portEXIT_CRITICAL(&lock_);
+        return frames > 0 ? 10.0f * log10f(sum / frames) : 0;
+    }
+
+    uint32_t frames() const
+    {
+        return frames_;
+    }
+
+private:
+    static void run(void* arg)
+    {
+        Microphone* self = static_cast<Microphone*>(arg);
+        SoundAnalyzer::Result result;
+        for (;;)
+        {
+            size_t bytes = 0;
+            if (i2s_read(I2S_NUM_0, self->samples_, sizeof(self->samples_), &bytes, portMAX_DELAY) != ESP_OK ||
+                bytes != sizeof(self->samples_))
+            {
+                continue;
+            }
+            self->analyzer_.process(self->samples_, result);
+            float energy = powf(10.0f, result.dbA / 10.0f);
+
+            portENTER_CRITICAL(&self->lock_);
+            self->latest_ = result;
+            self->leqSum_ += energy;
+            self->leqFrames_++;
+            portEXIT_CRITICAL(&self->lock_);
+            self->frames_++;
+            Metrics::getInstance().set(MG_SOUND_DBA, lroundf(result.dbA));
+        }
+    }
+
+    SoundAnalyzer analyzer_;        // ~20 KB of tables, so never on a stack
+    int32_t samples_[SOUND_FRAME_SIZE];
+    TaskHandle_t task_;
+    SoundAnalyzer::Result latest_;
+    float leqSum_;
+    uint32_t leqFrames_;
+    volatile uint32_t frames_;
+    portMUX_TYPE lock_;
+};
+
+#endif // MICROPHONE_H
@@ -4,27 +4,28 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <string>
 #include "constant.h"
 #include "logger.h"
+#include "telegram.h"
+#include "digest.h"
+#include "ingest.h"
+
+#ifndef DIGEST_WINDOW
+#define DIGEST_WINDOW 3600000       // ms per Telegram digest; anomalies are sent as alerts
+#endif
 
 extern Logger& logger;
 
 class Network
 {
     private:
-
-        struct LogEntry
-        {
-            std::string timestamp;
-            float tempC;
-            float tempF;
-            float humidity;
-            std::string log;
-        } log;
+        TelegramTransport telegram;
+        TelemetryDigest digest;
+        uint32_t digestStart;
+        IngestBatcher ingest;
     public:
 
-        Network() : log({"0.0", 0.0, 0.0, 0.0, "No log"}) {}
+        Network() : digestStart(0) {}
         ~Network() {}
 
         static Network& getInstance()
@@ -33,87 +34,71 @@ class Network
             return instance;
         }
 
-        String get_tg_url()
+        // Starts the background Telegram sender and ingest uploader
+        void begin()
         {
-            String s;
-            s += String(TG_BASE);
-            s += "*Timestamp: *";
-            s += String(log.timestamp.c_str());
-            s += "%0A*Temperature: *";
-            s += String(log.tempC);
-            s += "%0A*Humidity: *";
-            s += String(log.humidity);
-            s += "%0A*Log: *";
-            s += String(log.log.c_str());
-            s += "&parse_mode=markdown";
-            return s;
+            telegram.begin();
+            ingest.begin();
         }
 
-        void send()
+        // Digest mode: aggregate a reading, and queue one summary message
+        // per DIGEST_WINDOW instead of one message per reading
+        void record(float tempC, float tempF, float humidity, float dbA = 0)
         {
-            if (WiFi.status() == WL_CONNECTED)
+            uint32_t now = millis();
+            if (digest.count() == 0)
             {
-                HTTPClient http;
-                
-                // Send message to Telegram
-                String tg_url = get_tg_url();
-                http.begin(tg_url);
-                int httpResponseCode = http.GET();
-
-                if (httpResponseCode > 0)
-                {
-                    String response = http.getString();
-                    //logger.log("Telegram Response code: " + String(httpResponseCode));
-                    //logger.log("Response: " + response);
-                }
-                else
-                {
-                    //logger.log("Error on sending GET to Telegram: " + String(httpResponseCode));
-                }
-
-                http.end(); // Free resources
-
-                /*
-                http.begin(API_ENDPOINT);
-
-                http.addHeader("Content-Type", "application/json");
-
-                // Create JSON object
-                StaticJsonDocument<200> jsonDoc;
-                jsonDoc["temperatureC"] = tempC;
-                jsonDoc["temperatureF"] = tempF;
-                jsonDoc["humidity"] = humidity;
-                jsonDoc["log"] = log;
-                jsonDoc["timestamp"] = timestamp;
-
-                // Serialize JSON object to string
-                String jsonString;
-
-                serializeJson(jsonDoc, jsonString);
-
-                // Send HTTP POST request
-                int httpResponseCode = http.POST(jsonString);
-
-                if (httpResponseCode > 0)
-                {
-                    String response = http.getString();
-                    Serial.println(httpResponseCode);
-                    Serial.println(response);
-                }
-                else
-                {
-                    Serial.print("Error on sending POST: ");
-                    Serial.println(httpResponseCode);
-                }
-
-                http.end(); // Free resources
-                */
+                digestStart = now;
             }
-            else
+            digest.add(tempC, humidity);
+            ingest.add(tempC, humidity, dbA);
+
+            if (now - digestStart >= DIGEST_WINDOW)
             {
-                Serial.println("WiFi not connected");
+                Logger::LogEntry last = {0, 0, 0, 0, logger.last(), 0};
+                char lastLog[64];
+                Logger::formatMessage(last, lastLog, sizeof(lastLog));
+                telegram.enqueue(digest.format(now - digestStart, lastLog));
+                digest.reset();
             }
         }
+
+        // Alerts skip the digest window and go out ahead of queued messages
+        bool alert(const String& text)
+        {
+            return telegram.enqueue("*ALERT: *" + text, true);
+        }
+
+        // Queue a preformatted Telegram message (lines separated by %0A)
+        bool send_text(const String& text)
+        {
+            return telegram.enqueue(text);
+        }
+
+        // Send latency / handshake counters
+        TelegramTransport::Stats telegram_stats() const
+        {
+            return telegram.stats();
+        }
+
+        // Store-and-forward: readings taken offline go to the journal
+        void attach_journal(IngestBatcher::SdJournal* journal)
+        {
+            ingest.attachJournal(journal);
+        }
+
+        // Synchronous batch upload, bypassing the ingest task
+        bool post_batch(const JournalRecord* readings, uint16_t count)
+        {
+            return ingest.post(readings, count);
+        }
+
+        // Batched MessagePack upload counters
+        IngestBatcher::Stats ingest_stats() const
+        {
+            return ingest.stats();
+        }
+
         void receive() {}
 };
 
@@ -0,0 +1,166 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+#ifndef SCHEDULER_MAX_TASKS
+#define SCHEDULER_MAX_TASKS 8
+#endif
+
+#ifndef SCHEDULER_MAX_SLEEP_MS
+#define SCHEDULER_MAX_SLEEP_MS 1000  // Longest run() sleeps, with no task due sooner
+#endif
+
+// Cooperative run-to-completion scheduler for loop().
+// Each task is a plain function with its own period; run() calls
+// whichever tasks are due, then sleeps until the next one is, so
+// loopTask leaves its core to IDLE and lower-priority tasks in between.
+// Tasks must not block. Deadlines advance by whole periods, so a late task keeps its
+// phase instead of drifting, and a task that falls more than a period
+// behind skips the missed runs rather than bursting to catch up.
+//
+// Per task it records how late each run started (jitter) and how long
+// it ran, which is what shows a task that blocks the others.
+class Scheduler
+{
+public:
+    typedef void (*TaskFn)();
+    typedef uint32_t (*WakeFn)();   // ms until something outside the scheduler needs loop() again
+
+    struct TaskStats
+    {
+        uint32_t runs;
+        uint32_t skipped;           // Periods missed entirely
+        uint32_t maxLateUs;         // Worst start delay past the deadline
+        uint64_t totalLateUs;
+        uint32_t maxRunUs;          // Longest single run
+    };
+
+    Scheduler() : count_(0) {}
+
+    // Returns the task index, or -1 if the table is full
+    int add(const char* name, TaskFn fn, uint32_t periodMs)
+    {
+        if (count_ == SCHEDULER_MAX_TASKS)
+        {
+            return -1;
+        }
+        Task& task = tasks_[count_];
+        task.name = name;
+        task.fn = fn;
+        task.periodUs = periodMs * 1000;
+        task.nextRunUs = micros();
+        task.stats = TaskStats();
+        return count_++;
+    }
+
+    // Call from loop(); runs every task that is due, once, then sleeps
+    // until the next is due. wake, asked after the tasks have run, can
+    // cut the sleep short (the buzzer's next edge, say).
+    void run(WakeFn wake = nullptr)
+    {
+        for (uint8_t i = 0; i < count_; i++)
+        {
+            Task& task = tasks_[i];
+            uint32_t now = micros();
+            int32_t late = (int32_t)(now - task.nextRunUs);
+            if (late < 0)
+            {
+                continue;
+            }
+
+            task.fn();
+            uint32_t ran = micros() - now;
+
+            task.stats.runs++;
+            task.stats.totalLateUs += late;
+            if ((uint32_t)late > task.stats.maxLateUs) task.stats.maxLateUs = late;
+            if (ran > task.stats.maxRunUs) task.stats.maxRunUs = ran;
+
+            task.nextRunUs += task.periodUs;
+            if ((int32_t)(micros() - task.nextRunUs) >= (int32_t)task.periodUs)
+            {
+                uint32_t missed = (micros() - task.nextRunUs) / task.periodUs;
+                task.stats.skipped += missed;
+                task.nextRunUs += missed * task.periodUs;
+            }
+        }
+
+        uint32_t sleepMs = (untilNextUs() + 999) / 1000;
+        if (wake)
+        {
+            sleepMs = min(sleepMs, wake());
+        }
+        if (sleepMs > 0)
+        {
+            vTaskDelay(pdMS_TO_TICKS(sleepMs));
+        }
+    }
+
+    // Time until the earliest task is due, 0 if one already is
+    uint32_t untilNextUs() const
+    {
+        uint32_t now = micros();
+        uint32_t wait = SCHEDULER_MAX_SLEEP_MS * 1000;
+        for (uint8_t i = 0; i < count_; i++)
+        {
+            int32_t left = (int32_t)(tasks_[i].nextRunUs - now);
+            if (left <= 0)
+            {
+                return 0;
+            }
+            wait = min(wait, (uint32_t)left);
+        }
+        return wait;
+    }
+
+    uint8_t size() const
+    {
+        return count_;
+    }
+
+    const TaskStats& stats(uint8_t index) const
+    {
+        return tasks_[index].stats;
+    }
+
+    // One line per task: runs, skipped, avg / max lateness and max run time
+    void report(Print& out) const
+    {
+        for (uint8_t i = 0; i < count_; i++)
+        {
+            const Task& task = tasks_[i];
+            uint32_t avgLate = task.stats.runs ? task.stats.totalLateUs / task.stats.runs : 0;
+            out.printf("%-8s runs=%lu skipped=%lu late avg=%luus max=%luus run max=%luus\n",
+                       task.name,
+                       (unsigned long)task.stats.runs,
+                       (unsigned long)task.stats.skipped,
+                       (unsigned long)avgLate,
+                       (unsigned long)task.stats.maxLateUs,
+                       (unsigned long)task.stats.maxRunUs);
+        }
+    }
+
+    void resetStats()
+    {
+        for (uint8_t i = 0; i < count_; i++)
+        {
+            tasks_[i].stats = TaskStats();
+        }
+    }
+
+private:
+    struct Task
+    {
+        const char* name;
+        TaskFn fn;
+        uint32_t periodUs;
+        uint32_t nextRunUs;
+        TaskStats stats;
+    };
+
+    Task tasks_[SCHEDULER_MAX_TASKS];
+    uint8_t count_;
+};
+
+#endif // SCHEDULER_H
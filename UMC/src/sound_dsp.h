@@ -0,0 +1,248 @@
+#ifndef SOUND_DSP_H
+#define SOUND_DSP_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef SOUND_SAMPLE_RATE
+#define SOUND_SAMPLE_RATE 16000     // Hz
+#endif
+
+#ifndef SOUND_FRAME_SIZE
+#define SOUND_FRAME_SIZE 1024       // Samples per analysis frame, power of two
+#endif
+
+#ifndef MIC_DBFS_AT_94DB
+#define MIC_DBFS_AT_94DB -26.0f     // INMP441 / ICS-43434 sensitivity
+#endif
+
+#define SOUND_BAND_COUNT 8          // Octave bands, 63 Hz .. 8 kHz
+
+// Radix-2 decimation-in-time FFT on interleaved complex floats
+// (re, im, re, im, ...), in place, in the style of esp-dsp's
+// dsps_fft2r_fc32: twiddles and the bit-reversal permutation are
+// precomputed once, the butterflies do no trig and no allocation.
+template <uint16_t N>
+class Fft
+{
+public:
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "FFT size must be a power of two");
+
+    Fft()
+    {
+        for (uint16_t i = 0; i < N / 2; i++)
+        {
+            twiddle_[2 * i] = cosf(2.0f * (float)M_PI * i / N);
+            twiddle_[2 * i + 1] = -sinf(2.0f * (float)M_PI * i / N);
+        }
+        uint16_t bits = 0;
+        while ((1u << bits) < N) bits++;
+        for (uint16_t i = 0; i < N; i++)
+        {
+            uint16_t r = 0;
+            for (uint16_t b = 0; b < bits; b++)
+            {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            reversed_[i] = r;
+        }
+    }
+
+    void run(float* data) const
+    {
+        for (uint16_t i = 0; i < N; i++)
+        {
+            uint16_t j = reversed_[i];
+            if (j > i)
+            {
+                float re = data[2 * i], im = data[2 * i + 1];
+                data[2 * i] = data[2 * j];
+                data[2 * i + 1] = data[2 * j + 1];
+                data[2 * j] = re;
+                data[2 * j + 1] = im;
+            }
+        }
+        for (uint16_t half = 1, step = N / 2; half < N; half *= 2, step /= 2)
+        {
+            for (uint16_t start = 0; start < N; start += 2 * half)
+            {
+                for (uint16_t k = 0; k < half; k++)
+                {
+                    float wr = twiddle_[2 * k * step], wi = twiddle_[2 * k * step + 1];
+                    float* a = data + 2 * (start + k);
+                    float* b = data + 2 * (start + k + half);
+                    float tr = b[0] * wr - b[1] * wi;
+                    float ti = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - tr;
+                    b[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+    }
+
+private:
+    float twiddle_[N];              // N/2 complex: e^(-2*pi*i*k/N)
+    uint16_t reversed_[N];
+};
+
+// Per-frame sound level analysis: RMS, A-weighted level and octave band
+// energies. Takes raw 32-bit I2S words (24-bit mic data left aligned).
+// The N-sample real frame is transformed as an N/2-point complex FFT and
+// split afterwards, which halves the FFT work.
+//
+// Pure C++ with no Arduino dependency, so it also builds on a host.
+class SoundAnalyzer
+{
+public:
+    static const uint16_t N = SOUND_FRAME_SIZE;
+
+    struct Result
+    {
+        float rmsDbfs;              // Unweighted, dB relative to full-scale sine
+        float dbSpl;                // Unweighted, using MIC_DBFS_AT_94DB
+        float dbA;                  // A-weighted SPL
+        float bands[SOUND_BAND_COUNT]; // Band SPL in dB, 63 Hz .. 8 kHz centres
+    };
+
+    SoundAnalyzer()
+    {
+        float sumSquares = 0;
+        for (uint16_t i = 0; i < N; i++)
+        {
+            window_[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / N);
+            sumSquares += window_[i] * window_[i];
+        }
+        // Scale so the weighted bin powers sum to the signal's mean square
+        float meanSquare = sumSquares / N;
+        for (uint16_t k = 0; k <= N / 2; k++)
+        {
+            float side = (k == 0 || k == N / 2) ? 1.0f : 2.0f;
+            binScale_[k] = side / ((float)N * N * meanSquare);
+            aWeight_[k] = aWeighting((float)k * SOUND_SAMPLE_RATE / N);
+            band_[k] = bandOf((float)k * SOUND_SAMPLE_RATE / N);
+        }
+        for (uint16_t k = 0; k < N / 2; k++)
+        {
+            split_[2 * k] = cosf(2.0f * (float)M_PI * k / N);
+            split_[2 * k + 1] = -sinf(2.0f * (float)M_PI * k / N);
+        }
+    }
+
+    void process(const int32_t* samples, Result& result)
+    {
+        // Remove the mic's DC offset, window, and pack pairs of real
+        // samples into complex values for the half-size FFT
+        float mean = 0;
+        for (uint16_t i = 0; i < N; i++)
+        {
+            mean += (float)samples[i];
+        }
+        mean /= N;
+        const float scale = 1.0f / 2147483648.0f;
+        for (uint16_t i = 0; i < N; i++)
+        {
+            buffer_[i] = ((float)samples[i] - mean) * scale * window_[i];
+        }
+        fft_.run(buffer_);
+
+        float total = 0, weighted = 0;
+        float bands[SOUND_BAND_COUNT] = {0};
+        for (uint16_t k = 0; k <= N / 2; k++)
+        {
+            float power = binPower(k) * binScale_[k];
+            total += power;
+            weighted += power * aWeight_[k];
+            if (band_[k] >= 0)
+            {
+                bands[band_[k]] += power;
+            }
+        }
+
+        const float offset = 94.0f - MIC_DBFS_AT_94DB;
+        result.rmsDbfs = toDb(2.0f * total);
+        result.dbSpl = result.rmsDbfs + offset;
+        result.dbA = toDb(2.0f * weighted) + offset;
+        for (uint8_t b = 0; b < SOUND_BAND_COUNT; b++)
+        {
+            result.bands[b] = toDb(2.0f * bands[b]) + offset;
+        }
+    }
+
+    static float bandCentre(uint8_t band)
+    {
+        return 62.5f * (float)(1 << band);
+    }
+
+private:
+    // |X[k]|^2 of the N-point real transform, from the N/2-point complex one
+    float binPower(uint16_t k) const
+    {
+        const uint16_t half = N / 2;
+        uint16_t a = k % half;
+        uint16_t b = (half - k) % half;
+        float zr = buffer_[2 * a], zi = buffer_[2 * a + 1];
+        float cr = buffer_[2 * b], ci = -buffer_[2 * b + 1]; // conj(Z[N/2 - k])
+        float er = 0.5f * (zr + cr), ei = 0.5f * (zi + ci);  // even samples
+        float dr = 0.5f * (zr - cr), di = 0.5f * (zi - ci);  // odd samples * i
+        // X[k] = E + W^k * O, with O = -i * D
+        float orr = di, oi = -dr;
+        float wr, wi;
+        if (k < half)
+        {
+            wr = split_[2 * k];
+            wi = split_[2 * k + 1];
+        }
+        else
+        {
+            wr = -1.0f;
+            wi = 0.0f;
+        }
+        float xr = er + orr * wr - oi * wi;
+        float xi = ei + orr * wi + oi * wr;
+        return xr * xr + xi * xi;
+    }
+
+    // IEC 61672 A-weighting as a power gain
+    static float aWeighting(float f)
+    {
+        if (f <= 0)
+        {
+            return 0;
+        }
+        float f2 = f * f;
+        float ra = 12194.0f * 12194.0f * f2 * f2 /
+                   ((f2 + 20.6f * 20.6f) * sqrtf((f2 + 107.7f * 107.7f) * (f2 + 737.9f * 737.9f)) * (f2 + 12194.0f * 12194.0f));
+        return ra * ra * 1.5849f; // +2.0 dB normalises 1 kHz to 0 dB
+    }
+
+    static int8_t bandOf(float f)
+    {
+        for (uint8_t b = 0; b < SOUND_BAND_COUNT; b++)
+        {
+            float centre = bandCentre(b);
+            if (f >= centre / 1.41421356f && f < centre * 1.41421356f)
+            {
+                return b;
+            }
+        }
+        return -1;
+    }
+
+    static float toDb(float meanSquare)
+    {
+        return 10.0f * log10f(meanSquare > 1e-20f ? meanSquare : 1e-20f);
+    }
+
+    Fft<N / 2> fft_;
+    float buffer_[N];               // N/2 complex values
+    float window_[N];
+    float split_[N];                // N/2 complex: e^(-2*pi*i*k/N)
+    float binScale_[N / 2 + 1];
+    float aWeight_[N / 2 + 1];
+    int8_t band_[N / 2 + 1];
+};
+
+#endif // SOUND_DSP_H
@@ -0,0 +1,210 @@
+#ifndef TELEGRAM_H
+#define TELEGRAM_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include <string.h>
+#include <atomic>
+#include "constant.h"
+#include "digest.h"
+#include "metrics.h"
+
+#ifndef TG_OUTBOX_DEPTH
+#define TG_OUTBOX_DEPTH 8           // Messages waiting to be sent
+#endif
+
+#ifndef TG_MESSAGE_SIZE
+#define TG_MESSAGE_SIZE 384         // Max text per message (after TG_BASE)
+#endif
+
+#ifndef TG_RATE_BURST
+#define TG_RATE_BURST 3             // Messages that may go out back to back
+#endif
+
+#ifndef TG_RATE_INTERVAL
+#define TG_RATE_INTERVAL 3000       // ms per message sustained (20 / minute per chat)
+#endif
+
+// Telegram delivery off the caller's task.
+// Callers enqueue() message text and return immediately; a background
+// task sends the queue over one long-lived TLS connection (HTTP
+// keep-alive), so the handshake is only paid when the connection is
+// first opened or the server drops it, not once per message.
+//
+// Sends are paced by a token bucket to stay inside the Bot API's
+// per-chat limits; urgent messages jump to the front of the queue.
+//
+// Text longer than TG_MESSAGE_SIZE - 1 is rejected, not cut: a cut can
+// land inside a %0A escape and break the URL. Callers with more to say
+// split at line boundaries (see LogDrain).
+class TelegramTransport
+{
+public:
+    struct Stats
+    {
+        uint32_t sent;
+        uint32_t failed;
+        uint32_t dropped;           // Outbox was full
+        uint32_t oversized;         // Longer than TG_MESSAGE_SIZE - 1, rejected
+        uint32_t handshakes;        // New TLS connections opened
+        uint32_t lastLatencyMs;     // Enqueue -> delivered, last message
+        uint32_t maxLatencyMs;
+        uint32_t lastRequestMs;     // Time spent in the HTTP request itself
+        uint32_t throttled;         // Sends delayed by the rate limit
+    };
+
+    TelegramTransport() : task_(nullptr), bucket_(TG_RATE_BURST, TG_RATE_INTERVAL), counters_()
+    {
+        outbox_ = xQueueCreate(TG_OUTBOX_DEPTH, sizeof(Message));
+    }
+
+    void begin()
+    {
+        if (task_ != nullptr)
+        {
+            return;
+        }
+        // Same behaviour as the old per-call HTTPClient: no certificate pinning
+        client_.setInsecure();
+        http_.setReuse(true);
+        xTaskCreatePinnedToCore(run, "telegram", 8192, this, 1, &task_, 0);
+    }
+
+    // Never blocks; returns false (and counts it) if the text doesn't fit
+    // in a message or the outbox is full
+    bool enqueue(const String& text, bool urgent = false)
+    {
+        if (text.length() >= TG_MESSAGE_SIZE)
+        {
+            counters_.oversized.fetch_add(1, std::memory_order_relaxed);
+            Metrics::getInstance().inc(MC_TELEGRAM_OVERSIZED);
+            return false;
+        }
+        Message message;
+        message.queuedAt = millis();
+        memcpy(message.text, text.c_str(), text.length() + 1);
+        BaseType_t queued = urgent ? xQueueSendToFront(outbox_, &message, 0)
+                                   : xQueueSendToBack(outbox_, &message, 0);
+        if (queued != pdTRUE)
+        {
+            counters_.dropped.fetch_add(1, std::memory_order_relaxed);
+            Metrics::getInstance().inc(MC_TELEGRAM_DROPPED);
+            return false;
+        }
+        return true;
+    }
+
+    // Written by the sender task and enqueue(); safe to call from anywhere
+    Stats stats() const
+    {
+        Stats s;
+        s.sent = counters_.sent.load(std::memory_order_relaxed);
+        s.failed = counters_.failed.load(std::memory_order_relaxed);
+        s.dropped = counters_.dropped.load(std::memory_order_relaxed);
+        s.oversized = counters_.oversized.load(std::memory_order_relaxed);
+        s.handshakes = counters_.handshakes.load(std::memory_order_relaxed);
+        s.lastLatencyMs = counters_.lastLatencyMs.load(std::memory_order_relaxed);
+        s.maxLatencyMs = counters_.maxLatencyMs.load(std::memory_order_relaxed);
+        s.lastRequestMs = counters_.lastRequestMs.load(std::memory_order_relaxed);
+        s.throttled = counters_.throttled.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    struct Message
+    {
+        uint32_t queuedAt;
+        char text[TG_MESSAGE_SIZE];
+    };
+
+    // Stats, one atomic per field
+    struct Counters
+    {
+        std::atomic<uint32_t> sent;
+        std::atomic<uint32_t> failed;
+        std::atomic<uint32_t> dropped;
+        std::atomic<uint32_t> oversized;
+        std::atomic<uint32_t> handshakes;
+        std::atomic<uint32_t> lastLatencyMs;
+        std::atomic<uint32_t> maxLatencyMs;
+        std::atomic<uint32_t> lastRequestMs;
+        std::atomic<uint32_t> throttled;
+    };
+
+    static void run(void* arg)
+    {
+        TelegramTransport* self = static_cast<TelegramTransport*>(arg);
+        Message message;
+        for (;;)
+        {
+            if (xQueueReceive(self->outbox_, &message, portMAX_DELAY) != pdTRUE)
+            {
+                continue;
+            }
+            // Hold the message until the link is back rather than drop it
+            while (WiFi.status() != WL_CONNECTED)
+            {
+                vTaskDelay(pdMS_TO_TICKS(500));
+            }
+            // Wait for a token rather than get 429'd by Telegram
+            uint32_t wait = self->bucket_.wait(millis());
+            if (wait > 0)
+            {
+                self->counters_.throttled.fetch_add(1, std::memory_order_relaxed);
+                while ((wait = self->bucket_.wait(millis())) > 0)
+                {
+                    vTaskDelay(pdMS_TO_TICKS(wait));
+                }
+            }
+            self->bucket_.take(millis());
+            self->deliver(message);
+        }
+    }
+
+    void deliver(const Message& message)
+    {
+        if (!client_.connected())
+        {
+            counters_.handshakes.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        uint32_t start = millis();
+        http_.begin(client_, String(TG_BASE) + message.text + "&parse_mode=markdown");
+        int httpResponseCode = http_.GET();
+        if (httpResponseCode > 0)
+        {
+            http_.getString(); // Drain the body so the connection can be reused
+            counters_.sent.fetch_add(1, std::memory_order_relaxed);
+            Metrics::getInstance().inc(MC_TELEGRAM_SENT);
+        }
+        else
+        {
+            counters_.failed.fetch_add(1, std::memory_order_relaxed);
+            Metrics::getInstance().inc(MC_TELEGRAM_FAILED);
+        }
+        http_.end(); // Keeps the socket open while reuse is enabled
+
+        uint32_t now = millis();
+        uint32_t requestMs = now - start;
+        uint32_t latencyMs = now - message.queuedAt;
+        counters_.lastRequestMs.store(requestMs, std::memory_order_relaxed);
+        counters_.lastLatencyMs.store(latencyMs, std::memory_order_relaxed);
+        Metrics::getInstance().observe(MH_TELEGRAM_REQUEST, requestMs * 1000);
+        Metrics::getInstance().observe(MH_TELEGRAM_LATENCY, latencyMs * 1000);
+        if (latencyMs > counters_.maxLatencyMs.load(std::memory_order_relaxed))
+        {
+            counters_.maxLatencyMs.store(latencyMs, std::memory_order_relaxed); // Only this task writes it
+        }
+    }
+
+    WiFiClientSecure client_;
+    HTTPClient http_;
+    QueueHandle_t outbox_;
+    TaskHandle_t task_;
+    TokenBucket bucket_;
+    Counters counters_;
+};
+
+#endif // TELEGRAM_H
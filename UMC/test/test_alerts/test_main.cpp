@@ -0,0 +1,269 @@
+// Host-side tests for the alert rule engine (src/alerts.h).
+// Run with: pio test -e native
+#include <unity.h>
+#include <math.h>
+#include <chrono>
+#include <vector>
+#include "alerts.h"
+
+const uint32_t PERIOD_MS = 2000; // SENSOR_INTERVAL
+
+static AlertEngine engine;
+static std::vector<AlertEvent> events;
+static uint32_t nowMs;
+
+// Feeds one sample per PERIOD_MS; returns the events it caused
+static uint8_t sample(float tempC, float humidity = 50.0f, float dbA = 40.0f)
+{
+    uint8_t n = engine.evaluate(nowMs, tempC, humidity, dbA, [](const AlertEvent& e) { events.push_back(e); });
+    nowMs += PERIOD_MS;
+    return n;
+}
+
+static void hold(float tempC, uint32_t ms)
+{
+    for (uint32_t t = 0; t < ms; t += PERIOD_MS)
+    {
+        sample(tempC);
+    }
+}
+
+void setUp(void)
+{
+    engine = AlertEngine(); // Also clears the rate history
+    events.clear();
+    nowMs = 1000;
+}
+
+void tearDown(void)
+{
+}
+
+void test_default_rules_compile(void)
+{
+    TEST_ASSERT_EQUAL_UINT8(0, engine.begin());
+    TEST_ASSERT_EQUAL_UINT8(5, engine.count());
+    TEST_ASSERT_EQUAL_STRING("temp > 35 for 60s", engine.describe(0));
+    TEST_ASSERT_EQUAL_STRING("humidity > 80 for 300s", engine.describe(2));
+    TEST_ASSERT_EQUAL_STRING("temp rate < -3", engine.describe(4));
+    TEST_ASSERT_EQUAL_STRING("", engine.describe(5));
+}
+
+void test_bad_rules_are_skipped_and_counted(void)
+{
+    TEST_ASSERT_EQUAL_UINT8(5, engine.begin("temp > 30; bogus > 1; humidity >< 2; temp > x; temp > 1 for -1;"
+                                            " ; sound > 70 cooldown 5; temp > 1 hyst"));
+    TEST_ASSERT_EQUAL_UINT8(2, engine.count());
+    TEST_ASSERT_EQUAL_STRING("temp > 30", engine.describe(0));
+    TEST_ASSERT_EQUAL_STRING("sound > 70", engine.describe(1));
+}
+
+// Without "for", the alert goes out on the sample that crosses
+void test_threshold_fires_on_the_crossing_sample(void)
+{
+    engine.begin("temp > 30");
+    TEST_ASSERT_EQUAL_UINT8(0, sample(29.9f));
+    TEST_ASSERT_EQUAL_UINT8(0, sample(30.0f));
+    TEST_ASSERT_EQUAL_UINT8(1, sample(30.1f));
+    TEST_ASSERT_TRUE(events[0].firing);
+    TEST_ASSERT_EQUAL_FLOAT(30.1f, events[0].value);
+    TEST_ASSERT_TRUE(engine.firing(0));
+
+    // Still over: nothing more to say
+    TEST_ASSERT_EQUAL_UINT8(0, sample(31.0f));
+    TEST_ASSERT_EQUAL_UINT8(0, sample(32.0f));
+    TEST_ASSERT_EQUAL_UINT8(1, sample(29.0f));
+    TEST_ASSERT_FALSE(events[1].firing);
+    TEST_ASSERT_FALSE(engine.firing(0));
+}
+
+void test_for_needs_the_condition_sustained(void)
+{
+    engine.begin("temp > 30 for 10");
+    hold(31.0f, 8000);
+    sample(29.0f); // Dip restarts the clock
+    hold(31.0f, 10000);
+    TEST_ASSERT_EQUAL(0, events.size());
+    TEST_ASSERT_EQUAL_UINT8(1, sample(31.0f)); // 10 s after the dip
+    TEST_ASSERT_TRUE(events[0].firing);
+}
+
+// A value wandering around the threshold fires once, not on every crossing
+void test_hysteresis_stops_flapping(void)
+{
+    engine.begin("temp > 30 hyst 1");
+    const float noisy[] = {29.8f, 30.2f, 29.9f, 30.3f, 29.5f, 30.1f, 29.4f, 30.4f, 29.2f};
+    for (float v : noisy)
+    {
+        sample(v);
+    }
+    TEST_ASSERT_EQUAL(1, events.size());
+    TEST_ASSERT_TRUE(engine.firing(0));
+
+    TEST_ASSERT_EQUAL_UINT8(1, sample(28.9f)); // Below 30 - 1
+    TEST_ASSERT_FALSE(events[1].firing);
+}
+
+void test_cooldown_holds_off_a_repeat(void)
+{
+    engine.begin("temp > 30 cooldown 20");
+    sample(31.0f);
+    sample(29.0f);
+    TEST_ASSERT_EQUAL(2, events.size());
+
+    hold(31.0f, 18000);
+    TEST_ASSERT_EQUAL(2, events.size());
+    hold(31.0f, 4000);
+    TEST_ASSERT_EQUAL(3, events.size());
+    TEST_ASSERT_TRUE(events[2].firing);
+}
+
+void test_below_rules_mirror_above(void)
+{
+    engine.begin("temp < 5 hyst 1");
+    sample(6.0f);
+    TEST_ASSERT_EQUAL_UINT8(1, sample(4.9f));
+    TEST_ASSERT_EQUAL_UINT8(0, sample(5.5f)); // Inside the hysteresis band
+    TEST_ASSERT_EQUAL_UINT8(1, sample(6.1f));
+    TEST_ASSERT_FALSE(events[1].firing);
+}
+
+void test_rate_rule_fires_on_a_fast_rise(void)
+{
+    engine.begin("temp rate > 3");
+    // Steady, then rising 0.2 C per 2 s sample: 6 C/min
+    float v = 20.0f;
+    for (uint32_t i = 0; i < 30; i++)
+    {
+        sample(v);
+    }
+    TEST_ASSERT_EQUAL(0, events.size());
+    uint32_t risingFrom = nowMs;
+    while (events.empty() && nowMs - risingFrom < 60000)
+    {
+        v += 0.2f;
+        sample(v);
+    }
+    TEST_ASSERT_EQUAL(1, events.size());
+    TEST_ASSERT_TRUE(events[0].firing);
+    TEST_ASSERT_GREATER_THAN(3.0f, events[0].value);
+    // Averaged over the window, so it takes a while past the threshold
+    TEST_ASSERT_LESS_THAN(40000, nowMs - risingFrom);
+}
+
+void test_rate_waits_for_half_a_window(void)
+{
+    engine.begin("temp rate > 3");
+    float v = 20.0f;
+    for (uint32_t t = 0; t < ALERT_RATE_WINDOW / 2; t += PERIOD_MS)
+    {
+        sample(v);
+        v += 1.0f; // 30 C/min, but too little history to say so
+    }
+    TEST_ASSERT_EQUAL(0, events.size());
+    sample(v);
+    TEST_ASSERT_EQUAL(1, events.size());
+}
+
+void test_missing_readings_change_nothing(void)
+{
+    engine.begin("temp > 30; humidity > 80");
+    sample(31.0f, 85.0f);
+    TEST_ASSERT_EQUAL(2, events.size());
+    sample(NAN, NAN); // DHT read failed
+    TEST_ASSERT_EQUAL(2, events.size());
+    TEST_ASSERT_TRUE(engine.firing(0));
+    TEST_ASSERT_TRUE(engine.firing(1));
+}
+
+void test_sound_rule_uses_dba(void)
+{
+    engine.begin("sound > 70 for 4");
+    sample(20.0f, 50.0f, 75.0f);
+    sample(20.0f, 50.0f, 75.0f);
+    TEST_ASSERT_EQUAL(0, events.size());
+    TEST_ASSERT_EQUAL_UINT8(1, sample(20.0f, 50.0f, 75.0f));
+    TEST_ASSERT_EQUAL_UINT8(0, events[0].rule);
+}
+
+// A day of ordinary readings with one hot spell: a handful of messages
+// instead of one per sample
+void test_a_day_sends_only_transitions(void)
+{
+    engine.begin();
+    uint32_t samples = 0;
+    for (uint32_t t = 0; t < 86400000; t += PERIOD_MS, samples++)
+    {
+        float hour = t / 3600000.0f;
+        float tempC = 22.0f + 4.0f * sinf(hour / 24.0f * 2.0f * (float)M_PI);
+        if (hour >= 14.0f && hour < 15.0f)
+        {
+            tempC = 36.0f + 0.3f * sinf(t / 10000.0f); // Hot spell, with some jitter
+        }
+        sample(tempC);
+    }
+    TEST_ASSERT_EQUAL_UINT32(43200, samples);
+    // The step up and back down also trips a rate rule each, which
+    // fires and resolves
+    uint32_t threshold = 0;
+    for (const AlertEvent& e : events)
+    {
+        threshold += e.rule == 0;
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, threshold);
+    TEST_ASSERT_EQUAL_UINT32(6, events.size());
+
+    char line[96];
+    snprintf(line, sizeof(line), "%u samples, %u events (%u from the temp > 35 rule)", (unsigned)samples,
+             (unsigned)events.size(), (unsigned)threshold);
+    TEST_MESSAGE(line);
+}
+
+// -----------------------------------------------------------------
+// Benchmark: evaluation cost per sample
+// -----------------------------------------------------------------
+static void bench(const char* name, const char* rules)
+{
+    engine.begin(rules);
+    const uint32_t samples = 1000000;
+    uint32_t fired = 0;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        fired += engine.evaluate(i * PERIOD_MS, 20.0f + (i % 100) * 0.01f, 50.0f, 40.0f, [](const AlertEvent&) {});
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / samples;
+    char line[96];
+    snprintf(line, sizeof(line), "%-16s %u rules: %.1f ns/sample (%u events)", name, engine.count(), ns,
+             (unsigned)fired);
+    TEST_MESSAGE(line);
+}
+
+void test_benchmark_evaluate(void)
+{
+    bench("default rules", ALERT_RULES);
+    bench("full table", "temp > 35 for 60 hyst 1; temp < 5 for 60 hyst 1; humidity > 80 for 300 hyst 3;"
+                        "humidity < 20 for 300 hyst 3; temp rate > 3; temp rate < -3; humidity rate > 10;"
+                        "humidity rate < -10; sound > 70 for 10; sound > 85; sound rate > 20; temp > 30;"
+                        "temp < 10; humidity > 70; humidity < 30; sound > 60 for 60");
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_default_rules_compile);
+    RUN_TEST(test_bad_rules_are_skipped_and_counted);
+    RUN_TEST(test_threshold_fires_on_the_crossing_sample);
+    RUN_TEST(test_for_needs_the_condition_sustained);
+    RUN_TEST(test_hysteresis_stops_flapping);
+    RUN_TEST(test_cooldown_holds_off_a_repeat);
+    RUN_TEST(test_below_rules_mirror_above);
+    RUN_TEST(test_rate_rule_fires_on_a_fast_rise);
+    RUN_TEST(test_rate_waits_for_half_a_window);
+    RUN_TEST(test_missing_readings_change_nothing);
+    RUN_TEST(test_sound_rule_uses_dba);
+    RUN_TEST(test_a_day_sends_only_transitions);
+    RUN_TEST(test_benchmark_evaluate);
+    return UNITY_END();
+}
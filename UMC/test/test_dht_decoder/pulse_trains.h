@@ -0,0 +1,61 @@
+#ifndef TEST_PULSE_TRAINS_H
+#define TEST_PULSE_TRAINS_H
+
+#include "dht_decoder.h"
+
+// Pulse-width arrays in the form dht_rmt.h hands to the decoder: one
+// {level, us} run per entry, starting after our own start pulse. The
+// widths are spread across what the datasheets allow and what DHT11
+// clones are seen to do. Rows are one data byte each (8 low/high bit
+// pairs, split over two lines).
+
+// DHT22 at 23.5 C, 65.2 %RH
+const DhtPulse DHT22_23_5C_65_2RH[] = {
+    {1, 33}, {0, 86}, {1, 86},
+    {0, 48}, {1, 24}, {0, 53}, {1, 25}, {0, 51}, {1, 22}, {0, 50}, {1, 23},
+    {0, 56}, {1, 22}, {0, 48}, {1, 24}, {0, 55}, {1, 70}, {0, 53}, {1, 28}, // 0x02
+    {0, 52}, {1, 71}, {0, 48}, {1, 27}, {0, 51}, {1, 24}, {0, 48}, {1, 30},
+    {0, 48}, {1, 75}, {0, 48}, {1, 70}, {0, 52}, {1, 23}, {0, 51}, {1, 22}, // 0x8C
+    {0, 52}, {1, 28}, {0, 48}, {1, 29}, {0, 54}, {1, 25}, {0, 50}, {1, 24},
+    {0, 51}, {1, 25}, {0, 47}, {1, 22}, {0, 53}, {1, 22}, {0, 52}, {1, 27}, // 0x00
+    {0, 54}, {1, 73}, {0, 56}, {1, 74}, {0, 49}, {1, 69}, {0, 54}, {1, 29},
+    {0, 52}, {1, 75}, {0, 47}, {1, 26}, {0, 49}, {1, 66}, {0, 50}, {1, 66}, // 0xEB
+    {0, 56}, {1, 30}, {0, 55}, {1, 70}, {0, 52}, {1, 75}, {0, 50}, {1, 72},
+    {0, 48}, {1, 71}, {0, 52}, {1, 23}, {0, 50}, {1, 22}, {0, 53}, {1, 66}, // 0x79
+    {0, 55},
+};
+
+// DHT22 at -10.1 C, 40.0 %RH (sign bit set), starting
+// right at the response with no line-release run before it
+const DhtPulse DHT22_MINUS_10_1C_40_0RH[] = {
+    {0, 87}, {1, 85},
+    {0, 48}, {1, 24}, {0, 49}, {1, 22}, {0, 56}, {1, 26}, {0, 48}, {1, 26},
+    {0, 48}, {1, 22}, {0, 53}, {1, 26}, {0, 49}, {1, 30}, {0, 50}, {1, 66}, // 0x01
+    {0, 51}, {1, 73}, {0, 51}, {1, 23}, {0, 55}, {1, 27}, {0, 55}, {1, 73},
+    {0, 48}, {1, 26}, {0, 54}, {1, 26}, {0, 53}, {1, 28}, {0, 51}, {1, 30}, // 0x90
+    {0, 54}, {1, 67}, {0, 52}, {1, 26}, {0, 49}, {1, 24}, {0, 49}, {1, 23},
+    {0, 54}, {1, 28}, {0, 52}, {1, 29}, {0, 48}, {1, 26}, {0, 56}, {1, 24}, // 0x80
+    {0, 51}, {1, 30}, {0, 55}, {1, 71}, {0, 50}, {1, 66}, {0, 50}, {1, 30},
+    {0, 54}, {1, 23}, {0, 55}, {1, 70}, {0, 53}, {1, 24}, {0, 54}, {1, 70}, // 0x65
+    {0, 49}, {1, 25}, {0, 56}, {1, 71}, {0, 55}, {1, 67}, {0, 52}, {1, 71},
+    {0, 54}, {1, 24}, {0, 47}, {1, 67}, {0, 53}, {1, 72}, {0, 53}, {1, 30}, // 0x76
+    {0, 53},
+};
+
+// DHT11 clone at 23.4 C, 55 %RH: short response, long 1s
+const DhtPulse DHT11_23_4C_55RH[] = {
+    {1, 27}, {0, 67}, {1, 66},
+    {0, 54}, {1, 25}, {0, 52}, {1, 22}, {0, 56}, {1, 74}, {0, 60}, {1, 85},
+    {0, 55}, {1, 24}, {0, 54}, {1, 76}, {0, 55}, {1, 82}, {0, 52}, {1, 75}, // 0x37
+    {0, 53}, {1, 20}, {0, 58}, {1, 24}, {0, 60}, {1, 20}, {0, 62}, {1, 22},
+    {0, 58}, {1, 21}, {0, 56}, {1, 26}, {0, 62}, {1, 21}, {0, 62}, {1, 24}, // 0x00
+    {0, 53}, {1, 22}, {0, 60}, {1, 24}, {0, 57}, {1, 25}, {0, 61}, {1, 87},
+    {0, 56}, {1, 20}, {0, 52}, {1, 86}, {0, 55}, {1, 75}, {0, 55}, {1, 74}, // 0x17
+    {0, 54}, {1, 20}, {0, 54}, {1, 24}, {0, 53}, {1, 26}, {0, 54}, {1, 23},
+    {0, 56}, {1, 23}, {0, 57}, {1, 77}, {0, 61}, {1, 22}, {0, 54}, {1, 22}, // 0x04
+    {0, 56}, {1, 26}, {0, 58}, {1, 86}, {0, 54}, {1, 25}, {0, 54}, {1, 81},
+    {0, 54}, {1, 22}, {0, 59}, {1, 23}, {0, 59}, {1, 78}, {0, 56}, {1, 25}, // 0x52
+    {0, 54},
+};
+
+#endif // TEST_PULSE_TRAINS_H
@@ -0,0 +1,216 @@
+// Host-side tests for the DHT pulse train decoder
+// (lib/Telemetry/src/dht_decoder.h), from pulse-width arrays.
+// Run with: pio test -e native
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "dht_decoder.h"
+#include "pulse_trains.h"
+
+typedef std::vector<DhtPulse> Train;
+
+template <size_t N>
+static Train train(const DhtPulse (&pulses)[N])
+{
+    return Train(pulses, pulses + N);
+}
+
+// Builds a train for bytes with every width drawn at random from
+// [min, max] of its kind, as the sensor's timing wanders
+struct Timing
+{
+    uint16_t responseMin, responseMax;
+    uint16_t lowMin, lowMax;
+    uint16_t zeroMin, zeroMax;
+    uint16_t oneMin, oneMax;
+};
+
+static uint16_t between(uint16_t min, uint16_t max)
+{
+    return min + rand() % (max - min + 1);
+}
+
+static Train build(const uint8_t bytes[5], const Timing& t)
+{
+    Train pulses = {{1, between(20, 40)}, {0, between(t.responseMin, t.responseMax)},
+                    {1, between(t.responseMin, t.responseMax)}};
+    for (uint8_t bit = 0; bit < DHT_FRAME_BITS; bit++)
+    {
+        bool one = (bytes[bit / 8] >> (7 - bit % 8)) & 1;
+        pulses.push_back({0, between(t.lowMin, t.lowMax)});
+        pulses.push_back({1, one ? between(t.oneMin, t.oneMax) : between(t.zeroMin, t.zeroMax)});
+    }
+    pulses.push_back({0, 50});
+    return pulses;
+}
+
+// Index of the high half of a data bit in a train with a line-release run
+static size_t highOf(uint8_t bit)
+{
+    return 3 + 2 * bit + 1;
+}
+
+void setUp(void)
+{
+    srand(44);
+}
+
+void tearDown(void)
+{
+}
+
+void test_decodes_dht22(void)
+{
+    float tempC = 0, humidity = 0;
+    TEST_ASSERT_EQUAL(DHT_OK, DhtDecoder::decode(DHT22_23_5C_65_2RH, sizeof(DHT22_23_5C_65_2RH) / sizeof(DhtPulse),
+                                                 DHT22, tempC, humidity));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.5f, tempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 65.2f, humidity);
+}
+
+void test_decodes_dht22_below_zero(void)
+{
+    float tempC = 0, humidity = 0;
+    Train pulses = train(DHT22_MINUS_10_1C_40_0RH);
+    TEST_ASSERT_EQUAL(DHT_OK, DhtDecoder::decode(pulses.data(), pulses.size(), DHT22, tempC, humidity));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -10.1f, tempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, humidity);
+}
+
+void test_decodes_dht11_clone_timing(void)
+{
+    float tempC = 0, humidity = 0;
+    Train pulses = train(DHT11_23_4C_55RH);
+    TEST_ASSERT_EQUAL(DHT_OK, DhtDecoder::decode(pulses.data(), pulses.size(), DHT11, tempC, humidity));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.4f, tempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 55.0f, humidity);
+}
+
+void test_converts_like_the_adafruit_library(void)
+{
+    float tempC, humidity;
+    const uint8_t dht11Negative[5] = {40, 0, 2, 0x83, 0};
+    DhtDecoder::convert(DHT11, dht11Negative, tempC, humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, -2.7f, tempC); // -1 - 2, plus 0.3
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 40.0f, humidity);
+
+    const uint8_t dht12[5] = {45, 3, 5, 2, 0};
+    DhtDecoder::convert(DHT12, dht12, tempC, humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 5.2f, tempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 45.3f, humidity);
+
+    const uint8_t dht21[5] = {0x03, 0xE8, 0x01, 0x2C, 0};
+    DhtDecoder::convert(DHT21, dht21, tempC, humidity);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 30.0f, tempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100.0f, humidity);
+}
+
+void test_reports_each_kind_of_bad_capture(void)
+{
+    uint8_t bytes[5];
+    Train pulses = train(DHT22_23_5C_65_2RH);
+    TEST_ASSERT_EQUAL(DHT_TIMEOUT, DhtDecoder::decodeBytes(pulses.data(), 0, bytes));
+
+    // Sensor never answered: only our start pulse and the line floating high
+    Train silent = {{0, 4}, {1, 1200}};
+    TEST_ASSERT_EQUAL(DHT_NO_RESPONSE, DhtDecoder::decodeBytes(silent.data(), silent.size(), bytes));
+
+    // Capture cut short 30 bits in
+    TEST_ASSERT_EQUAL(DHT_TRUNCATED, DhtDecoder::decodeBytes(pulses.data(), highOf(30), bytes));
+
+    // A glitch splits a high pulse
+    Train glitch = pulses;
+    glitch[highOf(12)].us = 6;
+    TEST_ASSERT_EQUAL(DHT_BAD_TIMING, DhtDecoder::decodeBytes(glitch.data(), glitch.size(), bytes));
+
+    // A bit misread: the timing is fine but the checksum isn't
+    Train flipped = pulses;
+    flipped[highOf(20)].us = flipped[highOf(20)].us > DHT_BIT_ONE_US ? 26 : 70;
+    TEST_ASSERT_EQUAL(DHT_BAD_CHECKSUM, DhtDecoder::decodeBytes(flipped.data(), flipped.size(), bytes));
+}
+
+void test_failed_decode_leaves_the_reading_alone(void)
+{
+    float tempC = 21.0f, humidity = 50.0f;
+    Train pulses = train(DHT22_23_5C_65_2RH);
+    pulses[highOf(0)].us = 3;
+    TEST_ASSERT_EQUAL(DHT_BAD_TIMING, DhtDecoder::decode(pulses.data(), pulses.size(), DHT22, tempC, humidity));
+    TEST_ASSERT_EQUAL_FLOAT(21.0f, tempC);
+    TEST_ASSERT_EQUAL_FLOAT(50.0f, humidity);
+}
+
+void test_ignores_pulses_after_the_frame(void)
+{
+    float tempC = 0, humidity = 0;
+    Train pulses = train(DHT22_23_5C_65_2RH);
+    pulses.push_back({1, 900});
+    pulses.push_back({0, 3});
+    TEST_ASSERT_EQUAL(DHT_OK, DhtDecoder::decode(pulses.data(), pulses.size(), DHT22, tempC, humidity));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.5f, tempC);
+}
+
+// Random frames with every width anywhere in its window still decode
+void test_decodes_across_the_timing_windows(void)
+{
+    const Timing datasheet = {75, 85, 48, 55, 22, 30, 68, 75};
+    const Timing clone = {DHT_RESPONSE_MIN_US, DHT_RESPONSE_MAX_US, DHT_BIT_LOW_MIN_US, DHT_BIT_LOW_MAX_US,
+                          DHT_BIT_HIGH_MIN_US, DHT_BIT_ONE_US, DHT_BIT_ONE_US + 1, DHT_BIT_HIGH_MAX_US};
+    const Timing* timings[] = {&datasheet, &clone};
+    for (const Timing* timing : timings)
+    {
+        for (uint32_t n = 0; n < 5000; n++)
+        {
+            uint8_t bytes[5], decoded[5];
+            for (uint8_t b = 0; b < 4; b++)
+            {
+                bytes[b] = rand();
+            }
+            bytes[4] = bytes[0] + bytes[1] + bytes[2] + bytes[3];
+            Train pulses = build(bytes, *timing);
+            TEST_ASSERT_EQUAL(DHT_OK, DhtDecoder::decodeBytes(pulses.data(), pulses.size(), decoded));
+            TEST_ASSERT_EQUAL_MEMORY(bytes, decoded, 5);
+        }
+    }
+}
+
+// -----------------------------------------------------------------
+// Benchmark: decode cost per reading
+// -----------------------------------------------------------------
+// The decode runs once per sensor read, off the capture interrupt, so
+// this is the CPU a reading costs once the RMT has done the timing.
+void test_benchmark_decode(void)
+{
+    const uint32_t decodes = 1000000;
+    Train pulses = train(DHT22_23_5C_65_2RH);
+    float tempC, humidity;
+    uint32_t ok = 0;
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < decodes; i++)
+    {
+        ok += DhtDecoder::decode(pulses.data(), pulses.size(), DHT22, tempC, humidity) == DHT_OK;
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / decodes;
+    TEST_ASSERT_EQUAL_UINT32(decodes, ok);
+
+    char line[96];
+    snprintf(line, sizeof(line), "decode: %.1f ns per %u-pulse train", ns, (unsigned)pulses.size());
+    TEST_MESSAGE(line);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_dht22);
+    RUN_TEST(test_decodes_dht22_below_zero);
+    RUN_TEST(test_decodes_dht11_clone_timing);
+    RUN_TEST(test_converts_like_the_adafruit_library);
+    RUN_TEST(test_reports_each_kind_of_bad_capture);
+    RUN_TEST(test_failed_decode_leaves_the_reading_alone);
+    RUN_TEST(test_ignores_pulses_after_the_frame);
+    RUN_TEST(test_decodes_across_the_timing_windows);
+    RUN_TEST(test_benchmark_decode);
+    return UNITY_END();
+}
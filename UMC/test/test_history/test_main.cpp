@@ -0,0 +1,403 @@
+// Host-side tests for the round-robin history store (src/history.h),
+// against an in-memory stand-in for the LittleFS segment files.
+// Run with: pio test -e native
+#include <unity.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <utility>
+#include <vector>
+#include "history.h"
+
+// Segment files in RAM, counting what flash would see
+class MemoryStorage
+{
+public:
+    typedef std::pair<uint8_t, uint16_t> Key;
+
+    size_t read(uint8_t archive, uint16_t segment, uint32_t offset, void* data, size_t length)
+    {
+        reads++;
+        std::map<Key, std::vector<uint8_t>>::iterator file = files.find(Key(archive, segment));
+        if (file == files.end() || offset >= file->second.size())
+        {
+            return 0;
+        }
+        size_t n = length < file->second.size() - offset ? length : file->second.size() - offset;
+        memcpy(data, file->second.data() + offset, n);
+        return n;
+    }
+
+    bool write(uint8_t archive, uint16_t segment, uint32_t offset, const void* data, size_t length)
+    {
+        std::vector<uint8_t>& file = files[Key(archive, segment)];
+        if (file.size() < offset + length)
+        {
+            file.resize(offset + length); // Zero-filled, as required
+        }
+        memcpy(file.data() + offset, data, length);
+        writes++;
+        bytesWritten += length;
+        return true;
+    }
+
+    void remove(uint8_t archive, uint16_t segment)
+    {
+        files.erase(Key(archive, segment));
+    }
+
+    bool readMeta(void* data, size_t length)
+    {
+        if (meta.size() != length)
+        {
+            return false;
+        }
+        memcpy(data, meta.data(), length);
+        return true;
+    }
+
+    bool writeMeta(const void* data, size_t length)
+    {
+        meta.assign((const uint8_t*)data, (const uint8_t*)data + length);
+        return true;
+    }
+
+    size_t bytesStored(uint8_t archive = HISTORY_ARCHIVE_COUNT) const
+    {
+        size_t total = 0;
+        for (const auto& file : files)
+        {
+            if (archive == HISTORY_ARCHIVE_COUNT || file.first.first == archive)
+            {
+                total += file.second.size();
+            }
+        }
+        return total;
+    }
+
+    size_t largestFile() const
+    {
+        size_t largest = 0;
+        for (const auto& file : files)
+        {
+            largest = file.second.size() > largest ? file.second.size() : largest;
+        }
+        return largest;
+    }
+
+    std::map<Key, std::vector<uint8_t>> files;
+    std::vector<uint8_t> meta;
+    uint32_t reads = 0;
+    uint32_t writes = 0;
+    uint32_t bytesWritten = 0;
+};
+
+typedef History<MemoryStorage> TestHistory;
+
+const uint32_t DAY_START = 1700006400; // 2023-11-15 00:00:00 UTC
+const uint32_t HOUR = 3600;
+const uint32_t DAY = 86400;
+
+// A temperature that ramps 20 -> 30 C over each day, and a steady 50 %RH
+static float rampC(uint32_t t)
+{
+    return 20.0f + 10.0f * (float)((t - DAY_START) % DAY) / DAY;
+}
+
+// Adds a sample every HISTORY_RAW_STEP in [from, to); returns to
+static uint32_t addRamp(TestHistory& history, uint32_t from, uint32_t to)
+{
+    for (uint32_t t = from; t < to; t += HISTORY_RAW_STEP)
+    {
+        history.add(t, rampC(t), 50.0f);
+    }
+    return to;
+}
+
+static std::vector<HistorySlot> query(TestHistory& history, uint8_t archive, uint32_t from, uint32_t to)
+{
+    std::vector<HistorySlot> slots;
+    history.query(archive, from, to, [&slots](const HistorySlot& slot) { slots.push_back(slot); });
+    return slots;
+}
+
+static void assertAscending(const std::vector<HistorySlot>& slots, uint32_t step)
+{
+    for (size_t i = 1; i < slots.size(); i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(slots[i - 1].time + step, slots[i].time);
+    }
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_samples_wait_for_begin_and_the_clock(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    TEST_ASSERT_FALSE(history.add(DAY_START, 21.0f, 50.0f));
+    TEST_ASSERT_TRUE(history.begin());
+    TEST_ASSERT_FALSE(history.add(1000, 21.0f, 50.0f)); // No NTP yet
+    TEST_ASSERT_TRUE(history.add(DAY_START, 21.0f, 50.0f));
+    TEST_ASSERT_EQUAL_UINT32(1, history.stats().samples);
+}
+
+void test_raw_query_returns_the_readings_in_order(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    uint32_t now = addRamp(history, DAY_START, DAY_START + 2 * HOUR) - HISTORY_RAW_STEP;
+
+    std::vector<HistorySlot> raw = query(history, HISTORY_RAW, now - 600, now);
+    TEST_ASSERT_EQUAL_UINT32(600 / HISTORY_RAW_STEP + 1, raw.size());
+    assertAscending(raw, HISTORY_RAW_STEP);
+    TEST_ASSERT_EQUAL_UINT32(now, raw.back().time);
+    TEST_ASSERT_EQUAL_UINT16(1, raw.back().count);
+    TEST_ASSERT_EQUAL_INT16(lroundf(rampC(now) * 100), raw.back().avgC);
+    TEST_ASSERT_EQUAL_INT16(raw.back().avgC, raw.back().minC);
+    TEST_ASSERT_EQUAL_INT16(5000, raw.back().avgRH);
+}
+
+void test_rollups_hold_min_avg_max(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    // One minute of 20.00, 20.01 ... 20.29 C
+    for (uint32_t i = 0; i < 60 / HISTORY_RAW_STEP; i++)
+    {
+        history.add(DAY_START + i * HISTORY_RAW_STEP, 20.0f + i * 0.01f, 40.0f + i);
+    }
+    history.add(DAY_START + 60, 25.0f, 50.0f); // Closes the minute
+
+    std::vector<HistorySlot> minutes = query(history, HISTORY_MINUTE, DAY_START, DAY_START + 60);
+    TEST_ASSERT_EQUAL_UINT32(2, minutes.size());
+    TEST_ASSERT_EQUAL_UINT32(DAY_START, minutes[0].time);
+    TEST_ASSERT_EQUAL_UINT16(30, minutes[0].count);
+    TEST_ASSERT_EQUAL_INT16(2000, minutes[0].minC);
+    TEST_ASSERT_INT16_WITHIN(1, 2015, minutes[0].avgC);
+    TEST_ASSERT_EQUAL_INT16(2029, minutes[0].maxC);
+    TEST_ASSERT_EQUAL_INT16(4000, minutes[0].minRH);
+    TEST_ASSERT_EQUAL_INT16(6900, minutes[0].maxRH);
+    TEST_ASSERT_EQUAL_UINT16(1, minutes[1].count); // In progress
+
+    std::vector<HistorySlot> hours = query(history, HISTORY_HOUR, DAY_START, DAY_START + HOUR);
+    TEST_ASSERT_EQUAL_UINT32(1, hours.size());
+    TEST_ASSERT_EQUAL_UINT16(31, hours[0].count);
+    TEST_ASSERT_EQUAL_INT16(2500, hours[0].maxC);
+}
+
+void test_day_rollup_covers_every_sample(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    uint32_t now = addRamp(history, DAY_START, DAY_START + 2 * DAY);
+
+    std::vector<HistorySlot> days = query(history, HISTORY_DAY, DAY_START, now);
+    TEST_ASSERT_EQUAL_UINT32(2, days.size());
+    TEST_ASSERT_EQUAL_UINT16(DAY / HISTORY_RAW_STEP, days[0].count);
+    TEST_ASSERT_EQUAL_INT16(2000, days[0].minC);
+    TEST_ASSERT_INT16_WITHIN(1, 2500, days[0].avgC);
+    TEST_ASSERT_INT16_WITHIN(1, 3000, days[0].maxC);
+    TEST_ASSERT_EQUAL_UINT32(24, query(history, HISTORY_HOUR, DAY_START, DAY_START + DAY - 1).size());
+}
+
+// A slot left from an earlier lap of the ring is never returned
+void test_old_data_ages_out(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    uint32_t now = addRamp(history, DAY_START, DAY_START + 3 * HOUR) - HISTORY_RAW_STEP;
+    history.flush();
+
+    std::vector<HistorySlot> raw = query(history, HISTORY_RAW, DAY_START, now);
+    TEST_ASSERT_EQUAL_UINT32(HISTORY_RAW_ROWS, raw.size());
+    TEST_ASSERT_EQUAL_UINT32(now - (HISTORY_RAW_ROWS - 1) * HISTORY_RAW_STEP, raw.front().time);
+
+    // A gap: an hour with no samples leaves the raw ring holding only
+    // readings from before it, all of them now out of range
+    uint32_t later = now + HISTORY_RAW_ROWS * HISTORY_RAW_STEP + HOUR;
+    history.add(later, 22.0f, 50.0f);
+    raw = query(history, HISTORY_RAW, later - HOUR, later);
+    TEST_ASSERT_EQUAL_UINT32(1, raw.size());
+    TEST_ASSERT_EQUAL_UINT32(later, raw[0].time);
+}
+
+// Once an archive has gone round its ring it takes no more space
+void test_space_used_never_grows(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    uint32_t now = addRamp(history, DAY_START, DAY_START + 2 * DAY);
+    history.flush();
+    size_t fullRings = storage.bytesStored(HISTORY_RAW) + storage.bytesStored(HISTORY_MINUTE);
+    TEST_ASSERT_EQUAL_UINT32((HISTORY_RAW_ROWS + HISTORY_MINUTE_ROWS) * sizeof(HistorySlot), fullRings);
+
+    addRamp(history, now, now + 5 * DAY);
+    history.flush();
+    TEST_ASSERT_EQUAL_UINT32(fullRings, storage.bytesStored(HISTORY_RAW) + storage.bytesStored(HISTORY_MINUTE));
+    TEST_ASSERT_LESS_OR_EQUAL(HISTORY_SEGMENT_BYTES, storage.largestFile());
+    size_t capacity = (HISTORY_RAW_ROWS + HISTORY_MINUTE_ROWS + HISTORY_HOUR_ROWS + HISTORY_DAY_ROWS) * sizeof(HistorySlot);
+    TEST_ASSERT_LESS_OR_EQUAL(capacity, storage.bytesStored());
+}
+
+void test_queries_see_unflushed_slots(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    history.add(DAY_START, 21.0f, 50.0f); // Flushes once, on the first sample
+    uint32_t writes = storage.writes;
+    history.add(DAY_START + 2, 21.5f, 51.0f);
+    history.add(DAY_START + 4, 22.0f, 52.0f);
+    TEST_ASSERT_EQUAL_UINT32(writes, storage.writes);
+
+    std::vector<HistorySlot> raw = query(history, HISTORY_RAW, DAY_START, DAY_START + 4);
+    TEST_ASSERT_EQUAL_UINT32(3, raw.size());
+    TEST_ASSERT_EQUAL_INT16(2200, raw[2].avgC);
+}
+
+// Writes are batched per HISTORY_FLUSH_INTERVAL, one per contiguous run
+void test_flash_writes_are_batched(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    addRamp(history, DAY_START, DAY_START + DAY);
+
+    uint32_t flushes = history.stats().flushes;
+    TEST_ASSERT_UINT32_WITHIN(2, DAY / HISTORY_FLUSH_INTERVAL, flushes);
+    // Raw and minute runs, split at most once by a segment boundary,
+    // plus the hour / day slots that closed
+    TEST_ASSERT_LESS_OR_EQUAL(flushes * 4 + 24 + 1, storage.writes);
+    TEST_ASSERT_EQUAL_UINT32(0, history.stats().writeErrors);
+}
+
+// Query cost follows the points returned, not the archive size
+void test_query_reads_only_the_range(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    uint32_t now = addRamp(history, DAY_START, DAY_START + DAY) - HISTORY_RAW_STEP;
+    history.flush();
+
+    uint32_t reads = storage.reads;
+    TEST_ASSERT_EQUAL_UINT32(10, query(history, HISTORY_MINUTE, now - now % 60 - 9 * 60, now).size());
+    TEST_ASSERT_LESS_OR_EQUAL(2, storage.reads - reads);
+
+    reads = storage.reads;
+    TEST_ASSERT_EQUAL_UINT32(HISTORY_MINUTE_ROWS, query(history, HISTORY_MINUTE, now - DAY, now).size());
+    uint32_t segments = (HISTORY_MINUTE_ROWS + TestHistory::SLOTS_PER_SEGMENT - 1) / TestHistory::SLOTS_PER_SEGMENT;
+    TEST_ASSERT_LESS_OR_EQUAL(HISTORY_MINUTE_ROWS / HISTORY_QUERY_CHUNK + 2 * segments, storage.reads - reads);
+}
+
+// After a reboot the open hour and day carry on from flash
+void test_reboot_resumes_the_rollups(void)
+{
+    MemoryStorage storage;
+    uint32_t now;
+    {
+        TestHistory history(storage);
+        history.begin();
+        now = addRamp(history, DAY_START, DAY_START + 10 * HOUR + 1800);
+        history.flush();
+    }
+    TestHistory history(storage);
+    TEST_ASSERT_TRUE(history.begin());
+    now = addRamp(history, now, now + 600);
+
+    std::vector<HistorySlot> days = query(history, HISTORY_DAY, DAY_START, now);
+    TEST_ASSERT_EQUAL_UINT32(1, days.size());
+    TEST_ASSERT_EQUAL_UINT16((10 * HOUR + 2400) / HISTORY_RAW_STEP, days[0].count);
+    TEST_ASSERT_EQUAL_INT16(2000, days[0].minC);
+
+    std::vector<HistorySlot> hours = query(history, HISTORY_HOUR, now - now % HOUR, now);
+    TEST_ASSERT_EQUAL_UINT32(1, hours.size());
+    TEST_ASSERT_EQUAL_UINT16(2400 / HISTORY_RAW_STEP, hours[0].count);
+}
+
+void test_layout_change_starts_afresh(void)
+{
+    MemoryStorage storage;
+    {
+        TestHistory history(storage);
+        history.begin();
+        addRamp(history, DAY_START, DAY_START + HOUR);
+        history.flush();
+    }
+    TEST_ASSERT_GREATER_THAN(0, storage.files.size());
+    storage.meta[8] ^= 1; // As if HISTORY_RAW_STEP had changed
+
+    TestHistory history(storage);
+    TEST_ASSERT_TRUE(history.begin());
+    TEST_ASSERT_EQUAL_UINT32(0, storage.files.size());
+    TEST_ASSERT_EQUAL_UINT32(0, query(history, HISTORY_RAW, DAY_START, DAY_START + HOUR).size());
+}
+
+// -----------------------------------------------------------------
+// Benchmark: sample cost, query cost, flash written per day
+// -----------------------------------------------------------------
+typedef std::chrono::steady_clock Clock;
+
+void test_benchmark_add_and_query(void)
+{
+    MemoryStorage storage;
+    TestHistory history(storage);
+    history.begin();
+    uint32_t now = addRamp(history, DAY_START, DAY_START + DAY);
+    uint32_t bytesPerDay = storage.bytesWritten;
+    uint32_t writesPerDay = storage.writes;
+
+    const uint32_t samples = 200000;
+    Clock::time_point start = Clock::now();
+    now = addRamp(history, now, now + samples * HISTORY_RAW_STEP) - HISTORY_RAW_STEP;
+    double addUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / samples;
+
+    const uint32_t queries = 2000;
+    uint32_t points = 0;
+    uint32_t sink = 0;
+    start = Clock::now();
+    for (uint32_t i = 0; i < queries; i++)
+    {
+        points += history.query(HISTORY_MINUTE, now - DAY, now, [&sink](const HistorySlot& s) { sink += s.count; });
+    }
+    double queryUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / queries;
+    TEST_ASSERT_GREATER_THAN(0, sink);
+
+    char line[160];
+    snprintf(line, sizeof(line), "add: %.2f us/sample; flash: %u bytes in %u writes per day", addUs,
+             (unsigned)bytesPerDay, (unsigned)writesPerDay);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "query: %.1f us for %u minute points (%.1f ns/point)", queryUs,
+             (unsigned)(points / queries), queryUs * 1000 / (points / queries));
+    TEST_MESSAGE(line);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_samples_wait_for_begin_and_the_clock);
+    RUN_TEST(test_raw_query_returns_the_readings_in_order);
+    RUN_TEST(test_rollups_hold_min_avg_max);
+    RUN_TEST(test_day_rollup_covers_every_sample);
+    RUN_TEST(test_old_data_ages_out);
+    RUN_TEST(test_space_used_never_grows);
+    RUN_TEST(test_queries_see_unflushed_slots);
+    RUN_TEST(test_flash_writes_are_batched);
+    RUN_TEST(test_query_reads_only_the_range);
+    RUN_TEST(test_reboot_resumes_the_rollups);
+    RUN_TEST(test_layout_change_starts_afresh);
+    RUN_TEST(test_benchmark_add_and_query);
+    return UNITY_END();
+}
@@ -0,0 +1,464 @@
+// Host-side tests for the store-and-forward journal (src/journal.h),
+// against a fake SD card backed by files on the host.
+// Run with: pio test -e native
+#include <unity.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+#include "journal.h"
+
+#define DATA_PATH "test_journal.bin"
+#define INDEX_PATH "test_journal.idx"
+#define INDEX_PATH_1 "test_journal.idx.1"
+
+// Journal storage on host files, counting what the card would see
+class FileStorage
+{
+public:
+    size_t read(uint32_t offset, void* data, size_t length)
+    {
+        FILE* file = fopen(DATA_PATH, "rb");
+        if (!file)
+        {
+            return 0;
+        }
+        size_t n = fseek(file, offset, SEEK_SET) == 0 ? fread(data, 1, length, file) : 0;
+        fclose(file);
+        reads++;
+        return n;
+    }
+
+    bool append(const void* data, size_t length)
+    {
+        if (failWrites)
+        {
+            return false;
+        }
+        FILE* file = fopen(DATA_PATH, "ab");
+        if (!file)
+        {
+            return false;
+        }
+        // A card that gives up part way through the block
+        size_t n = fwrite(data, 1, tornAppends ? length / 2 : length, file);
+        fclose(file);
+        appends++;
+        bytesAppended += n;
+        return n == length;
+    }
+
+    uint32_t size()
+    {
+        FILE* file = fopen(DATA_PATH, "rb");
+        if (!file)
+        {
+            return 0;
+        }
+        fseek(file, 0, SEEK_END);
+        uint32_t n = ftell(file);
+        fclose(file);
+        return n;
+    }
+
+    bool truncate(uint32_t length)
+    {
+        if (length == 0)
+        {
+            unlink(DATA_PATH);
+            return true;
+        }
+        return ::truncate(DATA_PATH, length) == 0;
+    }
+
+    static const char* indexPath(uint8_t copy)
+    {
+        return copy ? INDEX_PATH_1 : INDEX_PATH;
+    }
+
+    bool readIndex(uint8_t copy, void* data, size_t length)
+    {
+        FILE* file = fopen(indexPath(copy), "rb");
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = fread(data, 1, length, file);
+        fclose(file);
+        return n == length;
+    }
+
+    bool writeIndex(uint8_t copy, const void* data, size_t length)
+    {
+        if (failWrites)
+        {
+            return false;
+        }
+        FILE* file = fopen(indexPath(copy), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        size_t n = fwrite(data, 1, length, file);
+        fclose(file);
+        indexWrites++;
+        lastIndexCopy = copy;
+        return n == length;
+    }
+
+    // Raw access for simulating power cuts and bit rot
+    static std::vector<uint8_t> load(const char* path)
+    {
+        std::vector<uint8_t> bytes;
+        FILE* file = fopen(path, "rb");
+        if (file)
+        {
+            int c;
+            while ((c = fgetc(file)) != EOF)
+            {
+                bytes.push_back((uint8_t)c);
+            }
+            fclose(file);
+        }
+        return bytes;
+    }
+
+    static void save(const char* path, const std::vector<uint8_t>& bytes, const char* mode = "wb")
+    {
+        FILE* file = fopen(path, mode);
+        fwrite(bytes.data(), 1, bytes.size(), file);
+        fclose(file);
+    }
+
+    bool failWrites = false;
+    bool tornAppends = false;
+    uint8_t lastIndexCopy = 0;
+    uint32_t reads = 0;
+    uint32_t appends = 0;
+    uint32_t bytesAppended = 0;
+    uint32_t indexWrites = 0;
+};
+
+typedef Journal<FileStorage> TestJournal;
+const uint16_t PER_BLOCK = TestJournal::RECORDS_PER_BLOCK;
+
+static JournalRecord record(uint32_t i)
+{
+    JournalRecord r = {1700000000 + i, (int16_t)(2000 + i % 500), (int16_t)(4000 + i % 300), (int16_t)(i % 9000), 0};
+    return r;
+}
+
+static void appendRecords(TestJournal& journal, uint32_t first, uint32_t count)
+{
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        TEST_ASSERT_TRUE(journal.append(record(i)));
+    }
+}
+
+// Replays the whole backlog, checking records arrive in order from
+// first; returns the number replayed
+static uint32_t replayAll(TestJournal& journal, uint32_t first)
+{
+    JournalRecord records[PER_BLOCK];
+    uint32_t n = 0;
+    uint16_t count;
+    while ((count = journal.peek(records)) > 0)
+    {
+        for (uint16_t i = 0; i < count; i++)
+        {
+            TEST_ASSERT_EQUAL_UINT32(record(first + n + i).timestamp, records[i].timestamp);
+            TEST_ASSERT_EQUAL_INT16(record(first + n + i).centiC, records[i].centiC);
+            TEST_ASSERT_EQUAL_INT16(record(first + n + i).centiDbA, records[i].centiDbA);
+        }
+        n += count;
+        journal.ack(count);
+    }
+    return n;
+}
+
+void setUp(void)
+{
+    unlink(DATA_PATH);
+    unlink(INDEX_PATH);
+    unlink(INDEX_PATH_1);
+}
+
+void tearDown(void)
+{
+    unlink(DATA_PATH);
+    unlink(INDEX_PATH);
+    unlink(INDEX_PATH_1);
+}
+
+void test_records_replay_in_order(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    TEST_ASSERT_TRUE(journal.begin());
+    appendRecords(journal, 0, 3 * PER_BLOCK + 10);
+    TEST_ASSERT_EQUAL_UINT32(3, journal.backlog());
+    TEST_ASSERT_EQUAL_UINT16(10, journal.buffered());
+    TEST_ASSERT_TRUE(journal.sync());
+
+    TEST_ASSERT_EQUAL_UINT32(3 * PER_BLOCK + 10, replayAll(journal, 0));
+    TEST_ASSERT_EQUAL_UINT32(0, journal.backlog());
+    TEST_ASSERT_EQUAL_UINT32(3 * PER_BLOCK + 10, journal.stats().recordsReplayed);
+}
+
+void test_every_write_is_one_whole_block(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+    appendRecords(journal, 0, 5 * PER_BLOCK + 1);
+    journal.sync();
+    TEST_ASSERT_EQUAL_UINT32(6, storage.appends);
+    TEST_ASSERT_EQUAL_UINT32(6 * JOURNAL_BLOCK_SIZE, storage.bytesAppended);
+    TEST_ASSERT_EQUAL_UINT32(6 * JOURNAL_BLOCK_SIZE, storage.size());
+}
+
+void test_reopen_continues_the_backlog(void)
+{
+    FileStorage storage;
+    {
+        TestJournal journal(storage);
+        journal.begin();
+        appendRecords(journal, 0, 2 * PER_BLOCK);
+    }
+    TestJournal journal(storage);
+    TEST_ASSERT_TRUE(journal.begin());
+    TEST_ASSERT_EQUAL_UINT32(2, journal.backlog());
+    appendRecords(journal, 2 * PER_BLOCK, PER_BLOCK);
+    TEST_ASSERT_EQUAL_UINT32(3 * PER_BLOCK, replayAll(journal, 0));
+}
+
+// Power cut after a block went out but before the index caught up
+void test_blocks_past_a_stale_index_are_recovered(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+    appendRecords(journal, 0, PER_BLOCK);
+    std::vector<uint8_t> staleIndex = FileStorage::load(INDEX_PATH);
+    std::vector<uint8_t> staleIndex1 = FileStorage::load(INDEX_PATH_1);
+    appendRecords(journal, PER_BLOCK, 3 * PER_BLOCK);
+    FileStorage::save(INDEX_PATH, staleIndex);
+    FileStorage::save(INDEX_PATH_1, staleIndex1);
+
+    TestJournal reopened(storage);
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL_UINT32(4, reopened.backlog());
+    TEST_ASSERT_EQUAL_UINT32(4 * PER_BLOCK, replayAll(reopened, 0));
+}
+
+// Power cut mid-write: the partial block fails its CRC and is cut off
+void test_torn_tail_is_cut_off(void)
+{
+    FileStorage storage;
+    {
+        TestJournal journal(storage);
+        journal.begin();
+        appendRecords(journal, 0, 2 * PER_BLOCK);
+    }
+    FileStorage::save(DATA_PATH, std::vector<uint8_t>(JOURNAL_BLOCK_SIZE / 3, 0xA5), "ab");
+
+    TestJournal journal(storage);
+    TEST_ASSERT_TRUE(journal.begin());
+    TEST_ASSERT_EQUAL_UINT32(1, journal.stats().crcErrors);
+    TEST_ASSERT_EQUAL_UINT32(2 * JOURNAL_BLOCK_SIZE, storage.size());
+    appendRecords(journal, 2 * PER_BLOCK, PER_BLOCK);
+    TEST_ASSERT_EQUAL_UINT32(3 * PER_BLOCK, replayAll(journal, 0));
+}
+
+// The card fails part way through a block: what landed is cut off, so
+// the retried block and every later one sit at their proper offsets
+void test_partial_append_is_cut_off(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+    appendRecords(journal, 0, PER_BLOCK);
+    appendRecords(journal, PER_BLOCK, 5);
+    storage.tornAppends = true;
+    TEST_ASSERT_FALSE(journal.sync());
+    TEST_ASSERT_EQUAL_UINT32(JOURNAL_BLOCK_SIZE, storage.size());
+
+    storage.tornAppends = false;
+    appendRecords(journal, PER_BLOCK + 5, 2 * PER_BLOCK);
+    journal.sync();
+    TEST_ASSERT_EQUAL_UINT32(4 * JOURNAL_BLOCK_SIZE, storage.size());
+
+    TestJournal reopened(storage);
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL_UINT32(0, reopened.stats().crcErrors);
+    TEST_ASSERT_EQUAL_UINT32(3 * PER_BLOCK + 5, replayAll(reopened, 0));
+}
+
+// Power cut while the index is rewritten: the other copy still holds
+// the previous state, so at worst one block is replayed twice
+void test_torn_index_falls_back_to_the_other_copy(void)
+{
+    FileStorage storage;
+    {
+        TestJournal journal(storage);
+        journal.begin();
+        appendRecords(journal, 0, 3 * PER_BLOCK);
+        JournalRecord records[PER_BLOCK];
+        journal.peek(records);
+        journal.ack(PER_BLOCK);
+    }
+    FileStorage::save(FileStorage::indexPath(storage.lastIndexCopy), std::vector<uint8_t>(7, 0));
+
+    TestJournal journal(storage);
+    TEST_ASSERT_TRUE(journal.begin());
+    TEST_ASSERT_EQUAL_UINT32(3, journal.backlog());
+    TEST_ASSERT_EQUAL_UINT32(3 * PER_BLOCK, replayAll(journal, 0));
+}
+
+// Same, on the index write that follows emptying the file: the older
+// copy still points into the old file, and must be re-based
+void test_torn_index_after_catch_up_is_rebased(void)
+{
+    FileStorage storage;
+    {
+        TestJournal journal(storage);
+        journal.begin();
+        appendRecords(journal, 0, 2 * PER_BLOCK);
+        replayAll(journal, 0);
+    }
+    FileStorage::save(FileStorage::indexPath(storage.lastIndexCopy), std::vector<uint8_t>(7, 0));
+
+    TestJournal journal(storage);
+    TEST_ASSERT_TRUE(journal.begin());
+    TEST_ASSERT_EQUAL_UINT32(0, journal.backlog());
+    appendRecords(journal, 2 * PER_BLOCK, 2 * PER_BLOCK);
+    TEST_ASSERT_EQUAL_UINT32(2 * JOURNAL_BLOCK_SIZE, storage.size());
+
+    TestJournal reopened(storage);
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL_UINT32(2, reopened.backlog());
+    TEST_ASSERT_EQUAL_UINT32(2 * PER_BLOCK, replayAll(reopened, 2 * PER_BLOCK));
+}
+
+void test_corrupt_block_is_skipped_on_replay(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+    appendRecords(journal, 0, 3 * PER_BLOCK);
+    std::vector<uint8_t> data = FileStorage::load(DATA_PATH);
+    data[JOURNAL_BLOCK_SIZE + 40] ^= 0x55;
+    FileStorage::save(DATA_PATH, data);
+
+    JournalRecord records[PER_BLOCK];
+    TEST_ASSERT_EQUAL_UINT16(PER_BLOCK, journal.peek(records));
+    journal.ack(PER_BLOCK);
+    TEST_ASSERT_EQUAL_UINT16(PER_BLOCK, journal.peek(records)); // Block 1 skipped
+    TEST_ASSERT_EQUAL_UINT32(record(2 * PER_BLOCK).timestamp, records[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT32(1, journal.stats().crcErrors);
+}
+
+void test_caught_up_replay_empties_the_file(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+    appendRecords(journal, 0, 4 * PER_BLOCK);
+    replayAll(journal, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, storage.size());
+
+    // Sequence numbers carry on in the emptied file
+    appendRecords(journal, 4 * PER_BLOCK, PER_BLOCK);
+    TestJournal reopened(storage);
+    TEST_ASSERT_TRUE(reopened.begin());
+    TEST_ASSERT_EQUAL_UINT32(1, reopened.backlog());
+    TEST_ASSERT_EQUAL_UINT32(PER_BLOCK, replayAll(reopened, 4 * PER_BLOCK));
+}
+
+void test_failed_write_keeps_records_buffered(void)
+{
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+    appendRecords(journal, 0, 5);
+    storage.failWrites = true;
+    TEST_ASSERT_FALSE(journal.sync());
+    TEST_ASSERT_EQUAL_UINT16(5, journal.buffered());
+    TEST_ASSERT_EQUAL_UINT32(1, journal.stats().writeErrors);
+
+    storage.failWrites = false;
+    TEST_ASSERT_TRUE(journal.sync());
+    TEST_ASSERT_EQUAL_UINT32(5, replayAll(journal, 0));
+}
+
+// -----------------------------------------------------------------
+// Benchmark: write throughput and replay rate on the fake card
+// -----------------------------------------------------------------
+// Host file I/O stands in for the card, so absolute numbers are the
+// journal's own overhead (CRCs, index updates) plus host syscalls; the
+// operation counts per record are what carry over to a real SD card.
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void test_benchmark_write_and_replay(void)
+{
+    const uint32_t blocks = 2000;
+    const uint32_t records = blocks * PER_BLOCK;
+    FileStorage storage;
+    TestJournal journal(storage);
+    journal.begin();
+
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < records; i++)
+    {
+        journal.append(record(i));
+    }
+    double writeSeconds = secondsSince(start);
+
+    uint32_t readsBefore = storage.reads;
+    uint32_t indexWritesBefore = storage.indexWrites;
+    start = Clock::now();
+    JournalRecord batch[PER_BLOCK];
+    uint32_t replayed = 0;
+    uint16_t count;
+    while ((count = journal.peek(batch)) > 0)
+    {
+        replayed += count;
+        journal.ack(count);
+    }
+    double replaySeconds = secondsSince(start);
+    TEST_ASSERT_EQUAL_UINT32(records, replayed);
+
+    char line[160];
+    snprintf(line, sizeof(line), "write:  %u records in %u blocks, %.0f records/s (%.2f MB/s), %u index writes",
+             (unsigned)records, (unsigned)journal.stats().blocksWritten, records / writeSeconds,
+             storage.bytesAppended / writeSeconds / 1e6, (unsigned)indexWritesBefore);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "replay: %.0f records/s (%.0f blocks/s), %u block reads, %u index writes",
+             replayed / replaySeconds, blocks / replaySeconds, (unsigned)(storage.reads - readsBefore),
+             (unsigned)(storage.indexWrites - indexWritesBefore));
+    TEST_MESSAGE(line);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_records_replay_in_order);
+    RUN_TEST(test_every_write_is_one_whole_block);
+    RUN_TEST(test_reopen_continues_the_backlog);
+    RUN_TEST(test_blocks_past_a_stale_index_are_recovered);
+    RUN_TEST(test_torn_tail_is_cut_off);
+    RUN_TEST(test_partial_append_is_cut_off);
+    RUN_TEST(test_torn_index_falls_back_to_the_other_copy);
+    RUN_TEST(test_torn_index_after_catch_up_is_rebased);
+    RUN_TEST(test_corrupt_block_is_skipped_on_replay);
+    RUN_TEST(test_caught_up_replay_empties_the_file);
+    RUN_TEST(test_failed_write_keeps_records_buffered);
+    RUN_TEST(test_benchmark_write_and_replay);
+    return UNITY_END();
+}
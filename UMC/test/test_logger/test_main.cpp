@@ -0,0 +1,402 @@
+// Host-side tests for the lock-free log ring (src/logger.h), plus a
+// benchmark against the mutex + std::queue Logger it replaced.
+// Run with: pio test -e native
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "logger.h"
+#include "legacy_logger.h"
+
+static Logger& logger = Logger::getInstance();
+
+// Producer and sequence number ride in the entry's reading fields
+static Logger::LogEntry tagged(uint32_t producer, int32_t seq)
+{
+    Logger::LogEntry entry = {0, (float)producer, 0, 0, LOG_BOOTING, seq};
+    return entry;
+}
+
+// Stands in for a producer preempted between claiming a slot and
+// writing it
+class LoggerProbe
+{
+public:
+    static Logger::Slot* claim(uint32_t& pos)
+    {
+        return logger.claim(pos);
+    }
+
+    static void publish(Logger::Slot* slot, uint32_t pos, int32_t arg)
+    {
+        Logger::LogEntry entry = {0, 0, 0, 0, LOG_BOOTING, arg};
+        logger.publish(slot, pos, entry);
+    }
+};
+
+void setUp(void)
+{
+    Logger::LogEntry entry;
+    while (logger.get_log(entry))
+    {
+    }
+    logger.setOverflowPolicy(Logger::DropNewest);
+}
+
+void tearDown(void)
+{
+}
+
+void test_entries_come_out_in_order(void)
+{
+    for (int32_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(logger.log(LOG_WIFI_CONNECTING, i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, logger.pending());
+    TEST_ASSERT_EQUAL(LOG_WIFI_CONNECTING, logger.last());
+
+    Logger::LogEntry entry;
+    for (int32_t i = 0; i < 10; i++)
+    {
+        TEST_ASSERT_TRUE(logger.get_log(entry));
+        TEST_ASSERT_EQUAL(LOG_WIFI_CONNECTING, entry.id);
+        TEST_ASSERT_EQUAL_INT32(i, entry.arg);
+    }
+    TEST_ASSERT_FALSE(logger.get_log(entry));
+    TEST_ASSERT_EQUAL(LOG_NONE, entry.id);
+}
+
+void test_log_stamps_the_entry(void)
+{
+    Logger::LogEntry entry = {1, 21.5f, 70.7f, 40.0f, LOG_BOOTING, 0};
+    uint32_t before = (uint32_t)time(nullptr);
+    logger.log(entry);
+    TEST_ASSERT_TRUE(logger.get_log(entry));
+    TEST_ASSERT_UINT32_WITHIN(1, before, entry.timestamp);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 21.5f, entry.tempC);
+    TEST_ASSERT_FLOAT_WITHIN(0.001, 40.0f, entry.humidity);
+}
+
+void test_drop_newest_rejects_when_full(void)
+{
+    uint32_t dropped = logger.droppedNewest();
+    for (int32_t i = 0; i < LOG_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(logger.log(LOG_BOOTING, i));
+    }
+    TEST_ASSERT_FALSE(logger.log(LOG_BOOTING, LOG_CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32(dropped + 1, logger.droppedNewest());
+
+    Logger::LogEntry entry;
+    TEST_ASSERT_TRUE(logger.get_log(entry));
+    TEST_ASSERT_EQUAL_INT32(0, entry.arg);
+}
+
+void test_drop_oldest_evicts_when_full(void)
+{
+    logger.setOverflowPolicy(Logger::DropOldest);
+    uint32_t dropped = logger.droppedOldest();
+    for (int32_t i = 0; i < LOG_CAPACITY + 5; i++)
+    {
+        TEST_ASSERT_TRUE(logger.log(LOG_BOOTING, i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(dropped + 5, logger.droppedOldest());
+
+    Logger::LogEntry entry;
+    TEST_ASSERT_TRUE(logger.get_log(entry));
+    TEST_ASSERT_EQUAL_INT32(5, entry.arg);
+}
+
+// With the oldest slot claimed but not yet written, there is nothing
+// to evict: log() must drop the new entry rather than wait, since the
+// stalled producer may be the task an ISR interrupted
+void test_drop_oldest_never_waits_on_an_unpublished_slot(void)
+{
+    logger.setOverflowPolicy(Logger::DropOldest);
+    uint32_t held;
+    auto slot = LoggerProbe::claim(held);
+    for (int32_t i = 1; i < LOG_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(logger.log(LOG_BOOTING, i));
+    }
+    uint32_t newest = logger.droppedNewest();
+    uint32_t oldest = logger.droppedOldest();
+    TEST_ASSERT_FALSE(logger.log(LOG_BOOTING, LOG_CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32(newest + 1, logger.droppedNewest());
+    TEST_ASSERT_EQUAL_UINT32(oldest, logger.droppedOldest());
+
+    // Once the producer finishes, eviction works again
+    LoggerProbe::publish(slot, held, 0);
+    TEST_ASSERT_TRUE(logger.log(LOG_BOOTING, LOG_CAPACITY));
+    TEST_ASSERT_EQUAL_UINT32(oldest + 1, logger.droppedOldest());
+
+    Logger::LogEntry entry;
+    for (int32_t i = 1; i <= LOG_CAPACITY; i++)
+    {
+        TEST_ASSERT_TRUE(logger.get_log(entry));
+        TEST_ASSERT_EQUAL_INT32(i, entry.arg);
+    }
+    TEST_ASSERT_FALSE(logger.get_log(entry));
+}
+
+void test_formatting_is_left_to_the_consumer(void)
+{
+    Logger::LogEntry entry = {0, 0, 0, 0, LOG_SETUP_STARTED, 0};
+    char text[64];
+    Logger::formatMessage(entry, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("Setup started...", text);
+
+    entry.id = (LogId)LOG_ID_COUNT;
+    Logger::formatMessage(entry, text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("?", text);
+
+    // 0x01020304 seconds, id 5, arg -1, little endian
+    entry = {0x01020304, 0, 0, 0, (LogId)5, -1};
+    char hex[LOG_RECORD_HEX + 1];
+    Logger::encode(entry, hex);
+    TEST_ASSERT_EQUAL_STRING("0403020105ffffffff", hex);
+}
+
+// Several producers against one consumer, retrying when the ring is
+// full: every entry arrives exactly once, each producer's in order
+void test_concurrent_producers_lose_nothing(void)
+{
+    const uint32_t producers = 4;
+    const int32_t perProducer = 50000;
+    std::atomic<bool> done(false);
+    std::vector<int32_t> next(producers, 0);
+    uint32_t received = 0;
+    bool ordered = true;
+
+    std::thread consumer([&] {
+        Logger::LogEntry entry;
+        // Checking done first means the final drain sees every entry
+        for (bool last = false; !last;)
+        {
+            last = done;
+            while (logger.get_log(entry))
+            {
+                uint32_t p = (uint32_t)entry.tempC;
+                ordered &= p < producers && entry.arg == next[p];
+                next[p] = entry.arg + 1;
+                received++;
+            }
+        }
+    });
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([p] {
+            for (int32_t i = 0; i < perProducer; i++)
+            {
+                while (!logger.log(tagged(p, i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    done = true;
+    consumer.join();
+
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_EQUAL_UINT32(producers * perProducer, received);
+}
+
+// With DropOldest nobody retries: whatever isn't received was counted,
+// as evicted or, where the oldest slot was still being written, as
+// rejected
+void test_drop_oldest_accounts_for_every_entry(void)
+{
+    logger.setOverflowPolicy(Logger::DropOldest);
+    const uint32_t producers = 4;
+    const int32_t perProducer = 50000;
+    uint32_t droppedBefore = logger.dropped();
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> received(0);
+
+    std::vector<std::thread> threads;
+    for (int c = 0; c < 2; c++)
+    {
+        threads.emplace_back([&] {
+            Logger::LogEntry entry;
+            while (!done || logger.pending() > 0)
+            {
+                if (logger.get_log(entry))
+                {
+                    received++;
+                }
+            }
+        });
+    }
+    std::vector<std::thread> producerThreads;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        producerThreads.emplace_back([p] {
+            for (int32_t i = 0; i < perProducer; i++)
+            {
+                logger.log(tagged(p, i));
+            }
+        });
+    }
+    for (std::thread& t : producerThreads)
+    {
+        t.join();
+    }
+    done = true;
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(producers * perProducer, received + (logger.dropped() - droppedBefore));
+}
+
+// -----------------------------------------------------------------
+// Benchmark: this ring against the Logger it replaced
+// -----------------------------------------------------------------
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static void report(const char* name, uint32_t entries, double seconds)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "%-34s %8.1f ns/entry  %6.2f M entries/s", name, seconds * 1e9 / entries,
+             entries / seconds / 1e6);
+    TEST_MESSAGE(line);
+}
+
+// One task logging and draining in turn: the cost of log() itself
+static void benchSingleTask(uint32_t entries)
+{
+    LegacyLogger legacy;
+    LegacyLogger::LogEntry legacyEntry = {"", 21.5f, 70.7f, 40.0f, "Temperature read"};
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < entries; i++)
+    {
+        legacy.log(legacyEntry);
+        legacy.get_log(legacyEntry);
+    }
+    report("legacy, 1 task log+get", entries, secondsSince(start));
+
+    Logger::LogEntry entry = {0, 21.5f, 70.7f, 40.0f, LOG_BOOTING, 0};
+    start = Clock::now();
+    for (uint32_t i = 0; i < entries; i++)
+    {
+        logger.log(entry);
+        logger.get_log(entry);
+    }
+    report("ring, 1 task log+get", entries, secondsSince(start));
+}
+
+// Producers flat out against one consumer
+static void benchProducers(uint32_t producers, uint32_t perProducer)
+{
+    char name[48];
+    uint32_t total = producers * perProducer;
+
+    LegacyLogger legacy;
+    Clock::time_point start = Clock::now();
+    std::thread consumer([&] {
+        LegacyLogger::LogEntry entry;
+        uint32_t got = 0;
+        while (got < total)
+        {
+            if (legacy.get_log(entry))
+            {
+                got++;
+            }
+            else
+            {
+                std::this_thread::yield(); // As the device consumer sleeps when idle
+            }
+        }
+    });
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&] {
+            LegacyLogger::LogEntry entry = {"", 21.5f, 70.7f, 40.0f, "Temperature read"};
+            for (uint32_t i = 0; i < perProducer; i++)
+            {
+                legacy.log(entry);
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    consumer.join();
+    snprintf(name, sizeof(name), "legacy, %u producers -> 1", (unsigned)producers);
+    report(name, total, secondsSince(start));
+
+    threads.clear();
+    start = Clock::now();
+    std::thread ringConsumer([&] {
+        Logger::LogEntry entry;
+        uint32_t got = 0;
+        while (got < total)
+        {
+            if (logger.get_log(entry))
+            {
+                got++;
+            }
+            else
+            {
+                std::this_thread::yield(); // As the device consumer sleeps when idle
+            }
+        }
+    });
+    for (uint32_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&, p] {
+            for (uint32_t i = 0; i < perProducer; i++)
+            {
+                while (!logger.log(tagged(p, (int32_t)i)))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    ringConsumer.join();
+    snprintf(name, sizeof(name), "ring, %u producers -> 1", (unsigned)producers);
+    report(name, total, secondsSince(start));
+}
+
+void test_benchmark_against_legacy_logger(void)
+{
+    benchSingleTask(200000);
+    benchProducers(1, 200000);
+    benchProducers(4, 50000);
+}
+
+int main(int argc, char** argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_entries_come_out_in_order);
+    RUN_TEST(test_log_stamps_the_entry);
+    RUN_TEST(test_drop_newest_rejects_when_full);
+    RUN_TEST(test_drop_oldest_evicts_when_full);
+    RUN_TEST(test_drop_oldest_never_waits_on_an_unpublished_slot);
+    RUN_TEST(test_formatting_is_left_to_the_consumer);
+    RUN_TEST(test_concurrent_producers_lose_nothing);
+    RUN_TEST(test_drop_oldest_accounts_for_every_entry);
+    RUN_TEST(test_benchmark_against_legacy_logger);
+    return UNITY_END();
+}
@@ -0,0 +1,293 @@
+// Host-side tests for the sound level analysis (src/sound_dsp.h),
+// driven from WAV files. The fixtures are synthesised and written as
+// 16 kHz mono PCM WAVs at startup, then read back through the same
+// reader a recording from the device's microphone would go through.
+// Run with: pio test -e native
+#include <unity.h>
+#include <math.h>
+#include <unistd.h>
+#include <chrono>
+#include "sound_dsp.h"
+#include "wav.h"
+
+typedef SoundAnalyzer::Result Result;
+const uint16_t N = SoundAnalyzer::N;
+
+// Octave bands by centre frequency (see SoundAnalyzer::bandCentre)
+const uint8_t BAND_125 = 1;
+const uint8_t BAND_250 = 2;
+const uint8_t BAND_1K = 4;
+const uint8_t BAND_4K = 6;
+
+static SoundAnalyzer analyzer;
+
+// -----------------------------------------------------------------
+// Fixtures
+// -----------------------------------------------------------------
+struct Fixture
+{
+    const char* path;
+    uint16_t bits;
+    float seconds;
+    float (*signal)(uint32_t i); // Full scale is +-1
+};
+
+static float sine(uint32_t i, float hz, float dbfs)
+{
+    return powf(10.0f, dbfs / 20.0f) * sinf(2.0f * (float)M_PI * hz * i / SOUND_SAMPLE_RATE);
+}
+
+// Deterministic uniform noise, so runs are repeatable
+static float noise(uint32_t i)
+{
+    uint32_t x = i * 2654435761u + 0x9E3779B9u;
+    x ^= x >> 15;
+    x *= 0x2C1B3C6Du;
+    x ^= x >> 12;
+    x *= 0x297A2D39u;
+    x ^= x >> 15;
+    return (float)x / 2147483648.0f - 1.0f;
+}
+
+// The mic's DC offset is about 1 % of full scale
+static float tone1k(uint32_t i) { return 0.01f + sine(i, 1000, -10); }
+static float quiet1k(uint32_t i) { return 0.01f + sine(i, 1000, -40); }
+static float hum100(uint32_t i) { return 0.01f + sine(i, 100, -10); }
+static float twoTones(uint32_t i) { return sine(i, 250, -12) + sine(i, 4000, -12); }
+static float whiteNoise(uint32_t i) { return 0.25f * noise(i); }
+static float silence(uint32_t i) { return 0.01f; }
+
+static const Fixture TONE_1K = {"test_sound_tone1k.wav", 24, 1, tone1k};
+static const Fixture QUIET_1K = {"test_sound_quiet1k.wav", 24, 1, quiet1k};
+static const Fixture HUM_100 = {"test_sound_hum100.wav", 24, 1, hum100};
+static const Fixture TWO_TONES = {"test_sound_two_tones.wav", 16, 1, twoTones};
+static const Fixture WHITE_NOISE = {"test_sound_noise.wav", 16, 10, whiteNoise};
+static const Fixture SILENCE = {"test_sound_silence.wav", 32, 1, silence};
+static const Fixture* const FIXTURES[] = {&TONE_1K, &QUIET_1K, &HUM_100, &TWO_TONES, &WHITE_NOISE, &SILENCE};
+
+static void writeFixture(const Fixture& fixture)
+{
+    Wav wav;
+    wav.sampleRate = SOUND_SAMPLE_RATE;
+    wav.bitsPerSample = fixture.bits;
+    for (uint32_t i = 0; i < fixture.seconds * SOUND_SAMPLE_RATE; i++)
+    {
+        wav.samples.push_back((int32_t)(fixture.signal(i) * 2147483647.0));
+    }
+    wav.write(fixture.path);
+}
+
+static Wav load(const Fixture& fixture)
+{
+    Wav wav;
+    TEST_ASSERT_TRUE(wav.read(fixture.path));
+    TEST_ASSERT_EQUAL_UINT32(SOUND_SAMPLE_RATE, wav.sampleRate);
+    TEST_ASSERT_GREATER_OR_EQUAL(N, wav.samples.size());
+    return wav;
+}
+
+// Analyses every whole frame of the file, averaging the levels in the
+// power domain as a 1 s Leq would
+static Result analyzeWav(const Fixture& fixture)
+{
+    Wav wav = load(fixture);
+    uint32_t frames = wav.samples.size() / N;
+    double total = 0, weighted = 0;
+    double bands[SOUND_BAND_COUNT] = {0};
+    for (uint32_t f = 0; f < frames; f++)
+    {
+        Result r;
+        analyzer.process(&wav.samples[f * N], r);
+        total += pow(10.0, r.rmsDbfs / 10.0);
+        weighted += pow(10.0, r.dbA / 10.0);
+        for (uint8_t b = 0; b < SOUND_BAND_COUNT; b++)
+        {
+            bands[b] += pow(10.0, r.bands[b] / 10.0);
+        }
+    }
+    const float offset = 94.0f - MIC_DBFS_AT_94DB;
+    Result mean;
+    mean.rmsDbfs = 10.0f * log10(total / frames);
+    mean.dbSpl = mean.rmsDbfs + offset;
+    mean.dbA = 10.0f * log10(weighted / frames);
+    for (uint8_t b = 0; b < SOUND_BAND_COUNT; b++)
+    {
+        mean.bands[b] = 10.0f * log10(bands[b] / frames);
+    }
+    return mean;
+}
+
+static uint8_t loudestBand(const Result& r)
+{
+    uint8_t loudest = 0;
+    for (uint8_t b = 1; b < SOUND_BAND_COUNT; b++)
+    {
+        if (r.bands[b] > r.bands[loudest])
+        {
+            loudest = b;
+        }
+    }
+    return loudest;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+// -----------------------------------------------------------------
+// Tests
+// -----------------------------------------------------------------
+void test_wav_reader_round_trips_each_width(void)
+{
+    const Fixture* widths[] = {&TWO_TONES, &TONE_1K, &SILENCE};
+    for (const Fixture* fixture : widths)
+    {
+        Wav wav = load(*fixture);
+        TEST_ASSERT_EQUAL_UINT16(fixture->bits, wav.bitsPerSample);
+        TEST_ASSERT_EQUAL_UINT32(fixture->seconds * SOUND_SAMPLE_RATE, wav.samples.size());
+        // Left aligned: the quantisation step is one LSB at the file's width
+        double step = 1.0 / (1u << (fixture->bits - 1));
+        TEST_ASSERT_FLOAT_WITHIN(step * 1.01, fixture->signal(123), wav.samples[123] / 2147483648.0);
+    }
+}
+
+void test_full_scale_reference_tone_reads_its_level(void)
+{
+    Result r = analyzeWav(TONE_1K);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, -10.0f, r.rmsDbfs);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 94.0f - MIC_DBFS_AT_94DB - 10.0f, r.dbSpl);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, r.dbSpl, r.dbA); // A-weighting is 0 dB at 1 kHz
+    TEST_ASSERT_EQUAL_UINT8(BAND_1K, loudestBand(r));
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, r.dbSpl, r.bands[BAND_1K]);
+}
+
+void test_level_is_linear_in_db(void)
+{
+    Result loud = analyzeWav(TONE_1K);
+    Result quiet = analyzeWav(QUIET_1K);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 30.0f, loud.dbSpl - quiet.dbSpl);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 30.0f, loud.dbA - quiet.dbA);
+}
+
+void test_a_weighting_discounts_low_hum(void)
+{
+    Result r = analyzeWav(HUM_100);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, -10.0f, r.rmsDbfs);
+    TEST_ASSERT_FLOAT_WITHIN(1.5f, -19.1f, r.dbA - r.dbSpl); // IEC 61672 at 100 Hz
+    TEST_ASSERT_EQUAL_UINT8(BAND_125, loudestBand(r));
+}
+
+void test_two_tones_land_in_their_bands(void)
+{
+    Result r = analyzeWav(TWO_TONES);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, r.bands[BAND_250], r.bands[BAND_4K]);
+    for (uint8_t b = 0; b < SOUND_BAND_COUNT; b++)
+    {
+        if (b != BAND_250 && b != BAND_4K)
+        {
+            TEST_ASSERT_LESS_THAN(r.bands[BAND_250] - 20.0f, r.bands[b]);
+        }
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, -9.0f, r.rmsDbfs); // Two -12 dBFS tones
+}
+
+// White noise has equal energy per Hz, so each octave band holds
+// twice the energy of the one below. The 8 kHz band is cut in half by
+// Nyquist, and the lowest ones hold too few bins to be smooth.
+void test_white_noise_rises_3db_per_octave(void)
+{
+    Result r = analyzeWav(WHITE_NOISE);
+    for (uint8_t b = BAND_250; b < BAND_4K; b++)
+    {
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, 3.0f, r.bands[b + 1] - r.bands[b]);
+    }
+    // Uniform noise at +-0.25: rms 0.25 / sqrt(3), re a full-scale sine
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 20.0f * log10f(0.25f / sqrtf(3.0f) * sqrtf(2.0f)), r.rmsDbfs);
+}
+
+void test_dc_offset_alone_reads_as_silence(void)
+{
+    Result r = analyzeWav(SILENCE);
+    TEST_ASSERT_LESS_THAN(-100.0f, r.rmsDbfs);
+}
+
+// -----------------------------------------------------------------
+// Benchmark: frames analysed per second
+// -----------------------------------------------------------------
+// The device needs SOUND_SAMPLE_RATE / N frames per second to keep up
+// with the microphone; the ratio is the headroom on this host.
+void test_benchmark_frames_per_second(void)
+{
+    Wav wav = load(WHITE_NOISE);
+    uint32_t frames = wav.samples.size() / N;
+    const uint32_t passes = 50;
+    volatile float sink; // Keeps the results live
+    Result r;
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    for (uint32_t pass = 0; pass < passes; pass++)
+    {
+        for (uint32_t f = 0; f < frames; f++)
+        {
+            analyzer.process(&wav.samples[f * N], r);
+            sink = r.dbA;
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    Fft<N / 2> fft;
+    static float input[N], data[N];
+    for (uint16_t i = 0; i < N; i++)
+    {
+        input[i] = wav.samples[i] / 2147483648.0f;
+    }
+    start = Clock::now();
+    for (uint32_t i = 0; i < passes * frames; i++)
+    {
+        memcpy(data, input, sizeof(data));
+        fft.run(data);
+        sink = data[2];
+    }
+    double fftSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+    (void)sink;
+
+    double perSecond = passes * frames / seconds;
+    char line[160];
+    snprintf(line, sizeof(line), "analyzer: %.0f frames/s (%.1f us/frame, %.0fx real time at %u-sample frames)",
+             perSecond, 1e6 / perSecond, perSecond * N / SOUND_SAMPLE_RATE, (unsigned)N);
+    TEST_MESSAGE(line);
+    snprintf(line, sizeof(line), "of which %u-point complex FFT: %.1f us, input copy included", (unsigned)(N / 2),
+             fftSeconds * 1e6 / (passes * frames));
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN(SOUND_SAMPLE_RATE / N, (uint32_t)perSecond);
+}
+
+int main(int argc, char** argv)
+{
+    for (const Fixture* fixture : FIXTURES)
+    {
+        writeFixture(*fixture);
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_wav_reader_round_trips_each_width);
+    RUN_TEST(test_full_scale_reference_tone_reads_its_level);
+    RUN_TEST(test_level_is_linear_in_db);
+    RUN_TEST(test_a_weighting_discounts_low_hum);
+    RUN_TEST(test_two_tones_land_in_their_bands);
+    RUN_TEST(test_white_noise_rises_3db_per_octave);
+    RUN_TEST(test_dc_offset_alone_reads_as_silence);
+    RUN_TEST(test_benchmark_frames_per_second);
+    int failures = UNITY_END();
+
+    for (const Fixture* fixture : FIXTURES)
+    {
+        unlink(fixture->path);
+    }
+    return failures;
+}
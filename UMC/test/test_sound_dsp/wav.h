@@ -0,0 +1,124 @@
+#ifndef TEST_WAV_H
+#define TEST_WAV_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// Minimal RIFF/WAVE PCM reader and writer for the sound tests.
+// Reads mono 16, 24 or 32-bit PCM and returns samples as the I2S
+// driver delivers them: 32-bit words with the data left aligned.
+struct Wav
+{
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+    std::vector<int32_t> samples;
+
+    static uint32_t le(const uint8_t* p, uint8_t bytes)
+    {
+        uint32_t v = 0;
+        for (uint8_t i = 0; i < bytes; i++)
+        {
+            v |= (uint32_t)p[i] << (8 * i);
+        }
+        return v;
+    }
+
+    // Returns false if the file is missing or not mono PCM
+    bool read(const char* path)
+    {
+        FILE* file = fopen(path, "rb");
+        if (!file)
+        {
+            return false;
+        }
+        std::vector<uint8_t> bytes;
+        uint8_t chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        {
+            bytes.insert(bytes.end(), chunk, chunk + n);
+        }
+        fclose(file);
+
+        if (bytes.size() < 12 || memcmp(&bytes[0], "RIFF", 4) != 0 || memcmp(&bytes[8], "WAVE", 4) != 0)
+        {
+            return false;
+        }
+        bool haveFormat = false;
+        for (size_t at = 12; at + 8 <= bytes.size();)
+        {
+            uint32_t size = le(&bytes[at + 4], 4);
+            const uint8_t* body = &bytes[at + 8];
+            if (at + 8 + size > bytes.size())
+            {
+                return false;
+            }
+            if (memcmp(&bytes[at], "fmt ", 4) == 0)
+            {
+                uint16_t format = le(body, 2);
+                uint16_t channels = le(body + 2, 2);
+                sampleRate = le(body + 4, 4);
+                bitsPerSample = le(body + 14, 2);
+                if (format != 1 || channels != 1 || (bitsPerSample != 16 && bitsPerSample != 24 && bitsPerSample != 32))
+                {
+                    return false;
+                }
+                haveFormat = true;
+            }
+            else if (memcmp(&bytes[at], "data", 4) == 0 && haveFormat)
+            {
+                uint8_t width = bitsPerSample / 8;
+                samples.clear();
+                for (uint32_t i = 0; i + width <= size; i += width)
+                {
+                    samples.push_back((int32_t)(le(body + i, width) << (32 - bitsPerSample)));
+                }
+                return true;
+            }
+            at += 8 + size + (size & 1);
+        }
+        return false;
+    }
+
+    // Writes samples (left aligned 32-bit) at bitsPerSample
+    bool write(const char* path) const
+    {
+        FILE* file = fopen(path, "wb");
+        if (!file)
+        {
+            return false;
+        }
+        uint8_t width = bitsPerSample / 8;
+        uint32_t dataSize = samples.size() * width;
+        std::vector<uint8_t> bytes;
+        auto put = [&bytes](uint32_t v, uint8_t n) {
+            for (uint8_t i = 0; i < n; i++)
+            {
+                bytes.push_back((uint8_t)(v >> (8 * i)));
+            }
+        };
+        bytes.insert(bytes.end(), {'R', 'I', 'F', 'F'});
+        put(36 + dataSize, 4);
+        bytes.insert(bytes.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+        put(16, 4);
+        put(1, 2);                                  // PCM
+        put(1, 2);                                  // Mono
+        put(sampleRate, 4);
+        put(sampleRate * width, 4);
+        put(width, 2);
+        put(bitsPerSample, 2);
+        bytes.insert(bytes.end(), {'d', 'a', 't', 'a'});
+        put(dataSize, 4);
+        for (int32_t s : samples)
+        {
+            put((uint32_t)s >> (32 - bitsPerSample), width);
+        }
+        bool ok = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        fclose(file);
+        return ok;
+    }
+};
+
+#endif // TEST_WAV_H
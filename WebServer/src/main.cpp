@@ -1,5 +1,6 @@
 #include <WiFi.h>
 #include <WebServer.h>
+#include <wifi_link.h>
 
 const char *ssid = "JioFiber_401_2.4Gz";
 const char *password = "Melvin420";
@@ -12,9 +13,8 @@ void handleRoot() {
 
 void setup() {
     Serial.begin(9600);
-    WiFi.begin(ssid, password);
-    while (WiFi.status() != WL_CONNECTED) {
-        delay(500);
+    WiFiLink::getInstance().begin(ssid, password);
+    while (!WiFiLink::getInstance().waitConnected(500)) {
         Serial.print(".");
     }
     Serial.println("\nWiFi connected. IP address: ");
@@ -0,0 +1,312 @@
+#ifndef DIRTY_SSD1306_H
+#define DIRTY_SSD1306_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_SSD1306.h>
+#include <i2c_bus.h>
+
+#ifndef DIRTY_OLED_GAP
+#define DIRTY_OLED_GAP 8            // Unchanged bytes worth resending rather than opening a new window
+#endif
+
+// Data bytes per I2C transaction, as Adafruit_SSD1306 sizes them
+#if defined(I2C_BUFFER_LENGTH) && I2C_BUFFER_LENGTH < 256
+#define DIRTY_OLED_CHUNK (I2C_BUFFER_LENGTH - 1)
+#elif defined(I2C_BUFFER_LENGTH)
+#define DIRTY_OLED_CHUNK 255
+#else
+#define DIRTY_OLED_CHUNK 31
+#endif
+
+// Drop-in Adafruit_SSD1306 whose display() sends only what changed.
+//
+// A copy of the last frame sent to the panel is kept alongside the
+// framebuffer. display() compares the two page by page (8 pixel rows,
+// one byte per column) and, for each run of changed columns, points the
+// panel's page / column address window at it and writes just those
+// bytes. Runs separated by fewer than DIRTY_OLED_GAP unchanged bytes
+// are merged, since a new window costs a command transaction.
+//
+// Drawing code doesn't change - clearDisplay() and redrawing everything
+// still works, it just no longer puts 1 KB on the bus each frame. The
+// first frame after begin() or invalidate() is sent whole. SPI panels
+// fall back to the full-frame display().
+//
+// With useBus() every window and data chunk is queued on an I2cBus at
+// bulk priority instead of written directly: display() returns as soon
+// as the frame is queued, and sensor reads on the same bus go out between
+// its transactions rather than after the whole frame. The other calls
+// that talk to the panel (ssd1306_command, invertDisplay, dim and the
+// scroll commands) run on the bus task through I2cBus::run(). They are
+// non-virtual in Adafruit_SSD1306 apart from invertDisplay, so make
+// them on a DirtySSD1306, not through a base class pointer.
+class DirtySSD1306 : public Adafruit_SSD1306
+{
+public:
+    struct Stats
+    {
+        uint32_t frames;
+        uint32_t bytes;             // On the bus, including address and control bytes
+        uint32_t micros;
+        uint32_t lastBytes;
+        uint32_t lastMicros;
+    };
+
+    DirtySSD1306(uint8_t width, uint8_t height, TwoWire* twi = &Wire, int8_t resetPin = -1)
+        : Adafruit_SSD1306(width, height, twi, resetPin), bus_(nullptr), shadow_(nullptr), full_(true), stats_() {}
+
+    ~DirtySSD1306()
+    {
+        free(shadow_);
+    }
+
+    bool begin(uint8_t switchvcc = SSD1306_SWITCHCAPVCC, uint8_t address = 0, bool reset = true, bool periphBegin = true)
+    {
+        if (!Adafruit_SSD1306::begin(switchvcc, address, reset, periphBegin))
+        {
+            return false;
+        }
+        if (shadow_ == nullptr && wire != nullptr)
+        {
+            shadow_ = (uint8_t*)malloc(frameBytes());
+        }
+        full_ = true;
+        return true;
+    }
+
+    // Call after begin(); the bus owns the clock from then on
+    void useBus(I2cBus* bus)
+    {
+        bus_ = bus;
+#if ARDUINO >= 157
+        // Adafruit_SSD1306's own commands set wireClk and then
+        // restoreClk around every transaction; keep both at the bus's
+        wireClk = restoreClk = bus->clock();
+#endif
+    }
+
+    void ssd1306_command(uint8_t c)
+    {
+        onBus([&]() { Adafruit_SSD1306::ssd1306_command(c); });
+    }
+
+    void invertDisplay(bool i)
+    {
+        onBus([&]() { Adafruit_SSD1306::invertDisplay(i); });
+    }
+
+    void dim(bool dim)
+    {
+        onBus([&]() { Adafruit_SSD1306::dim(dim); });
+    }
+
+    void startscrollright(uint8_t start, uint8_t stop)
+    {
+        onBus([&]() { Adafruit_SSD1306::startscrollright(start, stop); });
+    }
+
+    void startscrollleft(uint8_t start, uint8_t stop)
+    {
+        onBus([&]() { Adafruit_SSD1306::startscrollleft(start, stop); });
+    }
+
+    void startscrolldiagright(uint8_t start, uint8_t stop)
+    {
+        onBus([&]() { Adafruit_SSD1306::startscrolldiagright(start, stop); });
+    }
+
+    void startscrolldiagleft(uint8_t start, uint8_t stop)
+    {
+        onBus([&]() { Adafruit_SSD1306::startscrolldiagleft(start, stop); });
+    }
+
+    void stopscroll()
+    {
+        onBus([&]() { Adafruit_SSD1306::stopscroll(); });
+    }
+
+    void display()
+    {
+        uint32_t start = micros();
+        uint32_t sent;
+        if (bus_ != nullptr && shadow_ != nullptr)
+        {
+            sent = sendChanges(full_); // A full frame too goes out window by window
+            full_ = false;
+        }
+        else if (full_ || shadow_ == nullptr)
+        {
+            Adafruit_SSD1306::display();
+            sent = fullFrameBusBytes();
+            if (shadow_ != nullptr)
+            {
+                memcpy(shadow_, buffer, frameBytes());
+                full_ = false;
+            }
+        }
+        else
+        {
+            sent = sendChanges();
+        }
+        uint32_t elapsed = micros() - start;
+        stats_.frames++;
+        stats_.bytes += sent;
+        stats_.micros += elapsed;
+        stats_.lastBytes = sent;
+        stats_.lastMicros = elapsed;
+    }
+
+    // Resend the whole frame next time, e.g. after the panel was reset
+    void invalidate()
+    {
+        full_ = true;
+    }
+
+    Stats stats() const
+    {
+        return stats_;
+    }
+
+    // Bus bytes Adafruit_SSD1306::display() sends for every frame
+    uint32_t fullFrameBusBytes() const
+    {
+        uint32_t data = frameBytes();
+        uint32_t chunks = (data + DIRTY_OLED_CHUNK - 1) / DIRTY_OLED_CHUNK;
+        return (2 + 5) + (2 + 1) + data + 2 * chunks; // Address window commands, then data
+    }
+
+private:
+    // Runs f on the bus task once useBus() has been called, else here.
+    // Waits for the bus, so a command is never reordered with a frame
+    // queued before it.
+    template <class F>
+    void onBus(F&& f)
+    {
+        if (bus_ != nullptr)
+        {
+            bus_->run(I2C_BULK, f);
+        }
+        else
+        {
+            f();
+        }
+    }
+
+    uint32_t frameBytes() const
+    {
+        return (uint32_t)WIDTH * ((HEIGHT + 7) / 8);
+    }
+
+    uint32_t sendChanges(bool all = false)
+    {
+        const uint8_t pages = (HEIGHT + 7) / 8;
+        const uint8_t offset = (WIDTH == 64 && HEIGHT == 48) ? 32 : 0; // As Adafruit_SSD1306::display()
+        uint32_t sent = 0;
+#if ARDUINO >= 157
+        if (bus_ == nullptr)
+        {
+            wire->setClock(wireClk);
+        }
+#endif
+        for (uint8_t page = 0; page < pages; page++)
+        {
+            uint8_t* now = buffer + page * WIDTH;
+            uint8_t* was = shadow_ + page * WIDTH;
+            if (all)
+            {
+                sent += sendWindow(page, offset, WIDTH - 1 + offset, now);
+                memcpy(was, now, WIDTH);
+                continue;
+            }
+            int16_t col = 0;
+            while (col < WIDTH)
+            {
+                while (col < WIDTH && now[col] == was[col])
+                {
+                    col++;
+                }
+                if (col == WIDTH)
+                {
+                    break;
+                }
+                int16_t first = col, last = col;
+                for (int16_t c = col + 1; c < WIDTH && c - last <= DIRTY_OLED_GAP; c++)
+                {
+                    if (now[c] != was[c])
+                    {
+                        last = c;
+                    }
+                }
+                sent += sendWindow(page, first + offset, last + offset, now + first);
+                memcpy(was + first, now + first, last - first + 1);
+                col = last + 1;
+            }
+        }
+#if ARDUINO >= 157
+        if (bus_ == nullptr)
+        {
+            wire->setClock(restoreClk);
+        }
+#endif
+        return sent;
+    }
+
+    uint32_t sendWindow(uint8_t page, uint8_t first, uint8_t last, const uint8_t* data)
+    {
+        if (bus_ != nullptr)
+        {
+            return queueWindow(page, first, last, data);
+        }
+        const uint8_t window[] = {SSD1306_PAGEADDR, page, page, SSD1306_COLUMNADDR, first, last};
+        wire->beginTransmission(i2caddr);
+        wire->write((uint8_t)0x00); // Co = 0, D/C = 0: command stream
+        wire->write(window, sizeof(window));
+        wire->endTransmission();
+        uint32_t sent = 2 + sizeof(window);
+
+        uint16_t remaining = last - first + 1;
+        while (remaining > 0)
+        {
+            uint16_t n = remaining < DIRTY_OLED_CHUNK ? remaining : DIRTY_OLED_CHUNK;
+            wire->beginTransmission(i2caddr);
+            wire->write((uint8_t)0x40); // Co = 0, D/C = 1: data stream
+            wire->write(data, n);
+            wire->endTransmission();
+            sent += 2 + n;
+            data += n;
+            remaining -= n;
+        }
+        return sent;
+    }
+
+    // Same transactions as sendWindow(), queued on the bus; the bus copies
+    // each one, so the framebuffer can be drawn into straight away
+    uint32_t queueWindow(uint8_t page, uint8_t first, uint8_t last, const uint8_t* data)
+    {
+        const uint8_t window[] = {0x00, SSD1306_PAGEADDR, page, page, SSD1306_COLUMNADDR, first, last};
+        bus_->write(i2caddr, window, sizeof(window), I2C_BULK);
+        uint32_t sent = 1 + sizeof(window);
+
+        uint8_t chunk[I2C_BUS_MAX_WRITE];
+        chunk[0] = 0x40;
+        uint16_t remaining = last - first + 1;
+        while (remaining > 0)
+        {
+            uint16_t n = remaining < I2C_BUS_MAX_WRITE - 1 ? remaining : I2C_BUS_MAX_WRITE - 1;
+            memcpy(chunk + 1, data, n);
+            bus_->write(i2caddr, chunk, 1 + n, I2C_BULK);
+            sent += 2 + n;
+            data += n;
+            remaining -= n;
+        }
+        return sent;
+    }
+
+    I2cBus* bus_;
+    uint8_t* shadow_;
+    bool full_;
+    Stats stats_;
+};
+
+#endif // DIRTY_SSD1306_H
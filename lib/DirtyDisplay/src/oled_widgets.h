@@ -0,0 +1,121 @@
+#ifndef OLED_WIDGETS_H
+#define OLED_WIDGETS_H
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+#define OLED_WIDGET_TEXT 24         // Longest text a TextWidget keeps
+
+// Retained widgets: each remembers what it last drew and only touches
+// the framebuffer when its value changes, erasing just its own box.
+// A screen built from them is drawn once and then updated in place -
+// no clearDisplay() per frame, so with DirtySSD1306 an unchanged value
+// costs neither drawing time nor bus bytes. set() returns true when
+// it drew, so callers can skip display() when nothing did.
+
+// Single line of text in a fixed box, 6 x 8 pixels per character at size 1
+class TextWidget
+{
+public:
+    TextWidget(int16_t x, int16_t y, int16_t width, uint8_t size = 1)
+        : x_(x), y_(y), width_(width), size_(size), drawn_(false)
+    {
+        last_[0] = '\0';
+    }
+
+    bool set(Adafruit_GFX& gfx, const char* text)
+    {
+        if (drawn_ && strncmp(text, last_, sizeof(last_)) == 0)
+        {
+            return false;
+        }
+        gfx.fillRect(x_, y_, width_, 8 * size_, 0);
+        gfx.setTextSize(size_);
+        gfx.setTextColor(1);
+        gfx.setTextWrap(false);
+        gfx.setCursor(x_, y_);
+        gfx.print(text);
+        strncpy(last_, text, sizeof(last_) - 1);
+        last_[sizeof(last_) - 1] = '\0';
+        drawn_ = true;
+        return true;
+    }
+
+    bool set(Adafruit_GFX& gfx, float value, uint8_t decimals, const char* suffix = "")
+    {
+        char text[OLED_WIDGET_TEXT];
+        snprintf(text, sizeof(text), "%.*f%s", decimals, value, suffix);
+        return set(gfx, text);
+    }
+
+    bool set(Adafruit_GFX& gfx, long value, const char* suffix = "")
+    {
+        char text[OLED_WIDGET_TEXT];
+        snprintf(text, sizeof(text), "%ld%s", value, suffix);
+        return set(gfx, text);
+    }
+
+    // Draw again on the next set(), e.g. after the screen was cleared
+    void invalidate()
+    {
+        drawn_ = false;
+    }
+
+private:
+    int16_t x_;
+    int16_t y_;
+    int16_t width_;
+    uint8_t size_;
+    bool drawn_;
+    char last_[OLED_WIDGET_TEXT];
+};
+
+// Outlined horizontal bar; only the part of the fill that moved is redrawn
+class BarWidget
+{
+public:
+    BarWidget(int16_t x, int16_t y, int16_t width, int16_t height)
+        : x_(x), y_(y), width_(width), height_(height), fill_(-1) {}
+
+    // fraction is clamped to 0..1
+    bool set(Adafruit_GFX& gfx, float fraction)
+    {
+        fraction = fraction < 0 ? 0 : (fraction > 1 ? 1 : fraction);
+        int16_t inner = width_ - 4;
+        int16_t fill = (int16_t)(fraction * inner + 0.5f);
+        if (fill == fill_)
+        {
+            return false;
+        }
+        if (fill_ < 0)
+        {
+            gfx.fillRect(x_, y_, width_, height_, 0);
+            gfx.drawRect(x_, y_, width_, height_, 1);
+            fill_ = 0;
+        }
+        if (fill > fill_)
+        {
+            gfx.fillRect(x_ + 2 + fill_, y_ + 2, fill - fill_, height_ - 4, 1);
+        }
+        else
+        {
+            gfx.fillRect(x_ + 2 + fill, y_ + 2, fill_ - fill, height_ - 4, 0);
+        }
+        fill_ = fill;
+        return true;
+    }
+
+    void invalidate()
+    {
+        fill_ = -1;
+    }
+
+private:
+    int16_t x_;
+    int16_t y_;
+    int16_t width_;
+    int16_t height_;
+    int16_t fill_;                  // Filled pixels, -1 before the first draw
+};
+
+#endif // OLED_WIDGETS_H
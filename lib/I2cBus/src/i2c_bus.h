@@ -0,0 +1,335 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <type_traits>
+
+#ifndef I2C_BUS_SENSOR_DEPTH
+#define I2C_BUS_SENSOR_DEPTH 4
+#endif
+
+#ifndef I2C_BUS_BULK_DEPTH
+#define I2C_BUS_BULK_DEPTH 24       // A whole SSD1306 frame: 8 pages x (window + 2 data chunks)
+#endif
+
+#define I2C_BUS_MAX_WRITE 128       // Bytes per queued write, Wire's buffer on ESP32
+
+enum I2cPriority : uint8_t
+{
+    I2C_SENSOR,                     // Short, latency sensitive reads
+    I2C_BULK,                       // Display flushes and other bulk writes
+    I2C_PRIORITY_COUNT
+};
+
+// Transaction manager for an I2C bus shared by sensors and a display.
+//
+// One task owns the TwoWire and executes queued transactions one at a
+// time, always taking the sensor queue first. Work is submitted in
+// single-transaction units (a display frame is many small writes), so
+// a sensor read waits at most for the transaction already on the wire,
+// never for a whole display flush.
+//
+// The ESP32's I2C controller has no DMA; the IDF driver under Wire runs
+// each transaction from the hardware FIFO and its interrupt while the
+// bus task sleeps, so the CPU is free for the duration of every transfer.
+//
+//   write()     asynchronous, data copied into the queue; only blocks
+//               while that priority's queue is full
+//   writeRead() synchronous register read with a repeated start
+//   run()       synchronous: runs code against the TwoWire on the bus
+//               task, for driver libraries that talk to Wire themselves
+//
+// Synchronous calls block the calling task (through its task
+// notification), not the bus, and may be made from the bus task itself.
+class I2cBus
+{
+public:
+    struct Stats
+    {
+        uint32_t transactions[I2C_PRIORITY_COUNT];
+        uint32_t maxWaitUs[I2C_PRIORITY_COUNT];     // Queued -> started
+        uint32_t totalWaitUs[I2C_PRIORITY_COUNT];
+        uint8_t maxDepth[I2C_PRIORITY_COUNT];
+        uint32_t errors;
+        uint32_t bytes;
+        uint32_t busyUs;            // Time spent in transactions ...
+        uint32_t windowUs;          // ... out of this much since the last report
+    };
+
+    explicit I2cBus(TwoWire& wire) : wire_(wire), task_(nullptr), pending_(nullptr), clockHz_(0), windowStart_(0), stats_(),
+                                     lock_(portMUX_INITIALIZER_UNLOCKED)
+    {
+        queues_[I2C_SENSOR] = nullptr;
+        queues_[I2C_BULK] = nullptr;
+    }
+
+    // Call after wire.begin(). The task should run at a higher priority
+    // than the code using the bus, on the same core, so it picks up
+    // work as soon as it is queued.
+    bool begin(uint32_t clockHz = 400000, uint8_t core = 1, UBaseType_t priority = 4)
+    {
+        clockHz_ = clockHz;
+        wire_.setClock(clockHz);
+        queues_[I2C_SENSOR] = xQueueCreate(I2C_BUS_SENSOR_DEPTH, sizeof(Transaction));
+        queues_[I2C_BULK] = xQueueCreate(I2C_BUS_BULK_DEPTH, sizeof(Transaction));
+        pending_ = xSemaphoreCreateCounting(I2C_BUS_SENSOR_DEPTH + I2C_BUS_BULK_DEPTH, 0);
+        if (queues_[I2C_SENSOR] == nullptr || queues_[I2C_BULK] == nullptr || pending_ == nullptr)
+        {
+            return false;
+        }
+        windowStart_ = micros();
+        return xTaskCreatePinnedToCore(taskEntry, "i2c_bus", 4096, this, priority, &task_, core) == pdPASS;
+    }
+
+    bool write(uint8_t address, const uint8_t* data, uint16_t length, I2cPriority priority = I2C_BULK)
+    {
+        if (length > I2C_BUS_MAX_WRITE)
+        {
+            return false;
+        }
+        Transaction t = {};
+        t.kind = Write;
+        t.address = address;
+        t.length = length;
+        memcpy(t.data, data, length);
+        return submit(t, priority);
+    }
+
+    // Returns Wire's error code; 0 is success
+    uint8_t writeRead(uint8_t address, const uint8_t* tx, uint16_t txLength, uint8_t* rx, uint16_t rxLength,
+                      I2cPriority priority = I2C_SENSOR)
+    {
+        if (txLength > I2C_BUS_MAX_WRITE)
+        {
+            return 1;
+        }
+        uint8_t result = 0;
+        Transaction t = {};
+        t.kind = WriteRead;
+        t.address = address;
+        t.length = txLength;
+        memcpy(t.data, tx, txLength);
+        t.rx = rx;
+        t.rxLength = rxLength;
+        t.result = &result;
+        submitAndWait(t, priority);
+        return result;
+    }
+
+    // Runs f() on the bus task with the bus to itself, and waits for it
+    template <class F>
+    void run(I2cPriority priority, F&& f)
+    {
+        typedef typename std::remove_reference<F>::type Fn;
+        Transaction t = {};
+        t.kind = Call;
+        t.job = [](void* context) { (*static_cast<Fn*>(context))(); };
+        t.context = &f;
+        submitAndWait(t, priority);
+    }
+
+    // Waits until everything queued so far has gone out
+    void flush()
+    {
+        run(I2C_BULK, []() {});
+    }
+
+    // The clock set by begin(), for code in run() that sets its own
+    uint32_t clock() const
+    {
+        return clockHz_;
+    }
+
+    Stats stats()
+    {
+        return snapshot(false);
+    }
+
+    // Prints utilization and queue latency since the last report, then
+    // starts a new window. The copy and the reset are one critical
+    // section, so no transaction lands between them uncounted.
+    void report(Print& out)
+    {
+        Stats s = snapshot(true);
+        static const char* const names[I2C_PRIORITY_COUNT] = {"sensor", "bulk"};
+        out.printf("i2c: %.1f%% busy, %lu bytes, %lu errors\n",
+                   s.windowUs ? 100.0 * s.busyUs / s.windowUs : 0.0, (unsigned long)s.bytes, (unsigned long)s.errors);
+        for (uint8_t p = 0; p < I2C_PRIORITY_COUNT; p++)
+        {
+            out.printf("  %-6s %6lu txn, wait avg %5lu max %6lu us, depth max %u\n", names[p],
+                       (unsigned long)s.transactions[p],
+                       (unsigned long)(s.transactions[p] ? s.totalWaitUs[p] / s.transactions[p] : 0),
+                       (unsigned long)s.maxWaitUs[p], s.maxDepth[p]);
+        }
+    }
+
+private:
+    enum Kind : uint8_t
+    {
+        Write,
+        WriteRead,
+        Call
+    };
+
+    struct Transaction
+    {
+        Kind kind;
+        uint8_t address;
+        uint16_t length;
+        uint16_t rxLength;
+        uint8_t* rx;
+        uint8_t* result;
+        void (*job)(void*);
+        void* context;
+        TaskHandle_t waiter;        // nullptr for fire-and-forget writes
+        uint32_t queuedUs;
+        uint8_t data[I2C_BUS_MAX_WRITE];
+    };
+
+    Stats snapshot(bool reset)
+    {
+        portENTER_CRITICAL(&lock_);
+        Stats copy = stats_;
+        uint32_t now = micros();
+        copy.windowUs = now - windowStart_;
+        if (reset)
+        {
+            stats_ = Stats();
+            windowStart_ = now;
+        }
+        portEXIT_CRITICAL(&lock_);
+        return copy;
+    }
+
+    bool submit(Transaction& t, I2cPriority priority)
+    {
+        t.queuedUs = micros();
+        if (xQueueSend(queues_[priority], &t, portMAX_DELAY) != pdTRUE)
+        {
+            return false;
+        }
+        uint8_t depth = (uint8_t)uxQueueMessagesWaiting(queues_[priority]);
+        portENTER_CRITICAL(&lock_);
+        if (depth > stats_.maxDepth[priority])
+        {
+            stats_.maxDepth[priority] = depth;
+        }
+        portEXIT_CRITICAL(&lock_);
+        xSemaphoreGive(pending_);
+        return true;
+    }
+
+    void submitAndWait(Transaction& t, I2cPriority priority)
+    {
+        if (xTaskGetCurrentTaskHandle() == task_)
+        {
+            execute(t); // Already on the bus
+            return;
+        }
+        t.waiter = xTaskGetCurrentTaskHandle();
+        if (submit(t, priority))
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    }
+
+    static void taskEntry(void* arg)
+    {
+        I2cBus* self = static_cast<I2cBus*>(arg);
+        Transaction t;
+        for (;;)
+        {
+            xSemaphoreTake(self->pending_, portMAX_DELAY);
+            uint8_t priority = I2C_SENSOR;
+            if (xQueueReceive(self->queues_[I2C_SENSOR], &t, 0) != pdTRUE)
+            {
+                priority = I2C_BULK;
+                if (xQueueReceive(self->queues_[I2C_BULK], &t, 0) != pdTRUE)
+                {
+                    continue;
+                }
+            }
+
+            uint32_t start = micros();
+            uint32_t wait = start - t.queuedUs;
+            uint32_t bytes = self->execute(t);
+            uint32_t busy = micros() - start;
+
+            portENTER_CRITICAL(&self->lock_);
+            Stats& s = self->stats_;
+            s.transactions[priority]++;
+            s.totalWaitUs[priority] += wait;
+            if (wait > s.maxWaitUs[priority])
+            {
+                s.maxWaitUs[priority] = wait;
+            }
+            s.bytes += bytes;
+            s.busyUs += busy;
+            portEXIT_CRITICAL(&self->lock_);
+
+            if (t.waiter != nullptr)
+            {
+                xTaskNotifyGive(t.waiter);
+            }
+        }
+    }
+
+    // Returns the bytes moved, for the stats
+    uint32_t execute(Transaction& t)
+    {
+        uint8_t error = 0;
+        uint32_t bytes = 0;
+        switch (t.kind)
+        {
+        case Write:
+            wire_.beginTransmission(t.address);
+            wire_.write(t.data, t.length);
+            error = wire_.endTransmission();
+            bytes = 1 + t.length;
+            break;
+        case WriteRead:
+            wire_.beginTransmission(t.address);
+            wire_.write(t.data, t.length);
+            error = wire_.endTransmission(false);
+            if (error == 0 && wire_.requestFrom(t.address, (uint8_t)t.rxLength) == t.rxLength)
+            {
+                for (uint16_t i = 0; i < t.rxLength; i++)
+                {
+                    t.rx[i] = wire_.read();
+                }
+            }
+            else if (error == 0)
+            {
+                error = 4;
+            }
+            bytes = 2 + t.length + t.rxLength;
+            break;
+        case Call:
+            t.job(t.context);
+            break;
+        }
+        if (error != 0)
+        {
+            portENTER_CRITICAL(&lock_);
+            stats_.errors++;
+            portEXIT_CRITICAL(&lock_);
+        }
+        if (t.result != nullptr)
+        {
+            *t.result = error;
+        }
+        return bytes;
+    }
+
+    TwoWire& wire_;
+    TaskHandle_t task_;
+    QueueHandle_t queues_[I2C_PRIORITY_COUNT];
+    SemaphoreHandle_t pending_;
+    uint32_t clockHz_;
+    uint32_t windowStart_;
+    Stats stats_;
+    portMUX_TYPE lock_;
+};
+
+#endif // I2C_BUS_H
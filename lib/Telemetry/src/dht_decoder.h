@@ -0,0 +1,153 @@
+#ifndef DHT_DECODER_H
+#define DHT_DECODER_H
+
+#include <stdint.h>
+
+// Same type codes as the Adafruit DHT library, so DHTTYPE works with either
+#ifndef DHT11
+#define DHT11 11
+#endif
+#ifndef DHT12
+#define DHT12 12
+#endif
+#ifndef DHT21
+#define DHT21 21
+#endif
+#ifndef DHT22
+#define DHT22 22
+#endif
+
+// Pulse width windows in microseconds. The datasheets give 80/80 for the
+// response and 50 low + 26-28 (0) or 70 (1) high per bit; DHT11 clones
+// drift a fair way from that, so the windows are generous.
+#define DHT_RESPONSE_MIN_US 60
+#define DHT_RESPONSE_MAX_US 110
+#define DHT_BIT_LOW_MIN_US  30
+#define DHT_BIT_LOW_MAX_US  90
+#define DHT_BIT_HIGH_MIN_US 10
+#define DHT_BIT_HIGH_MAX_US 100
+#define DHT_BIT_ONE_US      45      // High pulses longer than this are 1s
+
+#define DHT_FRAME_BITS 40
+
+enum DhtStatus : uint8_t
+{
+    DHT_OK,
+    DHT_TIMEOUT,                    // Nothing captured at all
+    DHT_NO_RESPONSE,                // No 80/80 us response in the capture
+    DHT_TRUNCATED,                  // Response seen, fewer than 40 bits after it
+    DHT_BAD_TIMING,                 // A bit pulse outside its window
+    DHT_BAD_CHECKSUM
+};
+
+// One level run on the data line, as captured by the RMT peripheral
+struct DhtPulse
+{
+    uint8_t level;
+    uint16_t us;
+};
+
+// Decodes a captured DHT pulse train into a reading. Pure C++ with no
+// Arduino dependency, so captured pulse arrays can be replayed on a host.
+class DhtDecoder
+{
+public:
+    // Finds the sensor's response and unpacks the 5 data bytes
+    static DhtStatus decodeBytes(const DhtPulse* pulses, uint16_t count, uint8_t bytes[5])
+    {
+        if (count == 0)
+        {
+            return DHT_TIMEOUT;
+        }
+
+        // Anything before the response is the tail of our own start pulse
+        // and the line floating high while the sensor gets ready
+        uint16_t i = 0;
+        while (i + 1 < count &&
+               !(pulses[i].level == 0 && within(pulses[i].us, DHT_RESPONSE_MIN_US, DHT_RESPONSE_MAX_US) &&
+                 pulses[i + 1].level == 1 && within(pulses[i + 1].us, DHT_RESPONSE_MIN_US, DHT_RESPONSE_MAX_US)))
+        {
+            i++;
+        }
+        if (i + 1 >= count)
+        {
+            return DHT_NO_RESPONSE;
+        }
+        i += 2;
+        if (count - i < 2 * DHT_FRAME_BITS)
+        {
+            return DHT_TRUNCATED;
+        }
+
+        for (uint8_t b = 0; b < 5; b++)
+        {
+            bytes[b] = 0;
+        }
+        for (uint8_t bit = 0; bit < DHT_FRAME_BITS; bit++, i += 2)
+        {
+            const DhtPulse& low = pulses[i];
+            const DhtPulse& high = pulses[i + 1];
+            if (low.level != 0 || high.level != 1 ||
+                !within(low.us, DHT_BIT_LOW_MIN_US, DHT_BIT_LOW_MAX_US) ||
+                !within(high.us, DHT_BIT_HIGH_MIN_US, DHT_BIT_HIGH_MAX_US))
+            {
+                return DHT_BAD_TIMING;
+            }
+            bytes[bit / 8] = (uint8_t)(bytes[bit / 8] << 1) | (high.us > DHT_BIT_ONE_US ? 1 : 0);
+        }
+
+        if ((uint8_t)(bytes[0] + bytes[1] + bytes[2] + bytes[3]) != bytes[4])
+        {
+            return DHT_BAD_CHECKSUM;
+        }
+        return DHT_OK;
+    }
+
+    // Converts the data bytes the way the Adafruit library does for each type
+    static void convert(uint8_t type, const uint8_t bytes[5], float& tempC, float& humidity)
+    {
+        if (type == DHT11)
+        {
+            humidity = bytes[0] + bytes[1] * 0.1f;
+            tempC = (bytes[3] & 0x80) ? -1.0f - bytes[2] : bytes[2];
+            tempC += (bytes[3] & 0x0F) * 0.1f;
+        }
+        else if (type == DHT12)
+        {
+            humidity = bytes[0] + bytes[1] * 0.1f;
+            tempC = bytes[2] + (bytes[3] & 0x0F) * 0.1f;
+            if (bytes[2] & 0x80)
+            {
+                tempC = -tempC;
+            }
+        }
+        else
+        {
+            humidity = ((uint16_t)bytes[0] << 8 | bytes[1]) * 0.1f;
+            tempC = ((uint16_t)(bytes[2] & 0x7F) << 8 | bytes[3]) * 0.1f;
+            if (bytes[2] & 0x80)
+            {
+                tempC = -tempC;
+            }
+        }
+    }
+
+    static DhtStatus decode(const DhtPulse* pulses, uint16_t count, uint8_t type, float& tempC, float& humidity)
+    {
+        uint8_t bytes[5];
+        DhtStatus status = decodeBytes(pulses, count, bytes);
+        if (status == DHT_OK)
+        {
+            convert(type, bytes, tempC, humidity);
+        }
+        return status;
+    }
+
+private:
+    static bool within(uint16_t us, uint16_t min, uint16_t max)
+    {
+        return us >= min && us <= max;
+    }
+};
+
+#endif // DHT_DECODER_H
@@ -0,0 +1,235 @@
+#ifndef DHT_RMT_H
+#define DHT_RMT_H
+
+#include <Arduino.h>
+#include <time.h>
+#include "driver/gpio.h"
+#include "driver/rmt.h"
+#include "dht_decoder.h"
+#include "reading.h"
+
+#ifndef DHT_RMT_CHANNEL
+#define DHT_RMT_CHANNEL RMT_CHANNEL_4   // Clear of the low channels other libraries grab
+#endif
+
+#ifndef DHT_RMT_TIMEOUT
+#define DHT_RMT_TIMEOUT 20              // ms to wait for a frame (~5 ms on the wire)
+#endif
+
+#define DHT_MAX_PULSES 128              // One RMT memory block holds 64 items / 128 runs
+
+// Sensor policy: DHT11 / DHT22 read through the RMT peripheral.
+//
+// The Adafruit library bit-bangs the frame with interrupts off for ~5 ms
+// on every read, which stalls WiFi and the loop. Here a small task drives
+// the start pulse (vTaskDelay, so the CPU is free), then the RMT captures
+// the sensor's pulse train into its own memory by itself. The task only
+// wakes once the line has gone idle, to decode the pulses with
+// DhtDecoder - which is pure C++ and can be tested on a host.
+//
+// Two ways to use it:
+//   - as a Sensor policy: read() never blocks. It returns the result of
+//     the conversion started by the previous read() (begin() starts the
+//     first one) and kicks off the next.
+//   - asynchronously: request() and get the reading in a callback,
+//     called from the DHT task.
+template <uint8_t PIN, uint8_t TYPE>
+class DhtRmt
+{
+public:
+    typedef void (*ReadingCallback)(DhtStatus status, const Reading& reading);
+
+    struct Stats
+    {
+        uint32_t reads;
+        uint32_t failures;
+        DhtStatus lastStatus;
+    };
+
+    DhtRmt() : task_(nullptr), done_(nullptr), ring_(nullptr), callback_(nullptr),
+               status_(DHT_TIMEOUT), fresh_(false), lastStart_(0), conversionUs_(0), stats_(), lock_(portMUX_INITIALIZER_UNLOCKED)
+    {
+        result_ = Reading();
+    }
+
+    void begin()
+    {
+        rmt_config_t config = RMT_DEFAULT_CONFIG_RX((gpio_num_t)PIN, DHT_RMT_CHANNEL);
+        config.clk_div = 80;                            // 1 us ticks from the 80 MHz APB clock
+        config.mem_block_num = 1;
+        config.rx_config.filter_en = true;
+        config.rx_config.filter_ticks_thresh = 100;     // APB ticks, drops glitches under 1.25 us
+        config.rx_config.idle_threshold = 200;          // us without an edge ends the frame
+        rmt_config(&config);
+        rmt_driver_install(DHT_RMT_CHANNEL, 1024, 0);
+        rmt_get_ringbuf_handle(DHT_RMT_CHANNEL, &ring_);
+
+        // Open drain with the input still routed to the RMT, so the task
+        // can pull the line low for the start pulse without re-muxing it
+        gpio_set_direction((gpio_num_t)PIN, GPIO_MODE_INPUT_OUTPUT_OD);
+        gpio_set_pull_mode((gpio_num_t)PIN, GPIO_PULLUP_ONLY);
+        gpio_set_level((gpio_num_t)PIN, 1);
+
+        done_ = xSemaphoreCreateBinary();
+        xTaskCreatePinnedToCore(run, "dht", 3072, this, 3, &task_, 1);
+        request();
+    }
+
+    // Starts a conversion; the sensor's minimum interval is enforced by
+    // the task, so this is safe to call at any rate
+    void request()
+    {
+        xTaskNotifyGive(task_);
+    }
+
+    // Called from the DHT task after every conversion
+    void onReading(ReadingCallback callback)
+    {
+        callback_ = callback;
+    }
+
+    // Returns false (and leaves reading untouched) if the last conversion
+    // failed or has already been returned. Never blocks. conversionUs, if
+    // given, gets how long that conversion took from start pulse to
+    // decoded result, or 0 if there was no new conversion; read() itself
+    // is only a copy.
+    bool read(Reading& reading, uint32_t* conversionUs = nullptr)
+    {
+        portENTER_CRITICAL(&lock_);
+        bool ok = fresh_ && status_ == DHT_OK;
+        if (ok)
+        {
+            reading = result_;
+        }
+        if (conversionUs != nullptr)
+        {
+            *conversionUs = fresh_ ? conversionUs_ : 0;
+        }
+        fresh_ = false;
+        portEXIT_CRITICAL(&lock_);
+        request();
+        return ok;
+    }
+
+    // Blocks the calling task (not the CPU) until the pending conversion
+    // finishes, for callers that want a reading right after begin()
+    bool wait(uint32_t timeoutMs)
+    {
+        return xSemaphoreTake(done_, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+    }
+
+    Stats stats()
+    {
+        portENTER_CRITICAL(&lock_);
+        Stats copy = stats_;
+        portEXIT_CRITICAL(&lock_);
+        return copy;
+    }
+
+private:
+    static void run(void* arg)
+    {
+        DhtRmt* self = static_cast<DhtRmt*>(arg);
+        DhtPulse pulses[DHT_MAX_PULSES];
+        for (;;)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            self->waitMinInterval();
+
+            uint32_t start = micros();
+            uint16_t count = self->capture(pulses);
+            Reading reading = {(uint32_t)time(nullptr), 0, 0, 0};
+            DhtStatus status = DhtDecoder::decode(pulses, count, TYPE, reading.tempC, reading.humidity);
+            reading.tempF = reading.tempC * 1.8f + 32.0f;
+            uint32_t elapsed = micros() - start;
+
+            portENTER_CRITICAL(&self->lock_);
+            if (status == DHT_OK)
+            {
+                self->result_ = reading;
+            }
+            self->status_ = status;
+            self->fresh_ = true;
+            self->conversionUs_ = elapsed;
+            self->stats_.reads++;
+            self->stats_.failures += status == DHT_OK ? 0 : 1;
+            self->stats_.lastStatus = status;
+            portEXIT_CRITICAL(&self->lock_);
+
+            xSemaphoreGive(self->done_);
+            if (self->callback_ != nullptr)
+            {
+                self->callback_(status, reading);
+            }
+        }
+    }
+
+    // DHT11 wants >= 1 s between conversions, DHT22 >= 2 s
+    void waitMinInterval()
+    {
+        const uint32_t interval = TYPE == DHT11 ? 1000 : 2000;
+        uint32_t since = millis() - lastStart_;
+        if (lastStart_ != 0 && since < interval)
+        {
+            vTaskDelay(pdMS_TO_TICKS(interval - since));
+        }
+        lastStart_ = millis();
+    }
+
+    // Start pulse, then let the RMT record the reply. Returns the number
+    // of level runs written to pulses.
+    uint16_t capture(DhtPulse* pulses)
+    {
+        // Drain anything left from a frame that arrived after a timeout
+        size_t size = 0;
+        void* stale;
+        while ((stale = xRingbufferReceive(ring_, &size, 0)) != nullptr)
+        {
+            vRingbufferReturnItem(ring_, stale);
+        }
+
+        gpio_set_level((gpio_num_t)PIN, 0);
+        vTaskDelay(pdMS_TO_TICKS(TYPE == DHT11 ? 20 : 2));
+        rmt_rx_start(DHT_RMT_CHANNEL, true);
+        gpio_set_level((gpio_num_t)PIN, 1);
+
+        rmt_item32_t* items = (rmt_item32_t*)xRingbufferReceive(ring_, &size, pdMS_TO_TICKS(DHT_RMT_TIMEOUT));
+        rmt_rx_stop(DHT_RMT_CHANNEL);
+        if (items == nullptr)
+        {
+            return 0;
+        }
+
+        uint16_t count = 0;
+        size_t itemCount = size / sizeof(rmt_item32_t);
+        for (size_t i = 0; i < itemCount && count + 2 <= DHT_MAX_PULSES; i++)
+        {
+            if (items[i].duration0 == 0)
+            {
+                break;
+            }
+            pulses[count++] = {(uint8_t)items[i].level0, (uint16_t)items[i].duration0};
+            if (items[i].duration1 == 0)
+            {
+                break;
+            }
+            pulses[count++] = {(uint8_t)items[i].level1, (uint16_t)items[i].duration1};
+        }
+        vRingbufferReturnItem(ring_, items);
+        return count;
+    }
+
+    TaskHandle_t task_;
+    SemaphoreHandle_t done_;
+    RingbufHandle_t ring_;
+    ReadingCallback callback_;
+    Reading result_;
+    DhtStatus status_;
+    bool fresh_;
+    uint32_t lastStart_;
+    uint32_t conversionUs_;         // Last conversion, start pulse to decoded
+    Stats stats_;
+    portMUX_TYPE lock_;
+};
+
+#endif // DHT_RMT_H
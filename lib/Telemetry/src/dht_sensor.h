@@ -0,0 +1,45 @@
+#ifndef DHT_SENSOR_H
+#define DHT_SENSOR_H
+
+#include <Arduino.h>
+#include <DHT.h>
+#include <time.h>
+#include "reading.h"
+
+// Sensor policy: DHT11 / DHT22 on a fixed pin.
+// One bus transaction per read - Fahrenheit is derived from Celsius
+// instead of calling readTemperature(true) and re-triggering the sensor.
+// Blocks with interrupts off for the whole frame; see dht_rmt.h for the
+// non-blocking RMT version.
+template <uint8_t PIN, uint8_t TYPE>
+class DhtSensor
+{
+public:
+    DhtSensor() : dht_(PIN, TYPE) {}
+
+    void begin()
+    {
+        dht_.begin();
+    }
+
+    // Returns false (and leaves reading untouched) if the read failed
+    bool read(Reading& reading)
+    {
+        float humidity = dht_.readHumidity();
+        float tempC = dht_.readTemperature();
+        if (isnan(humidity) || isnan(tempC))
+        {
+            return false;
+        }
+        reading.timestamp = (uint32_t)time(nullptr);
+        reading.tempC = tempC;
+        reading.tempF = tempC * 1.8f + 32.0f;
+        reading.humidity = humidity;
+        return true;
+    }
+
+private:
+    DHT dht_;
+};
+
+#endif // DHT_SENSOR_H
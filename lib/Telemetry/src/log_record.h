@@ -0,0 +1,30 @@
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <stdint.h>
+
+// Packed wire record: timestamp (4) + id (1) + arg (4), little endian,
+// sent as hex. Decode with tools/log_decode.py.
+#define LOG_RECORD_SIZE 9
+#define LOG_RECORD_HEX (LOG_RECORD_SIZE * 2)
+
+// Writes the packed record as LOG_RECORD_HEX hex chars + terminator
+inline void encodeLogRecord(uint32_t timestamp, uint8_t id, int32_t arg, char* out)
+{
+    static const char digits[] = "0123456789abcdef";
+    uint8_t bytes[LOG_RECORD_SIZE];
+    for (int i = 0; i < 4; i++)
+    {
+        bytes[i] = (uint8_t)(timestamp >> (8 * i));
+        bytes[5 + i] = (uint8_t)((uint32_t)arg >> (8 * i));
+    }
+    bytes[4] = id;
+    for (int i = 0; i < LOG_RECORD_SIZE; i++)
+    {
+        out[2 * i] = digits[bytes[i] >> 4];
+        out[2 * i + 1] = digits[bytes[i] & 0x0F];
+    }
+    out[LOG_RECORD_HEX] = '\0';
+}
+
+#endif // LOG_RECORD_H
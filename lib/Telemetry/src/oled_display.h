@@ -0,0 +1,96 @@
+#ifndef OLED_DISPLAY_H
+#define OLED_DISPLAY_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <dirty_ssd1306.h>
+#include <oled_widgets.h>
+#include "reading.h"
+
+// Display policy: SSD1306 OLED with the layout the sketches share.
+// The reading screen's labels are drawn once; after that only the
+// values that changed are redrawn and sent.
+template <uint8_t WIDTH, uint8_t HEIGHT, uint8_t ADDRESS, int8_t RESET = -1>
+class OledDisplay
+{
+public:
+    OledDisplay() : oled_(WIDTH, HEIGHT, &Wire, RESET), readingShown_(false),
+                    temperature_(36, 16, WIDTH - 36, 2), humidity_(36, 40, WIDTH - 36, 2) {}
+
+    bool begin()
+    {
+        if (!oled_.begin(SSD1306_SWITCHCAPVCC, ADDRESS))
+        {
+            return false;
+        }
+        oled_.clearDisplay();
+        oled_.display();
+        oled_.setTextColor(SSD1306_WHITE);
+        return true;
+    }
+
+    void showMessage(const __FlashStringHelper* text)
+    {
+        readingShown_ = false;
+        oled_.clearDisplay();
+        oled_.setTextSize(1);
+        oled_.setCursor(0, 0);
+        oled_.println(text);
+        oled_.display();
+    }
+
+    void showError()
+    {
+        showMessage(F("Error reading sensor"));
+    }
+
+    void showReading(const Reading& reading)
+    {
+        bool changed = !readingShown_;
+        if (!readingShown_)
+        {
+            oled_.clearDisplay();
+            oled_.setTextSize(1);
+            oled_.setCursor(0, 0);
+            oled_.println(F("DHT Sensor Readings:"));
+            oled_.setTextSize(2);
+            oled_.setCursor(0, 16);
+            oled_.print(F("T: "));
+            oled_.setCursor(0, 40);
+            oled_.print(F("H: "));
+            temperature_.invalidate();
+            humidity_.invalidate();
+            readingShown_ = true;
+        }
+        changed |= temperature_.set(oled_, reading.tempC, 2, " C");
+        changed |= humidity_.set(oled_, reading.humidity, 2, "%");
+        if (changed)
+        {
+            oled_.display();
+        }
+    }
+
+    // For sketch-specific screens
+    DirtySSD1306& raw()
+    {
+        return oled_;
+    }
+
+private:
+    DirtySSD1306 oled_;
+    bool readingShown_;
+    TextWidget temperature_;
+    TextWidget humidity_;
+};
+
+// Display policy for headless builds; every call compiles away
+class NoDisplay
+{
+public:
+    bool begin() { return true; }
+    void showMessage(const __FlashStringHelper*) {}
+    void showError() {}
+    void showReading(const Reading&) {}
+};
+
+#endif // OLED_DISPLAY_H
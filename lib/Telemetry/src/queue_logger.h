@@ -0,0 +1,125 @@
+#ifndef QUEUE_LOGGER_H
+#define QUEUE_LOGGER_H
+
+#include <mutex>
+#include <stdint.h>
+#include <time.h>
+#include "log_record.h"
+
+#ifndef QUEUE_LOGGER_CAPACITY
+#define QUEUE_LOGGER_CAPACITY 32    // Records held before the oldest is dropped
+#endif
+
+// Mutex-guarded log queue of interned message IDs, in a fixed ring.
+// Id is the firmware's LogId enum (generated from its log_messages.h);
+// None is the ID reported when the queue is empty.
+//
+// Records can arrive faster than they are drained (a failing sensor logs
+// two per sample, the sink sends one), so once the ring is full the
+// oldest record is overwritten and counted in dropped(); memory stays
+// fixed however long the backlog lasts.
+template <typename Id, Id None>
+class QueueLogger
+{
+public:
+    // A few bytes per record instead of a copied message string
+    struct LogRecord
+    {
+        uint32_t timestamp;
+        Id id;
+        int32_t arg;                // Value for a %d in the message, if any
+    };
+
+    static QueueLogger& getInstance()
+    {
+        static QueueLogger instance;
+        return instance;
+    }
+
+    void log(Id id, int32_t arg = 0)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == QUEUE_LOGGER_CAPACITY)
+        {
+            head_ = (head_ + 1) % QUEUE_LOGGER_CAPACITY;
+            count_--;
+            dropped_++;
+        }
+        ring_[(head_ + count_) % QUEUE_LOGGER_CAPACITY] = {(uint32_t)time(nullptr), id, arg};
+        count_++;
+    }
+
+    // Retrieve and remove the oldest record
+    bool getLog(LogRecord& record)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_ == 0)
+        {
+            record = {(uint32_t)time(nullptr), None, 0};
+            return false;
+        }
+        record = ring_[head_];
+        head_ = (head_ + 1) % QUEUE_LOGGER_CAPACITY;
+        count_--;
+        return true;
+    }
+
+    // Records overwritten before they were drained
+    uint32_t dropped()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+
+    static void encode(const LogRecord& record, char* out)
+    {
+        encodeLogRecord(record.timestamp, record.id, record.arg, out);
+    }
+
+private:
+    QueueLogger() : head_(0), count_(0), dropped_(0) {}
+    QueueLogger(const QueueLogger&) = delete;
+    QueueLogger& operator=(const QueueLogger&) = delete;
+
+    LogRecord ring_[QUEUE_LOGGER_CAPACITY];
+    uint16_t head_;                 // Oldest record
+    uint16_t count_;
+    uint32_t dropped_;
+    std::mutex mutex_;
+};
+
+// Sink policy over a QueueLogger: logs the sensor failure IDs and hands
+// the transport the next packed record for its "Log" field.
+template <class Logger, typename Id, Id Failed, Id Error>
+class LogSink
+{
+public:
+    explicit LogSink(Logger& logger) : logger_(logger) {}
+
+    void sensorFailed()
+    {
+        logger_.log(Failed);
+        logger_.log(Error);
+    }
+
+    // Fills out with LOG_RECORD_HEX chars + terminator
+    void next(char* out)
+    {
+        typename Logger::LogRecord record;
+        logger_.getLog(record);
+        Logger::encode(record, out);
+    }
+
+private:
+    Logger& logger_;
+};
+
+// Sink policy that records nothing
+class NoSink
+{
+public:
+    void sensorFailed() {}
+    void next(char* out) { out[0] = '\0'; }
+};
+
+#endif // QUEUE_LOGGER_H
@@ -0,0 +1,15 @@
+#ifndef READING_H
+#define READING_H
+
+#include <stdint.h>
+
+// One sensor sample as passed between policies
+struct Reading
+{
+    uint32_t timestamp;             // Epoch seconds
+    float tempC;
+    float tempF;
+    float humidity;
+};
+
+#endif // READING_H
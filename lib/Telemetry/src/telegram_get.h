@@ -0,0 +1,57 @@
+#ifndef TELEGRAM_GET_H
+#define TELEGRAM_GET_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+#include "reading.h"
+
+// Transport policy: one synchronous Telegram sendMessage GET per reading.
+// base is the bot URL up to and including "&text=".
+class TelegramGet
+{
+public:
+    explicit TelegramGet(const char* base) : base_(base) {}
+
+    // Returns the HTTP status, or a negative HTTPClient error
+    int send(const Reading& reading, const char* log)
+    {
+        if (WiFi.status() != WL_CONNECTED)
+        {
+            Serial.println("WiFi not connected");
+            return -1;
+        }
+        // Local time as the logger prints it, with the space URL-encoded
+        char when[32];
+        time_t t = reading.timestamp;
+        struct tm tm;
+        localtime_r(&t, &tm);
+        strftime(when, sizeof(when), "%Y-%m-%d%%20%H:%M:%S", &tm);
+        String url = String(base_) + "*Timestamp: *" + when +
+                     "%0A*Temperature: *" + String(reading.tempC) +
+                     "%0A*Humidity: *" + String(reading.humidity) +
+                     "%0A*Log: *" + log + "&parse_mode=markdown";
+
+        HTTPClient http;
+        http.begin(url);
+        int httpResponseCode = http.GET();
+        if (httpResponseCode > 0)
+        {
+            http.getString();
+        }
+        http.end(); // Free resources
+        return httpResponseCode;
+    }
+
+private:
+    const char* base_;
+};
+
+// Transport policy for builds that only display / log locally
+class NoTransport
+{
+public:
+    int send(const Reading&, const char*) { return 0; }
+};
+
+#endif // TELEGRAM_GET_H
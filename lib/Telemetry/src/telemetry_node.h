@@ -0,0 +1,77 @@
+#ifndef TELEMETRY_NODE_H
+#define TELEMETRY_NODE_H
+
+#include <time.h>
+#include "reading.h"
+#include "log_record.h"
+
+// Composes one firmware's sample -> display -> upload path from policy
+// classes chosen at compile time:
+//
+//   Sensor:    void begin();  bool read(Reading&)
+//   Sink:      void sensorFailed();  void next(char* out)   (LOG_RECORD_HEX + 1)
+//   Transport: int send(const Reading&, const char* log)
+//   Display:   bool begin();  void showMessage(F(...));  void showError();
+//              void showReading(const Reading&)
+//
+// Everything is resolved statically - no virtual calls, and a policy a
+// firmware doesn't pick (OledDisplay, TelegramGet, ...) is never
+// included, so neither it nor the library behind it ends up in flash.
+// NoDisplay / NoSink / NoTransport compile to nothing.
+template <class Sensor, class Sink, class Transport, class Display>
+class TelemetryNode
+{
+public:
+    TelemetryNode(Sensor& sensor, Sink& sink, Transport& transport, Display& display)
+        : sensor_(sensor), sink_(sink), transport_(transport), display_(display), last_() {}
+
+    // Returns false if the display failed to start
+    bool begin()
+    {
+        sensor_.begin();
+        return display_.begin();
+    }
+
+    // Read, show and send one sample. A failed read is logged, shown and
+    // sent as zeros, as the sketches always did. Returns the read result.
+    bool sample()
+    {
+        Reading reading = {(uint32_t)time(nullptr), 0, 0, 0};
+        bool ok = sensor_.read(reading);
+        if (ok)
+        {
+            last_ = reading;
+            display_.showReading(reading);
+        }
+        else
+        {
+            sink_.sensorFailed();
+            display_.showError();
+        }
+
+        char log[LOG_RECORD_HEX + 1];
+        sink_.next(log);
+        transport_.send(reading, log);
+        return ok;
+    }
+
+    // Last good reading
+    const Reading& last() const
+    {
+        return last_;
+    }
+
+    Display& display()
+    {
+        return display_;
+    }
+
+private:
+    Sensor& sensor_;
+    Sink& sink_;
+    Transport& transport_;
+    Display& display_;
+    Reading last_;
+};
+
+#endif // TELEMETRY_NODE_H
@@ -0,0 +1,428 @@
+#ifndef WIFI_LINK_H
+#define WIFI_LINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+#include <string.h>
+
+#ifndef WIFI_LINK_FAST_TIMEOUT
+#define WIFI_LINK_FAST_TIMEOUT 3000     // ms to wait on the cached BSSID/channel
+#endif
+
+#ifndef WIFI_LINK_SCAN_TIMEOUT
+#define WIFI_LINK_SCAN_TIMEOUT 15000    // ms to wait on a full-scan connect
+#endif
+
+#ifndef WIFI_LINK_BACKOFF_MIN
+#define WIFI_LINK_BACKOFF_MIN 1000      // ms before the first retry
+#endif
+
+#ifndef WIFI_LINK_BACKOFF_MAX
+#define WIFI_LINK_BACKOFF_MAX 60000     // ms cap on the retry delay
+#endif
+
+#ifndef WIFI_LINK_MAX_SUBSCRIBERS
+#define WIFI_LINK_MAX_SUBSCRIBERS 4
+#endif
+
+#define WIFI_LINK_MAGIC 0x574C4E4BUL    // "WLNK"
+
+// Last good association. Kept in RTC memory so a deep-sleep wake skips
+// even the NVS read, and in NVS so a cold boot can use it too.
+struct WiFiLinkCache
+{
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t ip;                        // Last DHCP lease, for the optional static path
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+static RTC_DATA_ATTR WiFiLinkCache wifiLinkRtcCache;
+
+// Event-driven WiFi connection manager shared by the sketches.
+// begin() returns immediately; a small task owns the connection:
+//
+//   Fast   - associate straight to the cached BSSID on the cached channel
+//            (no scan), optionally with the cached IP (no DHCP)
+//   Scan   - plain WiFi.begin(), full scan + DHCP
+//   Backoff- wait, doubling from WIFI_LINK_BACKOFF_MIN up to _MAX, then Scan
+//   Up     - connected; a disconnect goes back to Fast
+//
+// WiFi driver events are forwarded to the task through a queue, so
+// nothing busy-waits on WiFi.status(). Subscribers are called from the
+// link task on every up/down change, and each connect's duration and
+// path are printed to Serial.
+class WiFiLink
+{
+public:
+    typedef void (*LinkCallback)(bool up);
+
+    enum State
+    {
+        Idle,
+        Fast,
+        Scan,
+        Backoff,
+        Up
+    };
+
+    struct Stats
+    {
+        uint32_t connects;
+        uint32_t fastConnects;          // Connects that used the cache
+        uint32_t fastMisses;            // Cache tried and fell back to a scan
+        uint32_t disconnects;
+        uint32_t lastConnectMs;         // Attempt start -> got IP
+        uint32_t bestFastMs;
+        uint32_t bestScanMs;
+    };
+
+    static WiFiLink& getInstance()
+    {
+        static WiFiLink instance;
+        return instance;
+    }
+
+    // staticIp: reuse the last DHCP lease on the fast path. Only safe if
+    // the router reserves that address for this device.
+    void begin(const char* ssid, const char* password, bool staticIp = false)
+    {
+        ssid_ = ssid;
+        password_ = password;
+        staticIp_ = staticIp;
+        if (task_ == nullptr)
+        {
+            events_ = xQueueCreate(8, sizeof(Event));
+            connected_ = xEventGroupCreate();
+            loadCache();
+            WiFi.persistent(false);     // We keep our own cache; don't rewrite flash on every begin
+            WiFi.setAutoReconnect(false);
+            WiFi.mode(WIFI_STA);
+            WiFi.onEvent(onWiFiEvent);
+            xTaskCreatePinnedToCore(run, "wifi_link", 4096, this, 2, &task_, 0);
+        }
+        post(EventStart);
+    }
+
+    // Disconnects and stops reconnecting until the next begin()
+    void end()
+    {
+        post(EventStop);
+    }
+
+    // Blocks the caller until connected or timeoutMs passes
+    bool waitConnected(uint32_t timeoutMs)
+    {
+        if (connected_ == nullptr)
+        {
+            return false;
+        }
+        return xEventGroupWaitBits(connected_, 1, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeoutMs)) & 1;
+    }
+
+    bool connected() const
+    {
+        return state_ == Up;
+    }
+
+    State state() const
+    {
+        return state_;
+    }
+
+    bool subscribe(LinkCallback callback)
+    {
+        if (subscriberCount_ == WIFI_LINK_MAX_SUBSCRIBERS)
+        {
+            return false;
+        }
+        subscribers_[subscriberCount_++] = callback;
+        return true;
+    }
+
+    const Stats& stats() const
+    {
+        return stats_;
+    }
+
+    // Forget the cached AP (e.g. after moving the device)
+    void clearCache()
+    {
+        memset(&cache_, 0, sizeof(cache_));
+        wifiLinkRtcCache = cache_;
+        Preferences prefs;
+        prefs.begin("wifi_link", false);
+        prefs.clear();
+        prefs.end();
+    }
+
+private:
+    enum Event
+    {
+        EventStart,
+        EventStop,
+        EventGotIp,
+        EventDisconnected
+    };
+
+    WiFiLink() : ssid_(nullptr), password_(nullptr), staticIp_(false), state_(Idle), attemptStart_(0),
+                 backoff_(WIFI_LINK_BACKOFF_MIN), subscriberCount_(0), events_(nullptr), connected_(nullptr),
+                 task_(nullptr), stats_() {}
+    WiFiLink(const WiFiLink&) = delete;
+    WiFiLink& operator=(const WiFiLink&) = delete;
+
+    void post(Event event)
+    {
+        if (events_ != nullptr)
+        {
+            xQueueSend(events_, &event, 0);
+        }
+    }
+
+    static void onWiFiEvent(arduino_event_id_t event, arduino_event_info_t info)
+    {
+        WiFiLink& self = getInstance();
+        if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP)
+        {
+            self.post(EventGotIp);
+        }
+        else if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED)
+        {
+            self.post(EventDisconnected);
+        }
+    }
+
+    static void run(void* arg)
+    {
+        WiFiLink* self = static_cast<WiFiLink*>(arg);
+        Event event;
+        for (;;)
+        {
+            uint32_t wait = self->timeout();
+            TickType_t ticks = wait == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(wait);
+            if (xQueueReceive(self->events_, &event, ticks) == pdTRUE)
+            {
+                self->handle(event);
+            }
+            else
+            {
+                self->expired();
+            }
+        }
+    }
+
+    // ms the current state may last before expired() runs, UINT32_MAX for ever
+    uint32_t timeout() const
+    {
+        uint32_t limit;
+        switch (state_)
+        {
+            case Fast: limit = WIFI_LINK_FAST_TIMEOUT; break;
+            case Scan: limit = WIFI_LINK_SCAN_TIMEOUT; break;
+            case Backoff: limit = backoff_; break;
+            default: return UINT32_MAX;
+        }
+        uint32_t elapsed = millis() - attemptStart_;
+        return elapsed >= limit ? 0 : limit - elapsed;
+    }
+
+    void handle(Event event)
+    {
+        switch (event)
+        {
+            case EventStart:
+                if (state_ == Idle)
+                {
+                    connect();
+                }
+                break;
+
+            case EventStop:
+                state_ = Idle;
+                WiFi.disconnect();
+                setUp(false);
+                break;
+
+            case EventGotIp:
+                if (state_ == Fast || state_ == Scan)
+                {
+                    connectedOk();
+                }
+                break;
+
+            case EventDisconnected:
+                if (state_ == Up)
+                {
+                    stats_.disconnects++;
+                    Serial.println("[wifi] link lost");
+                    setUp(false);
+                    connect();
+                }
+                else if (state_ == Fast)
+                {
+                    // Cached AP refused or gone - don't wait out the timeout
+                    fastMiss();
+                }
+                break;
+        }
+    }
+
+    void expired()
+    {
+        if (state_ == Fast)
+        {
+            fastMiss();
+        }
+        else if (state_ == Scan)
+        {
+            Serial.printf("[wifi] no connection after %lums, retrying in %lums\n",
+                          (unsigned long)(millis() - attemptStart_), (unsigned long)backoff_);
+            WiFi.disconnect();
+            state_ = Backoff;
+            attemptStart_ = millis();
+        }
+        else if (state_ == Backoff)
+        {
+            backoff_ = backoff_ * 2 > WIFI_LINK_BACKOFF_MAX ? WIFI_LINK_BACKOFF_MAX : backoff_ * 2;
+            scan();
+        }
+    }
+
+    void connect()
+    {
+        if (cache_.magic != WIFI_LINK_MAGIC)
+        {
+            scan();
+            return;
+        }
+        if (staticIp_ && cache_.ip != 0)
+        {
+            WiFi.config(IPAddress(cache_.ip), IPAddress(cache_.gateway), IPAddress(cache_.subnet), IPAddress(cache_.dns));
+        }
+        state_ = Fast;
+        attemptStart_ = millis();
+        WiFi.begin(ssid_, password_, cache_.channel, cache_.bssid);
+    }
+
+    void fastMiss()
+    {
+        stats_.fastMisses++;
+        Serial.printf("[wifi] cached AP failed after %lums, scanning\n", (unsigned long)(millis() - attemptStart_));
+        WiFi.disconnect();
+        scan();
+    }
+
+    void scan()
+    {
+        // Back to DHCP in case the cached lease is what failed
+        WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+        state_ = Scan;
+        attemptStart_ = millis();
+        WiFi.begin(ssid_, password_);
+    }
+
+    void connectedOk()
+    {
+        uint32_t took = millis() - attemptStart_;
+        bool fast = state_ == Fast;
+        stats_.connects++;
+        stats_.lastConnectMs = took;
+        if (fast)
+        {
+            stats_.fastConnects++;
+            if (stats_.bestFastMs == 0 || took < stats_.bestFastMs) stats_.bestFastMs = took;
+        }
+        else
+        {
+            if (stats_.bestScanMs == 0 || took < stats_.bestScanMs) stats_.bestScanMs = took;
+        }
+        Serial.printf("[wifi] connected in %lums (%s), ch %d, %s\n", (unsigned long)took,
+                      fast ? "cached" : "scan", WiFi.channel(), WiFi.localIP().toString().c_str());
+
+        state_ = Up;
+        backoff_ = WIFI_LINK_BACKOFF_MIN;
+        saveCache();
+        setUp(true);
+    }
+
+    void setUp(bool up)
+    {
+        bool was = xEventGroupGetBits(connected_) & 1;
+        if (up)
+        {
+            xEventGroupSetBits(connected_, 1);
+        }
+        else
+        {
+            xEventGroupClearBits(connected_, 1);
+        }
+        if (up != was)
+        {
+            for (uint8_t i = 0; i < subscriberCount_; i++)
+            {
+                subscribers_[i](up);
+            }
+        }
+    }
+
+    void loadCache()
+    {
+        if (wifiLinkRtcCache.magic == WIFI_LINK_MAGIC)
+        {
+            cache_ = wifiLinkRtcCache;
+            return;
+        }
+        Preferences prefs;
+        prefs.begin("wifi_link", true);
+        if (prefs.getBytes("cache", &cache_, sizeof(cache_)) != sizeof(cache_) || cache_.magic != WIFI_LINK_MAGIC)
+        {
+            memset(&cache_, 0, sizeof(cache_));
+        }
+        prefs.end();
+        wifiLinkRtcCache = cache_;
+    }
+
+    void saveCache()
+    {
+        WiFiLinkCache fresh;
+        memset(&fresh, 0, sizeof(fresh));
+        fresh.magic = WIFI_LINK_MAGIC;
+        memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+        fresh.channel = WiFi.channel();
+        fresh.ip = (uint32_t)WiFi.localIP();
+        fresh.gateway = (uint32_t)WiFi.gatewayIP();
+        fresh.subnet = (uint32_t)WiFi.subnetMask();
+        fresh.dns = (uint32_t)WiFi.dnsIP();
+        wifiLinkRtcCache = fresh;
+        // Only touch flash when the AP or lease actually changed
+        if (memcmp(&fresh, &cache_, sizeof(fresh)) != 0)
+        {
+            cache_ = fresh;
+            Preferences prefs;
+            prefs.begin("wifi_link", false);
+            prefs.putBytes("cache", &cache_, sizeof(cache_));
+            prefs.end();
+        }
+    }
+
+    const char* ssid_;
+    const char* password_;
+    bool staticIp_;
+    volatile State state_;
+    uint32_t attemptStart_;
+    uint32_t backoff_;
+    WiFiLinkCache cache_;
+    LinkCallback subscribers_[WIFI_LINK_MAX_SUBSCRIBERS];
+    uint8_t subscriberCount_;
+    QueueHandle_t events_;
+    EventGroupHandle_t connected_;
+    TaskHandle_t task_;
+    Stats stats_;
+};
+
+#endif // WIFI_LINK_H
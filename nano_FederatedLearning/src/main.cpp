@@ -2,6 +2,7 @@
 #include <WiFi.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include <wifi_link.h>
 
 
 
@@ -28,11 +29,10 @@ public:
 
     void connectWiFi()
     {
-      WiFi.begin(ssid, password);
+      WiFiLink::getInstance().begin(ssid, password);
       Serial.print("Connecting to WiFi");
-      while (WiFi.status() != WL_CONNECTED)
+      while (!WiFiLink::getInstance().waitConnected(500))
       {
-        delay(500);
         Serial.print(".");
       }
       Serial.println("\nWiFi connected.");
@@ -0,0 +1,62 @@
+from flask import Flask, jsonify, request
+import msgpack
+
+# Local stand-in for API_ENDPOINT that accepts the UMC's batched
+# MessagePack uploads (see UMC/src/ingest.h).
+#
+# usage: python tools/ingest_server.py
+#        then point API_ENDPOINT at http://<this host>:5000/ingest
+
+FORMAT_VERSIONS = (1, 2)     # 2 adds "db", centi-dBA
+TEMP_RANGE = (-4000, 8000)   # centi-degC, DHT11/22 limits
+HUMIDITY_RANGE = (0, 10000)  # centi-%RH
+
+app = Flask(__name__)
+totals = {"batches": 0, "samples": 0, "bytes": 0, "rejected": 0}
+
+def validate(batch):
+    """
+    Returns an error string, or None if the batch is well formed.
+    """
+    if not isinstance(batch, dict) or batch.get("v") not in FORMAT_VERSIONS:
+        return "unsupported version"
+    n = batch.get("n")
+    if not isinstance(n, int) or n <= 0:
+        return "bad count"
+    keys = ("dt", "c", "h", "db") if batch["v"] >= 2 else ("dt", "c", "h")
+    for key in keys:
+        if not isinstance(batch.get(key), list) or len(batch[key]) != n:
+            return "'%s' does not have %d values" % (key, n)
+    if any(not TEMP_RANGE[0] <= c <= TEMP_RANGE[1] for c in batch["c"]):
+        return "temperature out of range"
+    if any(not HUMIDITY_RANGE[0] <= h <= HUMIDITY_RANGE[1] for h in batch["h"]):
+        return "humidity out of range"
+    return None
+
+@app.route('/ingest', methods=['POST'])
+def ingest():
+    try:
+        batch = msgpack.unpackb(request.get_data(), raw=False)
+    except Exception:
+        batch = None
+    error = validate(batch)
+    if error:
+        totals["rejected"] += 1
+        return jsonify({"error": error}), 400
+
+    totals["batches"] += 1
+    totals["samples"] += batch["n"]
+    totals["bytes"] += request.content_length or 0
+    t0 = batch["t0"]
+    db = batch.get("db", [0] * batch["n"])
+    for dt, c, h, d in zip(batch["dt"], batch["c"], batch["h"], db):
+        print("%d  %.2f C  %.2f %%  %.1f dBA" % (t0 + dt, c / 100.0, h / 100.0, d / 100.0))
+    return jsonify({"accepted": batch["n"]})
+
+@app.route('/stats', methods=['GET'])
+def stats():
+    per_sample = totals["bytes"] / totals["samples"] if totals["samples"] else 0
+    return jsonify(dict(totals, bytes_per_sample=round(per_sample, 2)))
+
+if __name__ == '__main__':
+    app.run(host='0.0.0.0', port=5000)
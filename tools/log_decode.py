@@ -0,0 +1,49 @@
+import re
+import struct
+import sys
+from datetime import datetime
+
+# Decodes packed log records sent by the UMC / nanoUMC / Sample firmware.
+#
+# usage: python tools/log_decode.py <firmware>/src/log_messages.h <hex> [<hex> ...]
+#        (or pipe the hex in on stdin)
+#
+# Each record is 9 bytes (18 hex chars): timestamp u32, id u8, arg i32,
+# all little endian. Records may be concatenated, as in a batched
+# "*Log:*" message.
+
+RECORD_HEX = 18
+MESSAGE_PATTERN = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+
+def load_messages(header_path):
+    """
+    Returns the format strings from a log_messages.h, indexed by ID.
+    """
+    with open(header_path) as f:
+        return [fmt for _, fmt in MESSAGE_PATTERN.findall(f.read())]
+
+def decode(hex_text, messages):
+    """
+    Yields one decoded line per packed record in hex_text.
+    """
+    # Skip surrounding message text such as "*Log:*" or "(3 dropped)"
+    records = [run[i:i + RECORD_HEX]
+               for run in re.findall(r'[0-9a-fA-F]+', hex_text) if len(run) % RECORD_HEX == 0
+               for i in range(0, len(run), RECORD_HEX)]
+    for record in records:
+        timestamp, msg_id, arg = struct.unpack('<IBi', bytes.fromhex(record))
+        fmt = messages[msg_id] if msg_id < len(messages) else f'<unknown id {msg_id}>'
+        text = fmt.replace('%d', str(arg)) if '%d' in fmt else fmt
+        when = datetime.fromtimestamp(timestamp).strftime('%Y-%m-%d %H:%M:%S')
+        yield f'{when} {text}'
+
+if __name__ == '__main__':
+    if len(sys.argv) < 2:
+        print('usage: python tools/log_decode.py <log_messages.h> [hex ...]')
+        sys.exit(1)
+
+    messages = load_messages(sys.argv[1])
+    inputs = sys.argv[2:] or [sys.stdin.read()]
+    for hex_text in inputs:
+        for line in decode(hex_text, messages):
+            print(line)